@@ -0,0 +1,113 @@
+#include "bench_utils.hpp"
+
+#include <boost/optional.hpp>
+#include <boost/optional_ext.hpp>
+#include <boost/optional_ext/coroutine.hpp>
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if OPTIONAL_EXT_HAS_COROUTINES
+
+namespace {
+
+struct Order
+{
+    std::int64_t price;
+    std::int64_t qty;
+    std::int64_t total;
+};
+
+// every 8th price and every 16th quantity are missing
+boost::optional<std::int64_t> findPrice(std::size_t i)
+{
+    return boost::make_optional(i % 8 != 0, static_cast<std::int64_t>(i) * 3);
+}
+
+boost::optional<std::int64_t> findQty(std::size_t i, std::int64_t price)
+{
+    return boost::make_optional(i % 16 != 1, price % 100 + 1);
+}
+
+boost::optional<std::int64_t> checkLimit(std::int64_t price, std::int64_t qty)
+{
+    const auto total = price * qty;
+    return boost::make_optional(total < 1000000, total);
+}
+
+// the last stage needs the values of all previous ones, the pipe form has to nest lambdas
+boost::optional<Order> makePipe(std::size_t i)
+{
+    return findPrice(i) | [i](std::int64_t price) {
+        return findQty(i, price) | [price](std::int64_t qty) {
+            return checkLimit(price, qty) | [price, qty](std::int64_t total) { return Order{price, qty, total}; };
+        };
+    };
+}
+
+optional_ext::optional_coroutine<Order> makeCoroutine(std::size_t i)
+{
+    const auto price = co_await findPrice(i);
+    const auto qty = co_await findQty(i, price);
+    const auto total = co_await checkLimit(price, qty);
+    co_return Order{price, qty, total};
+}
+
+boost::optional<Order> makeIfElse(std::size_t i)
+{
+    const auto price = findPrice(i);
+    if (!price)
+    {
+        return boost::none;
+    }
+
+    const auto qty = findQty(i, *price);
+    if (!qty)
+    {
+        return boost::none;
+    }
+
+    const auto total = checkLimit(*price, *qty);
+    if (!total)
+    {
+        return boost::none;
+    }
+
+    return Order{*price, *qty, *total};
+}
+
+} // end namespace
+
+int main(int argc, char* argv[])
+{
+    const std::size_t ops = argc > 1 ? std::stoul(argv[1]) : 10000000;
+
+    bench::printHeader();
+
+    bench::print("dependent stages", "int64", "pipe", bench::measure(ops, [](std::size_t i) {
+        auto res = makePipe(i);
+        bench::doNotOptimize(res);
+    }));
+    bench::print("dependent stages", "int64", "coroutine", bench::measure(ops, [](std::size_t i) {
+        boost::optional<Order> res = makeCoroutine(i);
+        bench::doNotOptimize(res);
+    }));
+    bench::print("dependent stages", "int64", "if/else", bench::measure(ops, [](std::size_t i) {
+        auto res = makeIfElse(i);
+        bench::doNotOptimize(res);
+    }));
+
+    return 0;
+}
+
+#else
+
+int main()
+{
+    std::cout << "optional_coroutine requires C++20 coroutines" << std::endl;
+    return 0;
+}
+
+#endif // OPTIONAL_EXT_HAS_COROUTINES
@@ -0,0 +1,496 @@
+#include "bench_utils.hpp"
+
+#include <boost/optional.hpp>
+#include <boost/optional_ext.hpp>
+#include <boost/optional_ext/aggregate.hpp>
+#include <boost/optional_ext/any_pipeline.hpp>
+#include <boost/optional_ext/compact_optional.hpp>
+#include <boost/optional_ext/memoize.hpp>
+#include <boost/optional_ext/parse.hpp>
+#include <boost/optional_ext/runtime_pipeline.hpp>
+
+#include <boost/lexical_cast.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Large
+{
+    std::array<std::uint64_t, 64> data;
+};
+
+template <typename T>
+struct Payload;
+
+template <>
+struct Payload<int>
+{
+    static constexpr const char* name = "int";
+    static int make(std::size_t i) { return static_cast<int>(i); }
+    static std::size_t key(const int& value) { return static_cast<std::size_t>(value) * 2; }
+    static bool pred(const int& value) { return value % 3 != 0; }
+};
+
+template <>
+struct Payload<double>
+{
+    static constexpr const char* name = "double";
+    static double make(std::size_t i) { return static_cast<double>(i) * 0.5; }
+    static std::size_t key(const double& value) { return static_cast<std::size_t>(value * 4.0); }
+    static bool pred(const double& value) { return value < 200.0; }
+};
+
+template <>
+struct Payload<std::string>
+{
+    static constexpr const char* name = "string";
+    static std::string make(std::size_t i) { return "payload which doesn't fit SSO #" + std::to_string(i); }
+    static std::size_t key(const std::string& value) { return value.size() + static_cast<std::size_t>(value.back()); }
+    static bool pred(const std::string& value) { return value.back() != '3'; }
+};
+
+template <>
+struct Payload<Large>
+{
+    static constexpr const char* name = "large";
+    static Large make(std::size_t i)
+    {
+        Large ret;
+        ret.data.fill(i);
+        return ret;
+    }
+    static std::size_t key(const Large& value) { return value.data[0] + value.data[63]; }
+    static bool pred(const Large& value) { return value.data[7] % 3 != 0; }
+};
+
+// std::optional::and_then is available since C++23
+template <typename T, typename TFunctor>
+auto andThen(const std::optional<T>& op, TFunctor&& f)
+{
+#if defined(__cpp_lib_optional) && __cpp_lib_optional >= 202110L
+    return op.and_then(f);
+#else
+    return op ? f(*op) : decltype(f(*op))();
+#endif
+}
+
+template <typename T>
+void benchPayload(std::size_t ops)
+{
+    using P = Payload<T>;
+
+    // every 4th input is empty, the size is a power of two
+    std::vector<boost::optional<T>> inputs;
+    std::vector<std::optional<T>> stdInputs;
+    for (std::size_t i = 0; i < 1024; ++i)
+    {
+        inputs.push_back(boost::make_optional(i % 4 != 0, P::make(i)));
+        stdInputs.push_back(i % 4 != 0 ? std::optional<T>(P::make(i)) : std::nullopt);
+    }
+
+    auto at = [&inputs](std::size_t i) -> const boost::optional<T>& { return inputs[i & 1023]; };
+    auto stdAt = [&stdInputs](std::size_t i) -> const std::optional<T>& { return stdInputs[i & 1023]; };
+
+    auto key = [](const T& value) { return P::key(value); };
+    auto keyIf = [](const T& value) { return P::pred(value) ? boost::make_optional(P::key(value)) : boost::none; };
+    auto stdKeyIf = [](const T& value) { return P::pred(value) ? std::make_optional(P::key(value)) : std::nullopt; };
+    auto pred = [](const T& value) { return P::pred(value); };
+    auto fallback = []() { return std::size_t(0); };
+    std::size_t counter = 0;
+    auto some = [&counter](const T& value) { counter += P::key(value); };
+    auto none = [&counter]() { counter += 1; };
+
+    // map
+    bench::print("operator| map", P::name, "pipe", bench::measure(ops, [&](std::size_t i) {
+        auto res = at(i) | key;
+        bench::doNotOptimize(res);
+    }));
+    bench::print("operator| map", P::name, "if/else", bench::measure(ops, [&](std::size_t i) {
+        boost::optional<std::size_t> res;
+        if (const auto& op = at(i))
+        {
+            res = key(*op);
+        }
+        bench::doNotOptimize(res);
+    }));
+
+    // flat_map
+    bench::print("operator| flat_map", P::name, "pipe", bench::measure(ops, [&](std::size_t i) {
+        auto res = at(i) | keyIf;
+        bench::doNotOptimize(res);
+    }));
+    bench::print("operator| flat_map", P::name, "if/else", bench::measure(ops, [&](std::size_t i) {
+        boost::optional<std::size_t> res;
+        if (const auto& op = at(i))
+        {
+            res = keyIf(*op);
+        }
+        bench::doNotOptimize(res);
+    }));
+    bench::print("operator| flat_map", P::name, "std::and_then", bench::measure(ops, [&](std::size_t i) {
+        auto res = andThen(stdAt(i), stdKeyIf);
+        bench::doNotOptimize(res);
+    }));
+
+    // operator|=
+    bench::print("operator|=", P::name, "pipe", bench::measure(ops, [&](std::size_t i) {
+        auto res = at(i) | keyIf |= fallback;
+        bench::doNotOptimize(res);
+    }));
+    bench::print("operator|=", P::name, "if/else", bench::measure(ops, [&](std::size_t i) {
+        boost::optional<std::size_t> res;
+        if (const auto& op = at(i))
+        {
+            res = keyIf(*op);
+        }
+        if (!res)
+        {
+            res = fallback();
+        }
+        bench::doNotOptimize(res);
+    }));
+
+    // operator<<= with a value and with a function
+    bench::print("operator<<= value", P::name, "pipe", bench::measure(ops, [&](std::size_t i) {
+        auto res = at(i) | keyIf <<= std::size_t(0);
+        bench::doNotOptimize(res);
+    }));
+    bench::print("operator<<= value", P::name, "if/else", bench::measure(ops, [&](std::size_t i) {
+        std::size_t res = 0;
+        if (const auto& op = at(i))
+        {
+            if (P::pred(*op))
+            {
+                res = P::key(*op);
+            }
+        }
+        bench::doNotOptimize(res);
+    }));
+    bench::print("operator<<= value", P::name, "std::and_then", bench::measure(ops, [&](std::size_t i) {
+        auto res = andThen(stdAt(i), stdKeyIf).value_or(0);
+        bench::doNotOptimize(res);
+    }));
+    bench::print("operator<<= function", P::name, "pipe", bench::measure(ops, [&](std::size_t i) {
+        auto res = at(i) | keyIf <<= fallback;
+        bench::doNotOptimize(res);
+    }));
+    bench::print("operator<<= function", P::name, "if/else", bench::measure(ops, [&](std::size_t i) {
+        std::size_t res;
+        const auto& op = at(i);
+        if (op && P::pred(*op))
+        {
+            res = P::key(*op);
+        }
+        else
+        {
+            res = fallback();
+        }
+        bench::doNotOptimize(res);
+    }));
+
+    // toRefOp
+    bench::print("toRefOp", P::name, "pipe", bench::measure(ops, [&](std::size_t i) {
+        auto res = toRefOp(at(i)) | key;
+        bench::doNotOptimize(res);
+    }));
+
+    // hof::
+    bench::print("hof::filter_if", P::name, "pipe", bench::measure(ops, [&](std::size_t i) {
+        auto res = at(i) | hof::filter_if(pred);
+        bench::doNotOptimize(res);
+    }));
+    bench::print("hof::filter_if", P::name, "pipe toRefOp", bench::measure(ops, [&](std::size_t i) {
+        auto res = toRefOp(at(i)) | hof::filter_if(pred);
+        bench::doNotOptimize(res);
+    }));
+    bench::print("hof::filter_if", P::name, "if/else", bench::measure(ops, [&](std::size_t i) {
+        boost::optional<T> res;
+        const auto& op = at(i);
+        if (op && P::pred(*op))
+        {
+            res = op;
+        }
+        bench::doNotOptimize(res);
+    }));
+    bench::print("hof::filter_if_not", P::name, "pipe", bench::measure(ops, [&](std::size_t i) {
+        auto res = at(i) | hof::filter_if_not(pred);
+        bench::doNotOptimize(res);
+    }));
+    bench::print("hof::filter_if_not", P::name, "if/else", bench::measure(ops, [&](std::size_t i) {
+        boost::optional<T> res;
+        const auto& op = at(i);
+        if (op && !P::pred(*op))
+        {
+            res = op;
+        }
+        bench::doNotOptimize(res);
+    }));
+    bench::print("hof::match", P::name, "pipe", bench::measure(ops, [&](std::size_t i) {
+        auto&& res = at(i) | hof::match(some, none);
+        bench::doNotOptimize(res);
+    }));
+    bench::print("hof::match", P::name, "if/else", bench::measure(ops, [&](std::size_t i) {
+        const auto& op = at(i);
+        if (op)
+        {
+            some(*op);
+        }
+        else
+        {
+            none();
+        }
+        bench::doNotOptimize(op);
+    }));
+    bench::print("hof::match_some", P::name, "pipe", bench::measure(ops, [&](std::size_t i) {
+        auto&& res = at(i) | hof::match_some(some);
+        bench::doNotOptimize(res);
+    }));
+    bench::print("hof::match_some", P::name, "if/else", bench::measure(ops, [&](std::size_t i) {
+        const auto& op = at(i);
+        if (op)
+        {
+            some(*op);
+        }
+        bench::doNotOptimize(op);
+    }));
+    bench::print("hof::match_none", P::name, "pipe", bench::measure(ops, [&](std::size_t i) {
+        auto&& res = at(i) | hof::match_none(none);
+        bench::doNotOptimize(res);
+    }));
+    bench::print("hof::match_none", P::name, "if/else", bench::measure(ops, [&](std::size_t i) {
+        const auto& op = at(i);
+        if (!op)
+        {
+            none();
+        }
+        bench::doNotOptimize(op);
+    }));
+
+    // the whole chain as operator| and as a prebuilt hof::pipeline
+    auto pipeline = hof::pipeline(hof::filter_if(pred), hof::match(some, none), keyIf) <<= std::size_t(0);
+    bench::print("chain", P::name, "pipe", bench::measure(ops, [&](std::size_t i) {
+        auto res = toRefOp(at(i)) | hof::filter_if(pred) | hof::match(some, none) | keyIf <<= std::size_t(0);
+        bench::doNotOptimize(res);
+    }));
+    bench::print("chain", P::name, "hof::pipeline", bench::measure(ops, [&](std::size_t i) {
+        auto res = pipeline(at(i));
+        bench::doNotOptimize(res);
+    }));
+    bench::print("chain", P::name, "if/else", bench::measure(ops, [&](std::size_t i) {
+        std::size_t res = 0;
+        const auto& op = at(i);
+        if (op && P::pred(*op))
+        {
+            some(*op);
+            if (P::pred(*op))
+            {
+                res = P::key(*op);
+            }
+        }
+        else
+        {
+            none();
+        }
+        bench::doNotOptimize(res);
+    }));
+
+    bench::doNotOptimize(counter);
+}
+
+// every 5th input isn't a number like in the example feed
+void benchParse(std::size_t ops)
+{
+    std::vector<std::string> inputs;
+    for (std::size_t i = 0; i < 1024; ++i)
+    {
+        inputs.push_back(i % 5 == 0 ? std::string("an error") : boost::lexical_cast<std::string>(static_cast<double>(i) * 0.37 - 100.0));
+    }
+
+    auto at = [&inputs](std::size_t i) -> const std::string& { return inputs[i & 1023]; };
+    auto lexicalCast = [](const std::string& value) -> boost::optional<double> {
+        try
+        {
+            return boost::lexical_cast<double>(value);
+        }
+        catch (const boost::bad_lexical_cast&)
+        {
+            return boost::none;
+        }
+    };
+    const auto parse = hof::parse<double>();
+
+    bench::print("parse 20% errors", "double", "lexical_cast", bench::measure(ops, [&](std::size_t i) {
+        auto res = boost::optional<const std::string&>(at(i)) | lexicalCast;
+        bench::doNotOptimize(res);
+    }));
+    bench::print("parse 20% errors", "double", "hof::parse", bench::measure(ops, [&](std::size_t i) {
+        auto res = boost::optional<const std::string&>(at(i)) | parse;
+        bench::doNotOptimize(res);
+    }));
+
+    // the inputs repeat, so every lookup but the first 1024 is a hit
+    auto memoLexicalCast = hof::memoize(lexicalCast, inputs.size());
+    auto memoParse = hof::memoize(parse, inputs.size());
+    bench::print("parse 20% errors", "double", "memo lexical_cast", bench::measure(ops, [&](std::size_t i) {
+        auto res = boost::optional<const std::string&>(at(i)) | memoLexicalCast;
+        bench::doNotOptimize(res);
+    }));
+    bench::print("parse 20% errors", "double", "memo hof::parse", bench::measure(ops, [&](std::size_t i) {
+        auto res = boost::optional<const std::string&>(at(i)) | memoParse;
+        bench::doNotOptimize(res);
+    }));
+}
+
+void benchSinks(std::size_t ops)
+{
+    // the outcome is random, so a branch on it is mispredicted every other time
+    std::vector<boost::optional<double>> inputs;
+    std::uint64_t state = 42;
+    for (std::size_t i = 0; i < (1 << 16); ++i)
+    {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        inputs.push_back((state >> 33) % 2 == 0 ? boost::make_optional(static_cast<double>(i)) : boost::none);
+    }
+
+    auto at = [&inputs](std::size_t i) -> const boost::optional<double>& { return inputs[i & 0xffff]; };
+
+    double acc = 0.0;
+    std::uint64_t errors = 0;
+    bench::print("sum and count none", "double", "hand-written", bench::measure(ops, [&](std::size_t i) {
+        acc += at(i) | hof::match_none([&errors]() { errors += 1; }) <<= 0.0;
+        bench::doNotOptimize(acc);
+    }));
+    bench::print("sum and count none", "double", "sinks", bench::measure(ops, [&](std::size_t i) {
+        at(i) | hof::count_none_into(errors) | hof::sum_into(acc);
+        bench::doNotOptimize(acc);
+    }));
+
+    optional_ext::kahan_sum_aggregate<double> kahan;
+    bench::print("sum and count none", "double", "kahan sink", bench::measure(ops, [&](std::size_t i) {
+        at(i) | hof::sum_into(kahan);
+        bench::doNotOptimize(kahan);
+    }));
+    bench::doNotOptimize(errors);
+}
+
+// the same fused chain called directly, through std::function and through any_pipeline
+void benchTypeErasure(std::size_t ops)
+{
+    std::vector<boost::optional<int>> inputs;
+    for (std::size_t i = 0; i < 1024; ++i)
+    {
+        inputs.push_back(i % 5 == 0 ? boost::optional<int>() : boost::make_optional(static_cast<int>(i)));
+    }
+
+    auto at = [&inputs](std::size_t i) -> const boost::optional<int>& { return inputs[i & 1023]; };
+
+    std::uint64_t errors = 0;
+    std::uint64_t rejected = 0;
+    const int limit = 700;
+    auto pipeline = hof::pipeline(hof::match_none([&errors]() { ++errors; }),
+                                  hof::filter_if([&limit](int el) { return el < limit; }),
+                                  hof::match(Payload<int>::key, [&rejected]() { ++rejected; }),
+                                  [&limit](int el) { return el * 2 + limit; })
+                    <<= 0;
+
+    std::function<int(const boost::optional<int>&)> function = pipeline;
+    optional_ext::any_pipeline<const boost::optional<int>&, int> erased = pipeline;
+
+    bench::print("type erasure", "int", "direct", bench::measure(ops, [&](std::size_t i) {
+        auto res = pipeline(at(i));
+        bench::doNotOptimize(res);
+    }));
+    bench::print("type erasure", "int", "std::function", bench::measure(ops, [&](std::size_t i) {
+        auto res = function(at(i));
+        bench::doNotOptimize(res);
+    }));
+    bench::print("type erasure", "int", "any_pipeline", bench::measure(ops, [&](std::size_t i) {
+        auto res = erased(at(i));
+        bench::doNotOptimize(res);
+    }));
+    bench::doNotOptimize(errors);
+    bench::doNotOptimize(rejected);
+}
+
+// the same chain written in C++ and compiled from a description at runtime
+void benchRuntime(std::size_t ops)
+{
+    std::vector<boost::optional<double>> inputs;
+    for (std::size_t i = 0; i < 1024; ++i)
+    {
+        inputs.push_back(i % 5 == 0 ? boost::optional<double>() : boost::make_optional(static_cast<double>(i) * 0.37 - 100.0));
+    }
+
+    auto at = [&inputs](std::size_t i) -> const boost::optional<double>& { return inputs[i & 1023]; };
+
+    const char* description = "filter_if(>= 0) | filter_if(<= 50) | map(* 2) |= 0 | map(clamp 1 90) <<= -1";
+    auto compiled = hof::pipeline(hof::filter_if([](double el) { return el >= 0.0; }),
+                                  hof::filter_if([](double el) { return el <= 50.0; }),
+                                  [](double el) { return el * 2.0; });
+    auto clamp = [](double el) { return std::clamp(el, 1.0, 90.0); };
+
+    bench::print("runtime pipeline", "double", "compile", bench::measure(ops / 100, [&](std::size_t) {
+        auto pipeline = optional_ext::compile_pipeline<double>(description);
+        bench::doNotOptimize(pipeline);
+    }));
+
+    const auto runtime = optional_ext::compile_pipeline<double>(description);
+    bench::print("runtime pipeline", "double", "operator|", bench::measure(ops, [&](std::size_t i) {
+        auto res = (compiled(at(i)) |= []() { return 0.0; }) | clamp <<= -1.0;
+        bench::doNotOptimize(res);
+    }));
+    bench::print("runtime pipeline", "double", "stage table", bench::measure(ops, [&](std::size_t i) {
+        auto res = runtime(at(i));
+        bench::doNotOptimize(res);
+    }));
+}
+
+// a chain over an array of optionals larger than the caches, boost::optional<double> is twice the size of compact_optional<double>
+template <typename TOptional>
+void benchDenseArray(std::size_t ops, const char* variant)
+{
+    std::vector<TOptional> inputs(std::size_t(1) << 23);
+    for (std::size_t i = 0; i < inputs.size(); ++i)
+    {
+        if (i % 5 != 0)
+        {
+            inputs[i] = static_cast<double>(i % 1000) * 0.1;
+        }
+    }
+
+    auto pipeline = hof::pipeline(hof::filter_if([](double el) { return el <= 50.0; }), [](double el) { return el * 2.0; }) <<= 0.0;
+
+    bench::print("dense array", "double", variant, bench::measure(ops, [&](std::size_t i) {
+        auto res = pipeline(inputs[i & (inputs.size() - 1)]);
+        bench::doNotOptimize(res);
+    }));
+}
+
+} // end namespace
+
+int main(int argc, char* argv[])
+{
+    const std::size_t ops = argc > 1 ? std::stoul(argv[1]) : 10000000;
+
+    bench::printHeader();
+
+    benchPayload<int>(ops);
+    benchPayload<double>(ops);
+    benchPayload<std::string>(ops);
+    benchPayload<Large>(ops / 10);
+    benchParse(ops / 10);
+    benchSinks(ops);
+    benchTypeErasure(ops);
+    benchRuntime(ops);
+    benchDenseArray<boost::optional<double>>(ops, "boost::optional");
+    benchDenseArray<optional_ext::compact_optional<double>>(ops, "compact_optional");
+
+    return 0;
+}
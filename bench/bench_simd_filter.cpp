@@ -0,0 +1,117 @@
+#include "bench_utils.hpp"
+
+#include <boost/optional.hpp>
+#include <boost/optional_ext.hpp>
+#include <boost/optional_ext/optional_batch.hpp>
+#include <boost/optional_ext/simd_filter.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char* toString(optional_ext::simd_level level)
+{
+    switch (level)
+    {
+    case optional_ext::simd_level::scalar:
+        return "scalar";
+    case optional_ext::simd_level::sse2:
+        return "sse2";
+    case optional_ext::simd_level::avx2:
+        return "avx2";
+    case optional_ext::simd_level::avx512:
+        return "avx512";
+    }
+
+    return "unknown";
+}
+
+template <typename T>
+std::vector<T> makeValues(std::size_t size)
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> dist(-100.0, 100.0);
+
+    std::vector<T> values(size);
+    for (auto& el : values)
+    {
+        el = static_cast<T>(dist(rng));
+    }
+
+    return values;
+}
+
+template <typename TFunctor>
+double nsPerElement(std::size_t size, std::size_t repeats, TFunctor&& fn)
+{
+    fn();
+
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < repeats; ++i)
+    {
+        fn();
+    }
+    const auto stop = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(stop - start).count() / static_cast<double>(size * repeats);
+}
+
+template <typename T>
+void benchType(const std::string& name, const optional_ext::range_predicate<T>& pred)
+{
+    constexpr std::size_t size = 1 << 16;
+    constexpr std::size_t repeats = 2000;
+
+    const auto values = makeValues<T>(size);
+    std::vector<std::uint64_t> mask((size + 63) / 64);
+    std::uint64_t checksum = 0;
+
+    for (auto level : {optional_ext::simd_level::scalar, optional_ext::simd_level::sse2, optional_ext::simd_level::avx2, optional_ext::simd_level::avx512})
+    {
+        if (level > optional_ext::active_simd_level())
+        {
+            continue;
+        }
+
+        const auto ns = nsPerElement(size, repeats, [&] {
+            std::fill(mask.begin(), mask.end(), ~std::uint64_t(0));
+            optional_ext::filter_mask(pred, values.data(), values.size(), mask.data(), level);
+            checksum += mask[0];
+        });
+
+        std::cout << std::setw(10) << name << std::setw(10) << toString(level) << std::setw(12) << std::fixed << std::setprecision(3) << ns << " ns/el"
+                  << std::endl;
+    }
+
+    // the same filter through the pipe operator, one boost::optional at a time
+    const auto ns = nsPerElement(size, repeats, [&] {
+        for (const auto& el : values)
+        {
+            checksum += (boost::make_optional(el) | hof::filter_if(pred)).has_value();
+        }
+    });
+    std::cout << std::setw(10) << name << std::setw(10) << "optional" << std::setw(12) << ns << " ns/el" << std::endl;
+
+    bench::doNotOptimize(checksum);
+}
+
+} // end namespace
+
+int main()
+{
+    std::cout << "active SIMD level: " << toString(optional_ext::active_simd_level()) << std::endl;
+
+    benchType("double", optional_ext::between(0.0, 50.0));
+    benchType("float", optional_ext::between(0.0f, 50.0f));
+    benchType("int32", optional_ext::between(std::int32_t(0), std::int32_t(50)));
+    benchType("int64", optional_ext::between(std::int64_t(0), std::int64_t(50)));
+
+    return 0;
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace bench {
+
+/**
+ * It prevents the compiler from optimizing away the computation of the value
+ */
+template <typename T>
+inline void doNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+/**
+ * It counts retired user-space instructions of the current thread with perf_event_open
+ * It isn't available on other platforms or when perf events are forbidden (e.g. in containers).
+ */
+class InstructionCounter
+{
+public:
+    InstructionCounter()
+    {
+#if defined(__linux__)
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        m_fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+
+    ~InstructionCounter()
+    {
+#if defined(__linux__)
+        if (m_fd >= 0)
+        {
+            close(m_fd);
+        }
+#endif
+    }
+
+    InstructionCounter(const InstructionCounter&) = delete;
+    InstructionCounter& operator=(const InstructionCounter&) = delete;
+
+    bool isAvailable() const noexcept
+    {
+        return m_fd >= 0;
+    }
+
+    void start() noexcept
+    {
+#if defined(__linux__)
+        if (m_fd >= 0)
+        {
+            ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    std::uint64_t stop() noexcept
+    {
+        std::uint64_t count = 0;
+#if defined(__linux__)
+        if (m_fd >= 0)
+        {
+            ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(m_fd, &count, sizeof(count)) != sizeof(count))
+            {
+                count = 0;
+            }
+        }
+#endif
+        return count;
+    }
+
+private:
+    int m_fd = -1;
+};
+
+struct Result
+{
+    double nsPerOp = 0.0;
+    double instructionsPerOp = 0.0;
+    bool hasInstructions = false;
+};
+
+/**
+ * It calls fn(i) for i in [0, ops) after a warm-up and returns the average cost of a call
+ */
+template <typename TFunctor>
+Result measure(std::size_t ops, TFunctor&& fn)
+{
+    for (std::size_t i = 0; i < ops / 10; ++i)
+    {
+        fn(i);
+    }
+
+    static InstructionCounter counter;
+
+    counter.start();
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < ops; ++i)
+    {
+        fn(i);
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    const auto instructions = counter.stop();
+
+    Result ret;
+    ret.nsPerOp = std::chrono::duration<double, std::nano>(stop - start).count() / static_cast<double>(ops);
+    ret.instructionsPerOp = static_cast<double>(instructions) / static_cast<double>(ops);
+    ret.hasInstructions = counter.isAvailable();
+    return ret;
+}
+
+inline void printHeader()
+{
+    std::cout << std::left << std::setw(28) << "case" << std::setw(10) << "payload" << std::setw(16) << "variant" << std::right << std::setw(12)
+              << "ns/op" << std::setw(12) << "instr/op" << std::endl;
+}
+
+inline void print(const std::string& name, const std::string& payload, const std::string& variant, const Result& result)
+{
+    std::cout << std::left << std::setw(28) << name << std::setw(10) << payload << std::setw(16) << variant << std::right << std::setw(12) << std::fixed
+              << std::setprecision(2) << result.nsPerOp << std::setw(12);
+
+    if (result.hasInstructions)
+    {
+        std::cout << result.instructionsPerOp;
+    }
+    else
+    {
+        std::cout << "n/a";
+    }
+
+    std::cout << std::endl;
+}
+
+} // namespace bench
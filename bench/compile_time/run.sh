@@ -0,0 +1,25 @@
+#!/bin/bash
+# It measures the front-end cost (time and memory) of the synthetic translation unit
+# for a growing number of distinct pipelines.
+#
+#   bench/compile_time/run.sh [compiler] [include dirs...]
+
+set -e
+
+COMPILER=${1:-g++}
+shift || true
+
+SRC="$(cd "$(dirname "$0")" && pwd)/synthetic_pipelines.cpp"
+INCLUDES="-I$(cd "$(dirname "$0")/../.." && pwd)"
+for dir in "$@"; do
+    INCLUDES="$INCLUDES -I$dir"
+done
+
+printf "%-12s%12s%12s\n" "pipelines" "seconds" "memory"
+for n in 50 100 200 400; do
+    report=$("$COMPILER" -std=c++17 -fsyntax-only -ftime-report $INCLUDES -DOPTIONAL_EXT_BENCH_PIPELINES=$n "$SRC" 2>&1)
+    total=$(echo "$report" | grep "TOTAL" | tail -1)
+    seconds=$(echo "$total" | awk -F: '{ split($2, t, " "); print t[3] }')
+    memory=$(echo "$total" | awk '{ print $NF }')
+    printf "%-12s%12s%12s\n" "$n" "$seconds" "$memory"
+done
@@ -0,0 +1,42 @@
+#include <boost/optional.hpp>
+#include <boost/optional_ext.hpp>
+
+#include <utility>
+
+#ifndef OPTIONAL_EXT_BENCH_PIPELINES
+#define OPTIONAL_EXT_BENCH_PIPELINES 100
+#endif
+
+/**
+ * Every pipeline works with its own types, so each one instantiates the operators anew
+ * as the distinct pipelines of a real translation unit do.
+ */
+template <int I>
+struct Value
+{
+    int value;
+};
+
+template <int I>
+int pipeline(const boost::optional<Value<I>>& op)
+{
+    auto filtered = op
+        | [](const Value<I>& el) { return Value<I + 1>{el.value + 1}; }
+        | [](const Value<I + 1>& el) { return boost::make_optional(el.value > 0, el); }
+        | hof::filter_if([](const Value<I + 1>& el) { return el.value % 2 == 0; })
+        | hof::match_some([](const Value<I + 1>&) {})
+        |= []() { return Value<I + 1>{0}; };
+
+    return filtered | [](const Value<I + 1>& el) { return el.value; } <<= 0;
+}
+
+template <int... Is>
+int run(std::integer_sequence<int, Is...>)
+{
+    return (pipeline<Is>(Value<Is>{Is}) + ...);
+}
+
+int main()
+{
+    return run(std::make_integer_sequence<int, OPTIONAL_EXT_BENCH_PIPELINES>()) == 0 ? 0 : 1;
+}
@@ -1,10 +1,39 @@
 #pragma once
 
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <tuple>
 #include <type_traits>
 #include <boost/type_traits.hpp>
 #include <boost/optional.hpp>
 #include <boost/utility.hpp>
+#include <boost/optional_ext/optional_traits.hpp>
 
+/**
+ * OPTIONAL_EXT_INSTRUMENTATION=1 enables the per-stage counters of boost/optional_ext/instrumentation.hpp
+ * When it's 0 (the default) the probes below expand to nothing and the operators are compiled as without them.
+ * OPTIONAL_EXT_TRACING=1 (boost/optional_ext/tracing.hpp) enables the instrumentation unless it's defined explicitly.
+ */
+#ifndef OPTIONAL_EXT_TRACING
+#define OPTIONAL_EXT_TRACING 0
+#endif
+
+#ifndef OPTIONAL_EXT_INSTRUMENTATION
+#define OPTIONAL_EXT_INSTRUMENTATION OPTIONAL_EXT_TRACING
+#endif
+
+#if OPTIONAL_EXT_INSTRUMENTATION
+#include <boost/optional_ext/instrumentation.hpp>
+#define OPTIONAL_EXT_PROBE(kind, TStage) optional_detail::TStageProbe<kind, std::decay_t<TStage>> optionalExtProbe
+#define OPTIONAL_EXT_PROBE_OUTCOME(isSome) optionalExtProbe.outcome(isSome)
+#define OPTIONAL_EXT_PROBED(...) optionalExtProbe.finish(__VA_ARGS__)
+#else
+#define OPTIONAL_EXT_PROBE(kind, TStage)
+#define OPTIONAL_EXT_PROBE_OUTCOME(isSome)
+#define OPTIONAL_EXT_PROBED(...) __VA_ARGS__
+#endif
 
 namespace type_traits {
 
@@ -49,66 +78,247 @@ using argument_type_t = std::conditional_t<type_traits::is_callable<Arg>::value
 namespace optional_detail {
 
 template <typename T>
-struct optional_value_type
+using optional_traits_t = optional_ext::optional_traits<std::remove_cv_t<std::remove_reference_t<T>>>;
+
+/**
+ * It's true for any optional-like type adapted by optional_ext::optional_traits (boost::optional, std::optional, pointers, ...)
+ */
+template <typename T>
+struct is_optional_type : public std::integral_constant<bool, optional_traits_t<T>::is_optional>
 {
-    using type = T;
 };
 
+/**
+ * It's true if a function which returns T is a "flat_map" function
+ * A returned pointer is a value of a "map" function, so a stage returning const char* or T* works as before.
+ */
 template <typename T>
-struct optional_value_type<boost::optional<T>>
+struct is_flat_map_result : public std::integral_constant<bool, optional_traits_t<T>::is_optional && !optional_traits_t<T>::is_pointer>
 {
-    using type = typename boost::optional<T>::value_type;
 };
 
-template <typename T>
-struct optional_value_type<const boost::optional<T>>
+template <typename TOptional>
+constexpr bool hasValue(const TOptional& op) noexcept
+{
+    return optional_traits_t<TOptional>::has_value(op);
+}
+
+template <typename TOptional>
+constexpr decltype(auto) getValue(TOptional&& op) noexcept
+{
+    return optional_traits_t<TOptional>::value(std::forward<TOptional>(op));
+}
+
+/**
+ * It's true for an optional-like type which carries an error instead of being empty (e.g. optional_ext::expected),
+ * its optional_traits provide error_type, error(op) and make_error(error)
+ */
+template <typename T, typename = void>
+struct is_error_carrying : public std::false_type
 {
-    using type = const typename boost::optional<T>::value_type;
 };
 
 template <typename T>
-struct optional_value_type<const boost::optional<T>&>
+struct is_error_carrying<T, std::void_t<typename optional_traits_t<T>::error_type>> : public std::true_type
 {
-    using type = typename boost::optional<T>::reference_const_type;
 };
 
-template <typename T>
-struct optional_value_type<boost::optional<T>&>
+template <typename TOptional>
+constexpr decltype(auto) getError(const TOptional& op) noexcept
+{
+    return optional_traits_t<TOptional>::error(op);
+}
+
+/**
+ * It creates an empty TResult, an error-carrying one holds the value-initialized error which stands for "no value"
+ */
+template <typename TResult>
+constexpr TResult makeNone()
+{
+    if constexpr (is_error_carrying<TResult>::value)
+    {
+        return optional_traits_t<TResult>::make_error(typename optional_traits_t<TResult>::error_type{});
+    }
+    else
+    {
+        return TResult();
+    }
+}
+
+/**
+ * It creates an empty TResult for the empty source, the error of an error-carrying source is passed on
+ */
+template <typename TResult, typename TSource>
+constexpr TResult makeNone(const TSource& source)
+{
+    if constexpr (is_error_carrying<TResult>::value && is_error_carrying<TSource>::value)
+    {
+        using TError = typename optional_traits_t<TResult>::error_type;
+        static_assert(std::is_convertible<decltype(getError(source)), TError>::value, "the error of a chain has to be convertible to the error of the next stage");
+
+        return hasValue(source) ? makeNone<TResult>() : optional_traits_t<TResult>::make_error(getError(source));
+    }
+    else
+    {
+        return makeNone<TResult>();
+    }
+}
+
+template <typename TFunctor, typename TOptional, typename = void>
+struct is_error_handler : public std::false_type
 {
-    using type = typename boost::optional<T>::reference_type;
 };
 
-template <typename T>
-struct is_optional_type : public boost::false_type
+template <typename TFunctor, typename TOptional>
+struct is_error_handler<TFunctor, TOptional, std::enable_if_t<is_error_carrying<TOptional>::value>>
+    : public std::is_invocable<TFunctor&, decltype(getError(std::declval<const TOptional&>()))>
 {
 };
 
-template <typename T>
-struct is_optional_type<boost::optional<T>> : public boost::true_type
+/**
+ * It calls the none handler of an empty op: f(error) if op carries an error f takes, f() otherwise
+ */
+template <typename TFunctor, typename TOptional>
+constexpr decltype(auto) callNone(TFunctor& f, const TOptional& op)
+{
+    if constexpr (is_error_handler<TFunctor, TOptional>::value)
+    {
+        return f(getError(op));
+    }
+    else
+    {
+        return f();
+    }
+}
+
+template <typename TFunctor, typename TOptional>
+using none_result_t = decltype(callNone(std::declval<TFunctor&>(), std::declval<const TOptional&>()));
+
+template <typename TFunctor, typename TOptional>
+constexpr bool is_nothrow_none() noexcept
+{
+    if constexpr (is_error_handler<TFunctor, TOptional>::value)
+    {
+        return noexcept(std::declval<TFunctor&>()(getError(std::declval<const TOptional&>())));
+    }
+    else
+    {
+        return noexcept(std::declval<TFunctor&>()());
+    }
+}
+
+/**
+ * It creates an engaged optional TResult, a pointer (see optional_traits::rebind) refers to the value
+ */
+template <typename TResult, typename TValue>
+constexpr TResult makeOptional(TValue&& value)
+{
+    if constexpr (std::is_pointer<TResult>::value)
+    {
+        return std::addressof(value);
+    }
+    else
+    {
+        return TResult(std::forward<TValue>(value));
+    }
+}
+
+/**
+ * It's a deferred call of a map function
+ * The optional converts it to the value right in its storage, so the result is neither copied nor moved (C++17 guaranteed copy elision).
+ */
+template <typename TFunctor, typename... TValue>
+struct TDeferredCall;
+
+template <typename TFunctor, typename TValue>
+struct TDeferredCall<TFunctor, TValue>
 {
+    using result_type = decltype(std::declval<TFunctor&>()(std::declval<TValue>()));
+
+    TFunctor& f;
+    TValue&& value;
+
+    operator result_type() &&
+    {
+        return f(std::forward<TValue>(value));
+    }
 };
 
-template <typename T>
-struct is_optional_type<const boost::optional<T>&> : public boost::true_type
+template <typename TFunctor>
+struct TDeferredCall<TFunctor>
 {
+    using result_type = decltype(std::declval<TFunctor&>()());
+
+    TFunctor& f;
+
+    operator result_type() &&
+    {
+        return f();
+    }
 };
 
-template <typename T>
-struct is_optional_type<boost::optional<T>&> : public boost::true_type
+/**
+ * It's a type which nothing is meant to be built from
+ * A value type constructible from it has an unconstrained converting constructor (std::any, boost::any), such a constructor
+ * would take TDeferredCall itself instead of calling its conversion operator.
+ */
+struct TUnrelated
 {
 };
 
+template <typename TCall>
+constexpr bool is_deferrable_v = !std::is_constructible<std::decay_t<typename TCall::result_type>, TUnrelated>::value;
+
+/**
+ * It creates an engaged optional TResult from the result of f(value...)
+ * The result is created in place if TResult supports in-place construction (boost::optional, std::optional)
+ * and its value type takes the result through the conversion operator of TDeferredCall.
+ */
+template <typename TResult, typename TFunctor, typename... TValue>
+constexpr TResult emplaceOptional(TFunctor& f, TValue&&... value)
+{
+    using TCall = TDeferredCall<TFunctor, TValue...>;
+
+    if constexpr (std::is_reference<typename TCall::result_type>::value || std::is_pointer<TResult>::value)
+    {
+        return makeOptional<TResult>(f(std::forward<TValue>(value)...));
+    }
+    else if constexpr (!is_deferrable_v<TCall>)
+    {
+        return TResult(f(std::forward<TValue>(value)...));
+    }
+    else if constexpr (std::is_constructible<TResult, boost::in_place_init_t, TCall>::value)
+    {
+        return TResult(boost::in_place_init, TCall{f, std::forward<TValue>(value)...});
+    }
+    else if constexpr (std::is_constructible<TResult, std::in_place_t, TCall>::value)
+    {
+        return TResult(std::in_place, TCall{f, std::forward<TValue>(value)...});
+    }
+    else
+    {
+        return TResult(f(std::forward<TValue>(value)...));
+    }
+}
+
+template <typename T, bool isOptional = is_optional_type<T>::value>
+struct optional_value_type
+{
+    using type = T;
+};
+
 template <typename T>
-struct is_optional_type<boost::optional<T>&&> : public boost::true_type
+struct optional_value_type<T, true>
 {
+    using TValue = typename optional_traits_t<T>::value_type;
+    using type = std::conditional_t<std::is_reference<T>::value,
+                                    decltype(optional_detail::getValue(std::declval<T>())),
+                                    std::conditional_t<std::is_const<T>::value, const TValue, TValue>>;
 };
 
 template <class TOptional>
 using optional_value_type_t = typename optional_detail::optional_value_type<TOptional>::type;
 
-template <typename FuncType, typename TOptional>
-using get_functor_result_type_t = typename boost::result_of<FuncType(optional_value_type_t<TOptional>)>::type;
-
 template <typename TOptional>
 using is_operator_applicable = is_optional_type<TOptional>;
 
@@ -159,92 +369,57 @@ struct is_higher_order_function<const THigherOrderFunction<T>&> : public boost::
 {
 };
 
-
-// clang-format off
-
-template<typename TOptional, typename FuncType, bool isUsed, bool isHOF>
-struct TOptinalTypes;
-
-template<typename TOptional, typename FuncType, bool isHOF>
-struct TOptinalTypes<TOptional, FuncType, false, isHOF>
+/**
+ * It's true for optional_ext::optional_future (see boost/optional_ext/async.hpp) which an async HOF returns instead of an optional
+ */
+template <typename T>
+struct is_optional_future : public boost::false_type
 {
-    using op_value_type = void;
-    using invoc_result = void;
-    using is_invoc_result_optional = void;
-    using deduced_result = void;
-    static constexpr bool is_applicable = false;
-    static constexpr bool has_higher_order_functon = false;
 };
 
-template<typename TOptional, typename FuncType>
-struct TOptinalTypes<TOptional, FuncType, true, false>
-{
-    using op_value_type = optional_value_type_t<TOptional>;
-    using invoc_result = get_functor_result_type_t<FuncType, TOptional>;
-    using is_invoc_result_optional = is_optional_type<invoc_result>;
-    using deduced_result = boost::conditional_t<
-        is_invoc_result_optional::value,
-        optional_value_type_t<invoc_result>,
-            invoc_result>;
-
-    static constexpr bool is_applicable = is_operator_applicable<TOptional>::value == boost::true_type::value;
-
-    static constexpr bool is_map_like = is_invoc_result_optional::value == boost::false_type::value;
-    static constexpr bool is_flat_map_like = is_invoc_result_optional::value == boost::true_type::value;
-    static constexpr bool has_higher_order_functon = false;
-};
 
-template<typename TOptional, typename FuncType>
-struct TOptinalTypes<TOptional, FuncType, true, true>
+/**
+ * It's a type returned by the pipe operator for an optional TOptional:
+ * the result of a map function kept in the optional of the same kind (see optional_traits::rebind)
+ * or the optional returned by a flat_map function
+ */
+template <typename TOptional, typename TInvocResult, bool isFlatMap = is_flat_map_result<TInvocResult>::value>
+struct TPipeResult
 {
-    using op_value_type = optional_value_type_t<TOptional>;
-    using invoc_result = typename boost::result_of<FuncType(TOptional)>::type;
-    using is_invoc_result_optional = is_optional_type<invoc_result>;
-    using deduced_result = invoc_result;
-
-    static constexpr bool is_applicable = is_operator_applicable<TOptional>::value == boost::true_type::value;
-    static constexpr bool is_map_like = is_invoc_result_optional::value == boost::false_type::value;
-    static constexpr bool is_flat_map_like = is_invoc_result_optional::value == boost::true_type::value;
-    static constexpr bool has_higher_order_functon = true;
+    using type = typename optional_traits_t<TOptional>::template rebind<TInvocResult>;
 };
 
-
-template<typename TOptional, typename FuncType, typename ArgType, bool IsUsed>
-struct TOptinalNoneTypes
+template <typename TOptional, typename TInvocResult>
+struct TPipeResult<TOptional, TInvocResult, true>
 {
-    static constexpr bool is_applicable = false;
+    using type = std::remove_cv_t<std::remove_reference_t<TInvocResult>>;
 };
 
-template<typename TOptional, typename FuncType>
-struct TOptinalNoneTypes<TOptional, FuncType, type_traits::ArgFunctor, true>
-{
-    using op_value_type = optional_value_type_t<TOptional>;
-    using invoc_result = typename boost::result_of<FuncType()>::type;
-    using is_invoc_result_optional = is_optional_type<invoc_result>;
-    using deduced_result = boost::conditional_t<
-        is_invoc_result_optional::value,
-        optional_value_type_t<invoc_result>,
-            invoc_result>;
-
-    static constexpr bool is_applicable = is_operator_applicable<TOptional>::value == boost::true_type::value;
-    static constexpr bool is_arg_callable = type_traits::is_callable<FuncType>::value == boost::true_type::value;
-};
+template <typename TOptional, typename TInvocResult>
+using pipe_result_t = typename TPipeResult<TOptional, TInvocResult>::type;
 
-template<typename TOptional, typename ValueType>
-struct TOptinalNoneTypes<TOptional, ValueType, type_traits::ArgValue, true>
+/**
+ * It's a type returned by operator|= : the optional returned by the function or the function result kept in the optional of the same kind as TOptional
+ * A returned pointer is an optional only for a source of the same pointer type, otherwise it's a value as for the pipe operator.
+ */
+template <typename TOptional, typename TInvocResult>
+using or_else_result_t = typename TPipeResult<TOptional,
+                                              TInvocResult,
+                                              is_flat_map_result<TInvocResult>::value
+                                                  || std::is_same<std::decay_t<TInvocResult>, std::decay_t<TOptional>>::value>::type;
+
+template <typename TOptional, typename Functor>
+constexpr bool is_nothrow_pipe() noexcept
 {
-    using op_value_type = optional_value_type_t<TOptional>;
-    using invoc_result = ValueType;
-    using is_invoc_result_optional = is_optional_type<invoc_result>;
-    using deduced_result = boost::conditional_t<
-        is_invoc_result_optional::value,
-        optional_value_type_t<invoc_result>,
-            invoc_result>;
-
-    static constexpr bool is_applicable = is_operator_applicable<TOptional>::value == boost::true_type::value;
-    static constexpr bool is_arg_callable = type_traits::is_callable<ValueType>::value == boost::true_type::value;
-};
-// clang-format on
+    if constexpr (is_higher_order_function<std::decay_t<Functor>>::value)
+    {
+        return noexcept(std::declval<Functor&>()(std::declval<TOptional>()));
+    }
+    else
+    {
+        return noexcept(std::declval<Functor&>()(getValue(std::declval<TOptional>())));
+    }
+}
 
 } // namespace optional_detail
 
@@ -252,10 +427,14 @@ struct TOptinalNoneTypes<TOptional, ValueType, type_traits::ArgValue, true>
 
 /**
  * It's a pipe operator for applying transformations for boost::optional
+ * It works with any optional-like type adapted by optional_ext::optional_traits (std::optional, pointers, ...)
+ * and keeps it: a map function result is stored in optional_traits<TOptional>::rebind.
  * The next function will be applied if boost::optional isn't empty
- * it's alias the "map" operator
+ *   - if the function returns a new value it's alias the "map" operator,
+ *   - if the function returns boost::optional it's alias the "flat_map" operator,
+ *   - if the function is a HOF (see hof::) it takes the boost::optional itself.
  * @param op is a boost::optional<T>
- * @param f is a function that takes boost::optional<T>::value_type and returns a new value
+ * @param f is a function that takes boost::optional<T>::value_type and returns a new value or boost::optional
  * @return a new boost::optional
  *
  * an example of usage:
@@ -273,7 +452,8 @@ struct TOptinalNoneTypes<TOptional, ValueType, type_traits::ArgValue, true>
  *        | [](int val)
  *          {
  *            return "Value is: " + std::to_string(val);
- *          };
+ *          }
+ *        | hof::filter_if([](const auto& el) { return !el.empty(); });
  *
  *     if (op)
  *     {
@@ -287,121 +467,41 @@ struct TOptinalNoneTypes<TOptional, ValueType, type_traits::ArgValue, true>
 // clang-format off
 template <typename TOptional,
           typename Functor,
-          typename deducer = optional_detail::TOptinalTypes<
-            TOptional,
-            Functor,
-            optional_detail::is_operator_applicable<TOptional>::value,
-            optional_detail::is_higher_order_function<Functor>::value>,
-          typename deduced_result = typename deducer::deduced_result,
-          typename boost::enable_if_c<deducer::is_applicable, int>::type = 0,
-          typename boost::enable_if_c<deducer::is_map_like, int>::type = 0,
-          typename boost::enable_if_c<!deducer::has_higher_order_functon, int>::type = 0>
+          typename boost::enable_if_c<optional_detail::is_operator_applicable<TOptional>::value, int>::type = 0>
 // clang-format on
-inline boost::optional<deduced_result> operator|(TOptional&& op, Functor&& f) noexcept(noexcept(f(std::forward<TOptional>(op).value())))
+inline decltype(auto) operator|(TOptional&& op, Functor&& f) noexcept(optional_detail::is_nothrow_pipe<TOptional, Functor>())
 {
-    if (op)
-    {
-        return f(std::forward<TOptional>(op).value());
-    }
-    else
+    if constexpr (optional_detail::is_higher_order_function<std::decay_t<Functor>>::value)
     {
-        return boost::none;
-    }
-}
+        static_assert(optional_detail::is_optional_type<decltype(f(std::forward<TOptional>(op)))>::value
+                          || optional_detail::is_optional_future<std::decay_t<decltype(f(std::forward<TOptional>(op)))>>::value,
+                      "a higher order function has to return boost::optional");
 
-/**
- * It's a pipe operator for applying extractor for boost::optional
- * The next function will be applied if boost::optional is empty
- * it's alias the "flat_map" operator
- * @param op is a boost::optional<T>
- * @param f is a function that returns a new boost::optional
- * @return boost::optional
- *
- * an example of usage:
- *
- *    int value;
- *    std::cin >> value;
- *
- *    auto op = boost::optional<int>(value)
- *        // can use as filter
- *        | [] (int val) -> boost::optional<int>
- *          {
- *            return val >= 0 ? boost::optional<int>(val) : boost::none;
- *          };
- *
- *     if (op)
- *     {
- *       std::cout << op.get() << std::endl;
- *     }
- *     else
- *     {
- *         std::cout << "op is empty" << std::endl;
- *     }
- */
-// clang-format off
-template <typename TOptional,
-          typename Functor,
-          typename deducer = optional_detail::TOptinalTypes<
-            TOptional,
-            Functor,
-            optional_detail::is_operator_applicable<TOptional>::value,
-            optional_detail::is_higher_order_function<Functor>::value>,
-          typename deduced_result = typename deducer::deduced_result,
-          typename boost::enable_if_c<deducer::is_applicable, int>::type = 0,
-          typename boost::enable_if_c<deducer::is_flat_map_like, int>::type = 1,
-          typename boost::enable_if_c<!deducer::has_higher_order_functon, int>::type = 0>
-// clang-format on
-inline boost::optional<deduced_result> operator|(TOptional&& op, Functor&& f) noexcept(noexcept(f(std::forward<TOptional>(op).value())))
-{
-    if (op)
-    {
-        return f(std::forward<TOptional>(op).value());
+        return f(std::forward<TOptional>(op));
     }
     else
     {
-        return boost::none;
-    }
-}
+        using TInvocResult = decltype(f(optional_detail::getValue(std::forward<TOptional>(op))));
+        using TResult = optional_detail::pipe_result_t<TOptional, TInvocResult>;
+        OPTIONAL_EXT_PROBE(optional_detail::is_flat_map_result<TInvocResult>::value ? optional_ext::stage_kind::flat_map : optional_ext::stage_kind::map, Functor);
 
-/**
- * It's special override for the pipe op. It's needed for implementing additional operators as HOF
- * @param op is a boost::optional<T>
- * @param f is a function that takes boost::optional<T>::value_type and returns a new value
- * @return a new boost::optional
- *
- * an example of usage:
- *
- *    int value;
- *    std::cin >> value;
- *
- *    auto op = boost::optional<int>(value)
- *        | op::filter_if([](const auto& el) { return el > 0; })
- *
- *     if (op)
- *     {
- *       std::cout << op.get() << std::endl;
- *     }
- *     else
- *     {
- *         std::cout << "op is empty" << std::endl;
- *     }
- */
-// clang-format off
-template <typename TOptional,
-          typename Functor,
-          typename deducer = optional_detail::TOptinalTypes<
-            TOptional,
-            Functor,
-            optional_detail::is_operator_applicable<TOptional>::value,
-            optional_detail::is_higher_order_function<Functor>::value>,
-          typename deduced_result = typename deducer::deduced_result,
-          typename boost::enable_if_c<deducer::is_applicable, int>::type = 0,
-          typename boost::enable_if_c<deducer::is_flat_map_like, int>::type = 1,
-          typename boost::enable_if_c<deducer::has_higher_order_functon, int>::type = 1>
-// clang-format on
-inline decltype(auto) operator|(TOptional&& op, Functor&& f) noexcept(noexcept(f(std::forward<TOptional>(op))))
-{
-    return f(std::forward<TOptional>(op));
+        if (optional_detail::hasValue(op))
+        {
+            if constexpr (optional_detail::is_flat_map_result<TInvocResult>::value)
+            {
+                return OPTIONAL_EXT_PROBED(TResult(f(optional_detail::getValue(std::forward<TOptional>(op)))));
+            }
+            else
+            {
+                return OPTIONAL_EXT_PROBED(optional_detail::emplaceOptional<TResult>(f, optional_detail::getValue(std::forward<TOptional>(op))));
+            }
+        }
+        else
+        {
+            OPTIONAL_EXT_PROBE_OUTCOME(false);
+            return optional_detail::makeNone<TResult>(op);
+        }
+    }
 }
 
 /**
@@ -439,18 +539,39 @@ inline decltype(auto) operator|(TOptional&& op, Functor&& f) noexcept(noexcept(f
  */
 template <typename TOptional,
           typename Functor,
-          typename deducer = optional_detail::TOptinalNoneTypes<TOptional, Functor, type_traits::argument_type_t<Functor>, optional_detail::is_operator_applicable<TOptional>::value>,
-          typename deduced_result = typename deducer::deduced_result,
-          typename boost::enable_if_c<deducer::is_applicable, int>::type = 0>
-inline boost::optional<deduced_result> operator|=(TOptional&& op, Functor&& f) noexcept(noexcept(f()))
+          typename boost::enable_if_c<optional_detail::is_operator_applicable<TOptional>::value, int>::type = 0>
+inline auto operator|=(TOptional&& op, Functor&& f) noexcept(optional_detail::is_nothrow_none<Functor, TOptional>())
+    -> optional_detail::or_else_result_t<TOptional, optional_detail::none_result_t<Functor, TOptional>>
 {
-    if (op)
+    using TResult = optional_detail::or_else_result_t<TOptional, optional_detail::none_result_t<Functor, TOptional>>;
+    OPTIONAL_EXT_PROBE(optional_ext::stage_kind::or_else, Functor);
+
+    if (optional_detail::hasValue(op))
+    {
+        OPTIONAL_EXT_PROBE_OUTCOME(true);
+        if constexpr (std::is_same<TResult, std::decay_t<TOptional>>::value)
+        {
+            return std::forward<TOptional>(op);
+        }
+        else
+        {
+            return optional_detail::makeOptional<TResult>(optional_detail::getValue(std::forward<TOptional>(op)));
+        }
+    }
+    else if constexpr (std::is_same<TResult, std::decay_t<optional_detail::none_result_t<Functor, TOptional>>>::value)
+    {
+        OPTIONAL_EXT_PROBE_OUTCOME(false);
+        return optional_detail::callNone(f, op);
+    }
+    else if constexpr (optional_detail::is_error_handler<Functor, TOptional>::value)
     {
-        return std::forward<decltype(op)>(op);
+        OPTIONAL_EXT_PROBE_OUTCOME(false);
+        return optional_detail::emplaceOptional<TResult>(f, optional_detail::getError(op));
     }
     else
     {
-        return f();
+        OPTIONAL_EXT_PROBE_OUTCOME(false);
+        return optional_detail::emplaceOptional<TResult>(f);
     }
 }
 
@@ -482,19 +603,21 @@ inline boost::optional<deduced_result> operator|=(TOptional&& op, Functor&& f) n
  */
 template <typename TOptional,
           typename Functor,
-          typename deducer = optional_detail::TOptinalNoneTypes<TOptional, Functor, type_traits::argument_type_t<Functor>, optional_detail::is_operator_applicable<TOptional>::value>,
-          typename deduced_result = typename deducer::invoc_result,
-          typename boost::enable_if_c<deducer::is_applicable, int>::type = 0,
-          typename boost::enable_if_c<deducer::is_arg_callable, int>::type = 0>
-inline deduced_result operator<<=(TOptional&& op, Functor&& f) noexcept(noexcept(f()))
+          typename boost::enable_if_c<optional_detail::is_operator_applicable<TOptional>::value && type_traits::is_callable<Functor>::value, int>::type = 0>
+inline auto operator<<=(TOptional&& op, Functor&& f) noexcept(optional_detail::is_nothrow_none<Functor, TOptional>())
+    -> optional_detail::none_result_t<Functor, TOptional>
 {
-    if (op)
+    OPTIONAL_EXT_PROBE(optional_ext::stage_kind::value_or, Functor);
+
+    if (optional_detail::hasValue(op))
     {
-        return std::forward<TOptional>(op).value();
+        OPTIONAL_EXT_PROBE_OUTCOME(true);
+        return optional_detail::getValue(std::forward<TOptional>(op));
     }
     else
     {
-        return f();
+        OPTIONAL_EXT_PROBE_OUTCOME(false);
+        return optional_detail::callNone(f, op);
     }
 }
 
@@ -523,62 +646,751 @@ inline deduced_result operator<<=(TOptional&& op, Functor&& f) noexcept(noexcept
  */
 template <typename TOptional,
           typename ValueType,
-          typename deducer = optional_detail::TOptinalNoneTypes<TOptional, ValueType, type_traits::argument_type_t<ValueType>, optional_detail::is_operator_applicable<TOptional>::value>,
-          typename deduced_result = typename deducer::invoc_result,
-          typename boost::enable_if_c<deducer::is_applicable, int>::type = 0,
-          typename boost::enable_if_c<!deducer::is_arg_callable, int>::type = 1>
-inline ValueType operator<<=(TOptional&& op, ValueType&& value) noexcept(true)
+          typename boost::enable_if_c<optional_detail::is_operator_applicable<TOptional>::value && !type_traits::is_callable<ValueType>::value, int>::type = 1>
+inline std::decay_t<ValueType> operator<<=(TOptional&& op, ValueType&& value)
+    noexcept(std::is_nothrow_constructible<std::decay_t<ValueType>, decltype(optional_detail::getValue(std::forward<TOptional>(op)))>::value
+             && std::is_nothrow_constructible<std::decay_t<ValueType>, ValueType&&>::value)
 {
-    if (op)
+    OPTIONAL_EXT_PROBE(optional_ext::stage_kind::value_or, ValueType);
+
+    if (optional_detail::hasValue(op))
     {
-        return std::forward<TOptional>(op).value();
+        OPTIONAL_EXT_PROBE_OUTCOME(true);
+        return optional_detail::getValue(std::forward<TOptional>(op));
     }
     else
     {
-        return value;
+        OPTIONAL_EXT_PROBE_OUTCOME(false);
+        return std::forward<ValueType>(value);
     }
 }
 
 
-template <typename T>
-typename boost::optional<typename boost::optional<T>::reference_const_type> toRefOp(const boost::optional<T>& op) noexcept(noexcept(op.value()))
+/**
+ * It returns an optional reference to the value of an optional-like object, the value isn't copied
+ * boost::optional<T> and std::optional<T> give boost::optional<T&>, pointers give T*.
+ * @param op is an lvalue optional-like object
+ * @return an empty optional reference if op is empty
+ */
+template <typename TOptional, typename boost::enable_if_c<optional_detail::is_optional_type<TOptional>::value, int>::type = 0>
+auto toRefOp(TOptional& op) noexcept -> typename optional_detail::optional_traits_t<TOptional>::template rebind<decltype(optional_detail::getValue(op))>
 {
-    return op.value();
+    using TResult = typename optional_detail::optional_traits_t<TOptional>::template rebind<decltype(optional_detail::getValue(op))>;
+
+    if (optional_detail::hasValue(op))
+    {
+        return optional_detail::makeOptional<TResult>(optional_detail::getValue(op));
+    }
+
+    return optional_detail::makeNone<TResult>(op);
 }
 
-template <typename T>
-typename boost::optional<typename boost::optional<T>::reference_type> toRefOp(boost::optional<T>& op) noexcept(noexcept(op.value()))
+template <typename TOptional,
+          typename boost::enable_if_c<optional_detail::is_optional_type<TOptional>::value && !std::is_reference<TOptional>::value, int>::type = 0>
+decltype(auto) toRefOp(TOptional&& op) noexcept
 {
-    return op.value();
+    return std::forward<TOptional>(op);
 }
 
-template <typename T>
-decltype(auto) toRefOp(boost::optional<T>&& op) noexcept(noexcept(op.value()))
+/**
+ * It starts a pipeline from a non-owning view, the viewed characters (or bytes) aren't copied
+ * The view is kept by value in the optional, so the viewed buffer has to outlive the pipeline.
+ * Only views themselves are accepted: a std::string would be viewed through a possibly temporary object.
+ *
+ * an example of usage:
+ *
+ *    provider.onNewDataView([](services::IDataProvider::DataView data) {
+ *        acc += toOp(data) | parseDouble | hof::filter_if(filter) <<= 0.0;
+ *    });
+ */
+template <typename TChar, typename TTraits>
+boost::optional<std::basic_string_view<TChar, TTraits>> toOp(std::basic_string_view<TChar, TTraits> view) noexcept
 {
-    return std::forward<decltype(op)>(op);
+    return view;
 }
 
-namespace hof {
+/**
+ * It's the same as toOp for a view, a view is already a reference to its buffer
+ */
+template <typename TChar, typename TTraits>
+boost::optional<std::basic_string_view<TChar, TTraits>> toRefOp(std::basic_string_view<TChar, TTraits> view) noexcept
+{
+    return view;
+}
+
+namespace optional_detail {
+
+template <typename T, typename = void>
+struct is_fused_stage : public boost::false_type
+{
+};
+
+/**
+ * A stage is "fused" when besides the optional-level operator() it also exposes
+ * the value-level entry points used by hof::pipeline:
+ *   some(value, next, none) - is called for an engaged value,
+ *   none<TValue>(next)      - is called when an upstream stage yielded boost::none, TValue is the value type of the stage.
+ */
+template <typename T>
+struct is_fused_stage<T, std::void_t<typename std::decay_t<T>::fused_stage_tag>> : public boost::true_type
+{
+};
 
 // clang-format off
 template <typename TPred>
-inline decltype(auto) filter_if(TPred&& pred) noexcept(std::is_nothrow_copy_constructible<TPred>::value || std::is_nothrow_move_constructible<TPred>::value)
+struct TFilterIf
 {
-    return optional_detail::createHof(
-        [pred = std::forward<TPred>(pred)](auto&& op) mutable noexcept(noexcept(pred(op.get())))
+    using fused_stage_tag = void;
+
+    TPred pred;
+
+    template <typename TOptional>
+    auto operator()(TOptional&& op) noexcept(noexcept(pred(optional_detail::getValue(op))))
+    {
+        using TRes = std::remove_cv_t<std::remove_reference_t<TOptional>>;
+        OPTIONAL_EXT_PROBE(optional_ext::stage_kind::filter_if, TPred);
+
+        if (optional_detail::hasValue(op) && pred(optional_detail::getValue(op)))
+        {
+            OPTIONAL_EXT_PROBE_OUTCOME(true);
+            return TRes(std::forward<TOptional>(op));
+        }
+
+        OPTIONAL_EXT_PROBE_OUTCOME(false);
+        return optional_detail::makeNone<TRes>(op);
+    }
+
+    template <typename TValue, typename TNext, typename TNone>
+    decltype(auto) some(TValue&& value, TNext&& next, TNone&& none)
+    {
+        if (pred(value))
+        {
+            return next(std::forward<TValue>(value));
+        }
+
+        return none();
+    }
+
+    template <typename TValue, typename TNone>
+    decltype(auto) none(TNone&& none)
+    {
+        return none();
+    }
+};
+
+template <typename TPred>
+struct TFilterIfNot
+{
+    using fused_stage_tag = void;
+
+    TPred pred;
+
+    template <typename TOptional>
+    auto operator()(TOptional&& op) noexcept(noexcept(pred(optional_detail::getValue(op))))
+    {
+        using TRes = std::remove_cv_t<std::remove_reference_t<TOptional>>;
+        OPTIONAL_EXT_PROBE(optional_ext::stage_kind::filter_if_not, TPred);
+
+        if (optional_detail::hasValue(op) && !pred(optional_detail::getValue(op)))
+        {
+            OPTIONAL_EXT_PROBE_OUTCOME(true);
+            return TRes(std::forward<TOptional>(op));
+        }
+
+        OPTIONAL_EXT_PROBE_OUTCOME(false);
+        return optional_detail::makeNone<TRes>(op);
+    }
+
+    template <typename TValue, typename TNext, typename TNone>
+    decltype(auto) some(TValue&& value, TNext&& next, TNone&& none)
+    {
+        if (!pred(value))
+        {
+            return next(std::forward<TValue>(value));
+        }
+
+        return none();
+    }
+
+    template <typename TValue, typename TNone>
+    decltype(auto) none(TNone&& none)
+    {
+        return none();
+    }
+};
+
+template <typename TSome, typename TNone>
+struct TMatch
+{
+    using fused_stage_tag = void;
+
+    TSome onSome;
+    TNone onNone;
+
+    template <typename TOptional>
+    decltype(auto) operator()(TOptional&& op) noexcept(noexcept(onSome(optional_detail::getValue(op))) && optional_detail::is_nothrow_none<TNone, TOptional>())
+    {
+        OPTIONAL_EXT_PROBE(optional_ext::stage_kind::match, TSome);
+        OPTIONAL_EXT_PROBE_OUTCOME(optional_detail::hasValue(op));
+
+        if (optional_detail::hasValue(op))
+        {
+            onSome(optional_detail::getValue(op));
+        }
+        else
+        {
+            optional_detail::callNone(onNone, op);
+        }
+
+        return std::forward<TOptional>(op);
+    }
+
+    template <typename TValue, typename TNext, typename TNoneNext>
+    decltype(auto) some(TValue&& value, TNext&& next, TNoneNext&&)
+    {
+        onSome(value);
+        return next(std::forward<TValue>(value));
+    }
+
+    template <typename TValue, typename TNoneNext>
+    decltype(auto) none(TNoneNext&& next)
+    {
+        onNone();
+        return next();
+    }
+};
+
+template <typename TSome>
+struct TMatchSome
+{
+    using fused_stage_tag = void;
+
+    TSome onSome;
+
+    template <typename TOptional>
+    decltype(auto) operator()(TOptional&& op) noexcept(noexcept(onSome(optional_detail::getValue(op))))
+    {
+        OPTIONAL_EXT_PROBE(optional_ext::stage_kind::match_some, TSome);
+        OPTIONAL_EXT_PROBE_OUTCOME(optional_detail::hasValue(op));
+
+        if (optional_detail::hasValue(op))
+        {
+            onSome(optional_detail::getValue(op));
+        }
+
+        return std::forward<TOptional>(op);
+    }
+
+    template <typename TValue, typename TNext, typename TNoneNext>
+    decltype(auto) some(TValue&& value, TNext&& next, TNoneNext&&)
+    {
+        onSome(value);
+        return next(std::forward<TValue>(value));
+    }
+
+    template <typename TValue, typename TNoneNext>
+    decltype(auto) none(TNoneNext&& next)
+    {
+        return next();
+    }
+};
+
+template <typename TNone>
+struct TMatchNone
+{
+    using fused_stage_tag = void;
+
+    TNone onNone;
+
+    template <typename TOptional>
+    decltype(auto) operator()(TOptional&& op) noexcept(optional_detail::is_nothrow_none<TNone, TOptional>())
+    {
+        OPTIONAL_EXT_PROBE(optional_ext::stage_kind::match_none, TNone);
+        OPTIONAL_EXT_PROBE_OUTCOME(optional_detail::hasValue(op));
+
+        if (!optional_detail::hasValue(op))
+        {
+            optional_detail::callNone(onNone, op);
+        }
+
+        return std::forward<TOptional>(op);
+    }
+
+    template <typename TValue, typename TNext, typename TNoneNext>
+    decltype(auto) some(TValue&& value, TNext&& next, TNoneNext&&)
+    {
+        return next(std::forward<TValue>(value));
+    }
+
+    template <typename TValue, typename TNoneNext>
+    decltype(auto) none(TNoneNext&& next)
+    {
+        onNone();
+        return next();
+    }
+};
+// clang-format on
+
+template <std::size_t I>
+struct TGetElement
+{
+    template <typename TValue>
+    decltype(auto) operator()(TValue&& value) const noexcept
+    {
+        using std::get;
+        return get<I>(std::forward<TValue>(value));
+    }
+};
+
+/**
+ * It's a map stage which applies projections (member pointers or getters) one by one and keeps the references they return
+ * A projection of an lvalue returns a reference, so the next optional is optional<U&>/optional<const U&> (see optional_traits::rebind).
+ * A projection of an rvalue (e.g. the value of a temporary boost::optional<S>) returns the value, the reference would dangle,
+ * even if a getter along the way returns a reference into the temporary.
+ */
+template <typename... TProjections>
+struct TProject
+{
+    std::tuple<TProjections...> projections;
+
+    template <typename TValue>
+    decltype(auto) operator()(TValue&& value) const
+    {
+        return apply<0, !std::is_lvalue_reference<TValue>::value>(std::forward<TValue>(value));
+    }
+
+private:
+    template <std::size_t I, bool isTemporary, typename TValue>
+    decltype(auto) apply(TValue&& value) const
+    {
+        if constexpr (I == sizeof...(TProjections))
         {
-            using TRes = typename std::remove_reference<decltype(op)>::type;
-            TRes ret = boost::none;
-            if (op)
+            if constexpr (!isTemporary && std::is_lvalue_reference<TValue>::value)
+            {
+                return std::forward<TValue>(value);
+            }
+            else
             {
-                if (pred(op.get()))
+                return std::decay_t<TValue>(std::forward<TValue>(value));
+            }
+        }
+        else
+        {
+            return apply<I + 1, isTemporary>(std::invoke(std::get<I>(projections), std::forward<TValue>(value)));
+        }
+    }
+};
+
+template <typename T, typename TList>
+struct TPrepend;
+
+template <typename T, typename... Ts>
+struct TPrepend<T, std::tuple<Ts...>>
+{
+    using type = std::tuple<T, Ts...>;
+};
+
+/**
+ * It deduces what a pipeline passes to the next stage (arg) and what boost::optional<decl>
+ * the equivalent operator| chain would produce at this point, carrying is true if the stage returns an error-carrying optional.
+ */
+template <typename TInvocResult, bool isFlatMap = is_flat_map_result<TInvocResult>::value>
+struct TPipelineMapTypes
+{
+    using arg = TInvocResult&&;
+    using decl = TInvocResult;
+    static constexpr bool carrying = false;
+};
+
+template <typename TInvocResult>
+struct TPipelineMapTypes<TInvocResult, true>
+{
+    using arg = decltype(optional_detail::getValue(std::declval<TInvocResult>()));
+    using decl = typename optional_traits_t<TInvocResult>::value_type;
+    static constexpr bool carrying = is_error_carrying<TInvocResult>::value;
+};
+
+template <typename TArg,
+          typename TDecl,
+          typename TStage,
+          bool isFused = is_fused_stage<TStage>::value,
+          bool isHOF = is_higher_order_function<TStage>::value>
+struct TPipelineStageTypes;
+
+template <typename TArg, typename TDecl, typename TStage, bool isHOF>
+struct TPipelineStageTypes<TArg, TDecl, TStage, true, isHOF>
+{
+    using arg = TArg;
+    using decl = TDecl;
+    static constexpr bool carrying = false;
+};
+
+template <typename TArg, typename TDecl, typename TStage>
+struct TPipelineStageTypes<TArg, TDecl, TStage, false, true>
+    : TPipelineMapTypes<decltype(std::declval<TStage&>()(std::declval<boost::optional<std::remove_reference_t<TArg>&>>()))>
+{
+};
+
+template <typename TArg, typename TDecl, typename TStage>
+struct TPipelineStageTypes<TArg, TDecl, TStage, false, false>
+    : TPipelineMapTypes<decltype(std::declval<TStage&>()(std::declval<TArg>()))>
+{
+};
+
+template <typename TArg, typename TDecl, typename... TStages>
+struct TPipelineTypes
+{
+    using args = std::tuple<TArg>;
+    using result_decl = TDecl;
+    static constexpr bool carrying = false;
+};
+
+template <typename TArg, typename TDecl, typename TStage, typename... TRest>
+struct TPipelineTypes<TArg, TDecl, TStage, TRest...>
+{
+    using stage = TPipelineStageTypes<TArg, TDecl, TStage>;
+    using next = TPipelineTypes<typename stage::arg, typename stage::decl, TRest...>;
+    using args = typename TPrepend<TArg, typename next::args>::type;
+    using result_decl = typename next::result_decl;
+    static constexpr bool carrying = stage::carrying || next::carrying;
+};
+
+template <typename TInput, bool isOptional = is_optional_type<std::decay_t<TInput>>::value>
+struct TPipelineInputTypes
+{
+    using arg = TInput&&;
+    using decl = TInput;
+    using family = boost::optional<std::decay_t<TInput>>;
+};
+
+template <typename TInput>
+struct TPipelineInputTypes<TInput, true>
+{
+    using arg = decltype(optional_detail::getValue(std::declval<TInput>()));
+    using decl = typename optional_traits_t<TInput>::value_type;
+    using family = std::decay_t<TInput>;
+};
+
+/**
+ * The result of a pipeline is the optional of the same kind as the input (see optional_traits::rebind),
+ * a plain input value gives boost::optional
+ */
+struct TOptionalTerminal
+{
+    template <typename TFamily, typename TDecl>
+    using result_type = typename optional_traits_t<TFamily>::template rebind<TDecl>;
+
+    template <typename TResult, typename TValue>
+    TResult some(TValue&& value)
+    {
+        return makeOptional<TResult>(std::forward<TValue>(value));
+    }
+
+    template <typename TResult>
+    TResult none()
+    {
+        return makeNone<TResult>();
+    }
+
+    template <typename TOptional>
+    auto finish(TOptional&& op)
+    {
+        using TDecl = std::remove_cv_t<std::remove_reference_t<typename optional_traits_t<TOptional>::value_type>>;
+        using TResult = typename optional_traits_t<TOptional>::template rebind<TDecl>;
+
+        return hasValue(op) ? makeOptional<TResult>(getValue(std::forward<TOptional>(op))) : makeNone<TResult>(op);
+    }
+};
+
+template <typename TDefault, typename ArgType = type_traits::argument_type_t<TDefault>>
+struct TDefaultTerminal;
+
+template <typename TDefault>
+struct TDefaultTerminal<TDefault, type_traits::ArgValue>
+{
+    template <typename TFamily, typename TDecl>
+    using result_type = TDefault;
+
+    TDefault defaultValue;
+
+    template <typename TResult, typename TValue>
+    TResult some(TValue&& value)
+    {
+        return std::forward<TValue>(value);
+    }
+
+    template <typename TResult>
+    TResult none()
+    {
+        return defaultValue;
+    }
+
+    template <typename TOptional>
+    TDefault finish(TOptional&& op)
+    {
+        return hasValue(op) ? TDefault(getValue(std::forward<TOptional>(op))) : defaultValue;
+    }
+};
+
+template <typename TDefault>
+struct TDefaultTerminal<TDefault, type_traits::ArgFunctor>
+{
+    template <typename TFamily, typename TDecl>
+    using result_type = std::decay_t<none_result_t<TDefault, TFamily>>;
+
+    TDefault defaultFn;
+
+    template <typename TResult, typename TValue>
+    TResult some(TValue&& value)
+    {
+        return std::forward<TValue>(value);
+    }
+
+    template <typename TResult>
+    TResult none()
+    {
+        return defaultFn();
+    }
+
+    // the function may take the error of an error-carrying optional
+    template <typename TOptional>
+    auto finish(TOptional&& op) -> std::decay_t<none_result_t<TDefault, TOptional>>
+    {
+        if (hasValue(op))
+        {
+            return getValue(std::forward<TOptional>(op));
+        }
+
+        return callNone(defaultFn, op);
+    }
+};
+
+/**
+ * It's a fused chain of stages that is built once and applied to many values.
+ * The stages are composed at compile time: a value is passed from stage to stage directly
+ * and the first stage that yields boost::none switches the rest of the chain to the "none" path,
+ * which only runs the side effects of hof::match/hof::match_none and produces the terminal value.
+ * It's a mutable callable as the hof:: combinators are: a stage or a sink may keep state between calls
+ * (a mutable lambda, hof::sum_into), so operator() isn't const.
+ */
+template <typename TTerminal, typename... TStages>
+class TPipeline
+{
+public:
+    constexpr TPipeline(TTerminal terminal, std::tuple<TStages...> stages)
+        : m_terminal(std::move(terminal))
+        , m_stages(std::move(stages))
+    {
+    }
+
+    template <typename TInput>
+    auto operator()(TInput&& input)
+    {
+        OPTIONAL_EXT_PROBE(optional_ext::stage_kind::pipeline, TPipeline);
+
+        if constexpr (is_error_carrying<TInput>::value)
+        {
+            // the fused none path has no error to pass on, so an error-carrying chain goes stage by stage as with the pipe operator
+            return OPTIONAL_EXT_PROBED(runCarrying<0>(std::forward<TInput>(input)));
+        }
+        else
+        {
+            using TInputTypes = TPipelineInputTypes<TInput>;
+            using TTypes = TPipelineTypes<typename TInputTypes::arg, typename TInputTypes::decl, TStages...>;
+
+            if constexpr (TTypes::carrying && is_optional_type<std::decay_t<TInput>>::value)
+            {
+                return OPTIONAL_EXT_PROBED(runCarrying<0>(std::forward<TInput>(input)));
+            }
+            else if constexpr (TTypes::carrying)
+            {
+                return OPTIONAL_EXT_PROBED(runCarryingSome<0>(std::forward<TInput>(input)));
+            }
+            else
+            {
+                using TResult = typename TTerminal::template result_type<typename TInputTypes::family, typename TTypes::result_decl>;
+
+                if constexpr (is_optional_type<std::decay_t<TInput>>::value)
                 {
-                    ret = std::forward<decltype(op)>(op);
+                    return OPTIONAL_EXT_PROBED(runOptional<0, TTypes, TResult>(std::forward<TInput>(input)));
+                }
+                else
+                {
+                    return OPTIONAL_EXT_PROBED(runSome<0, TTypes, TResult>(std::forward<TInput>(input)));
                 }
             }
+        }
+    }
 
-            return ret;
-        });
+    template <typename TNewTerminal>
+    TPipeline<TNewTerminal, TStages...> withTerminal(TNewTerminal&& terminal) const&
+    {
+        return {std::forward<TNewTerminal>(terminal), m_stages};
+    }
+
+    template <typename TNewTerminal>
+    TPipeline<TNewTerminal, TStages...> withTerminal(TNewTerminal&& terminal) &&
+    {
+        return {std::forward<TNewTerminal>(terminal), std::move(m_stages)};
+    }
+
+private:
+    template <std::size_t I, typename TTypes, typename TResult, typename TOptional>
+    TResult runOptional(TOptional&& op)
+    {
+        if (optional_detail::hasValue(op))
+        {
+            return runSome<I, TTypes, TResult>(optional_detail::getValue(std::forward<TOptional>(op)));
+        }
+
+        return runNone<I, TTypes, TResult>();
+    }
+
+    template <std::size_t I, typename TTypes, typename TResult, typename TValue>
+    TResult runSome(TValue&& value)
+    {
+        if constexpr (I == sizeof...(TStages))
+        {
+            return m_terminal.template some<TResult>(std::forward<TValue>(value));
+        }
+        else
+        {
+            using TStage = std::tuple_element_t<I, std::tuple<TStages...>>;
+            auto& stage = std::get<I>(m_stages);
+
+            if constexpr (is_fused_stage<TStage>::value)
+            {
+                return stage.some(
+                    std::forward<TValue>(value),
+                    [this](auto&& next) -> TResult { return runSome<I + 1, TTypes, TResult>(std::forward<decltype(next)>(next)); },
+                    [this]() -> TResult { return runNone<I + 1, TTypes, TResult>(); });
+            }
+            else if constexpr (is_higher_order_function<TStage>::value)
+            {
+                using TRefOptional = boost::optional<std::remove_reference_t<TValue>&>;
+                return runOptional<I + 1, TTypes, TResult>(stage(TRefOptional(value)));
+            }
+            else if constexpr (is_flat_map_result<decltype(stage(std::forward<TValue>(value)))>::value)
+            {
+                return runOptional<I + 1, TTypes, TResult>(stage(std::forward<TValue>(value)));
+            }
+            else if constexpr (I + 1 == sizeof...(TStages) && std::is_same<TTerminal, TOptionalTerminal>::value)
+            {
+                // the result of the last map function is created right in the returned optional
+                return emplaceOptional<TResult>(stage, std::forward<TValue>(value));
+            }
+            else
+            {
+                return runSome<I + 1, TTypes, TResult>(stage(std::forward<TValue>(value)));
+            }
+        }
+    }
+
+    // a plain value is passed on until the first stage that returns an optional
+    template <std::size_t I, typename TValue>
+    auto runCarryingSome(TValue&& value)
+    {
+        if constexpr (I == sizeof...(TStages))
+        {
+            return m_terminal.finish(boost::optional<std::decay_t<TValue>>(std::forward<TValue>(value)));
+        }
+        else
+        {
+            using TStage = std::tuple_element_t<I, std::tuple<TStages...>>;
+            auto& stage = std::get<I>(m_stages);
+
+            if constexpr (is_fused_stage<TStage>::value || is_higher_order_function<TStage>::value)
+            {
+                return runCarrying<I + 1>(stage(boost::optional<std::remove_reference_t<TValue>&>(value)));
+            }
+            else if constexpr (is_flat_map_result<decltype(stage(std::forward<TValue>(value)))>::value)
+            {
+                return runCarrying<I + 1>(stage(std::forward<TValue>(value)));
+            }
+            else
+            {
+                return runCarryingSome<I + 1>(stage(std::forward<TValue>(value)));
+            }
+        }
+    }
+
+    template <std::size_t I, typename TOptional>
+    auto runCarrying(TOptional&& op)
+    {
+        if constexpr (I == sizeof...(TStages))
+        {
+            return m_terminal.finish(std::forward<TOptional>(op));
+        }
+        else
+        {
+            using TStage = std::tuple_element_t<I, std::tuple<TStages...>>;
+            auto& stage = std::get<I>(m_stages);
+
+            if constexpr (is_fused_stage<TStage>::value || is_higher_order_function<TStage>::value)
+            {
+                return runCarrying<I + 1>(stage(std::forward<TOptional>(op)));
+            }
+            else
+            {
+                return runCarrying<I + 1>(std::forward<TOptional>(op) | stage);
+            }
+        }
+    }
+
+    template <std::size_t I, typename TTypes, typename TResult>
+    TResult runNone()
+    {
+        if constexpr (I == sizeof...(TStages))
+        {
+            return m_terminal.template none<TResult>();
+        }
+        else
+        {
+            using TStage = std::tuple_element_t<I, std::tuple<TStages...>>;
+            auto& stage = std::get<I>(m_stages);
+
+            using TArg = std::tuple_element_t<I, typename TTypes::args>;
+
+            if constexpr (is_fused_stage<TStage>::value)
+            {
+                return stage.template none<std::decay_t<TArg>>([this]() -> TResult { return runNone<I + 1, TTypes, TResult>(); });
+            }
+            else if constexpr (is_higher_order_function<TStage>::value)
+            {
+                using TRefOptional = boost::optional<std::remove_reference_t<TArg>&>;
+                return runOptional<I + 1, TTypes, TResult>(stage(TRefOptional()));
+            }
+            else
+            {
+                return runNone<I + 1, TTypes, TResult>();
+            }
+        }
+    }
+
+private:
+    TTerminal m_terminal;
+    std::tuple<TStages...> m_stages;
+};
+
+template <typename T>
+struct is_pipeline : public boost::false_type
+{
+};
+
+template <typename TTerminal, typename... TStages>
+struct is_pipeline<THigherOrderFunction<TPipeline<TTerminal, TStages...>>> : public boost::true_type
+{
+};
+
+} // namespace optional_detail
+
+namespace hof {
+
+// clang-format off
+template <typename TPred>
+inline decltype(auto) filter_if(TPred&& pred) noexcept(std::is_nothrow_copy_constructible<TPred>::value || std::is_nothrow_move_constructible<TPred>::value)
+{
+    return optional_detail::createHof(optional_detail::TFilterIf<std::decay_t<TPred>>{std::forward<TPred>(pred)});
 }
 // clang-format on
 
@@ -587,22 +1399,7 @@ template <typename TPred>
 inline decltype(auto) filter_if_not(TPred&& pred)
     noexcept(std::is_nothrow_copy_constructible<TPred>::value || std::is_nothrow_move_constructible<TPred>::value)
 {
-    return optional_detail::createHof(
-        [pred = std::forward<TPred>(pred)](auto&& op) mutable
-            noexcept(noexcept(pred(op.get())))
-        {
-            using TRes = typename std::remove_reference<decltype(op)>::type;
-            TRes ret;
-            if (op)
-            {
-                if (!pred(op.get()))
-                {
-                    ret = std::forward<decltype(op)>(op);
-                }
-            }
-
-            return ret;
-        });
+    return optional_detail::createHof(optional_detail::TFilterIfNot<std::decay_t<TPred>>{std::forward<TPred>(pred)});
 }
 // clang-format on
 
@@ -613,21 +1410,7 @@ inline decltype(auto) match(TSome&& some, TNone&& none)
                 && (std::is_nothrow_copy_constructible<TNone>::value || std::is_nothrow_move_constructible<TNone>::value))
 {
     return optional_detail::createHof(
-        [some = std::forward<TSome>(some), none = std::forward<TNone>(none)](auto&& op) mutable
-            noexcept(noexcept(some(op.get())) && noexcept(none()))
-            -> decltype(auto)
-        {
-            if (op)
-            {
-                some(op.get());
-            }
-            else
-            {
-                none();
-            }
-
-            return std::forward<decltype(op)>(op);
-        });
+        optional_detail::TMatch<std::decay_t<TSome>, std::decay_t<TNone>>{std::forward<TSome>(some), std::forward<TNone>(none)});
 }
 // clang-format on
 
@@ -636,18 +1419,7 @@ template <typename TFunctor>
 inline decltype(auto) match_some(TFunctor&& some)
     noexcept(std::is_nothrow_copy_constructible<TFunctor>::value || std::is_nothrow_move_constructible<TFunctor>::value)
 {
-    return optional_detail::createHof(
-        [some = std::forward<TFunctor>(some)](auto&& op) mutable
-            noexcept(noexcept(some(op.get())))
-            -> decltype(auto)
-        {
-            if (op)
-            {
-                some(op.get());
-            }
-
-            return std::forward<decltype(op)>(op);
-        });
+    return optional_detail::createHof(optional_detail::TMatchSome<std::decay_t<TFunctor>>{std::forward<TFunctor>(some)});
 }
 // clang-format on
 
@@ -656,20 +1428,82 @@ template <typename TFunctor>
 inline decltype(auto) match_none(TFunctor&& none)
     noexcept(std::is_nothrow_copy_constructible<TFunctor>::value || std::is_nothrow_move_constructible<TFunctor>::value)
 {
-    return optional_detail::createHof(
-        [none = std::forward<TFunctor>(none)](auto&& op) mutable
-            noexcept(noexcept(none()))
-            -> decltype(auto)
-        {
-            if (!op)
-            {
-                none();
-            }
-
-            return std::forward<decltype(op)>(op);
-        });
+    return optional_detail::createHof(optional_detail::TMatchNone<std::decay_t<TFunctor>>{std::forward<TFunctor>(none)});
 }
 // clang-format on
 
+/**
+ * It makes a map stage which drills into a value without copying it
+ * The projections are applied one by one, each is a pointer to a data member, a member function or a getter
+ * (a getter returns a reference with decltype(auto) or auto&). The optional keeps the reference:
+ * boost::optional<const S&> gives boost::optional<const U&>, boost::optional<S&> gives boost::optional<U&>,
+ * a pointer gives U*. The value of a temporary optional is moved out instead of referenced.
+ * @param projections are applied to the value one by one
+ * @return a map function
+ *
+ * an example of usage:
+ *
+ *    const boost::optional<const Order&> order = findOrder(id);
+ *    // it's boost::optional<const std::string&> referring to the order
+ *    auto name = order | hof::project(&Order::customer, &Customer::name);
+ */
+template <typename... TProjections>
+inline auto project(TProjections&&... projections)
+{
+    static_assert(sizeof...(TProjections) > 0, "hof::project takes at least one projection");
+    return optional_detail::TProject<std::decay_t<TProjections>...>{std::make_tuple(std::forward<TProjections>(projections)...)};
+}
+
+/**
+ * It makes a map stage which returns a reference to the I-th element of a tuple, a pair or an array (found by get<I>)
+ */
+template <std::size_t I>
+inline auto project()
+{
+    return optional_detail::TProject<optional_detail::TGetElement<I>>{};
+}
+
+/**
+ * It builds a reusable pipeline from the given stages
+ * The stages are the same as for the pipe operator: map and flat_map functions and hof:: combinators.
+ * The pipeline is a HOF, so it can be applied as p(op), p(value) or op | p
+ * The pipeline is a mutable callable (its stages may keep state), so it's called through a non-const object.
+ * @param stages are functions that are applied one by one
+ * @return a callable that returns boost::optional
+ *
+ * an example of usage:
+ *
+ *    auto p = hof::pipeline(toDouble,
+ *                           hof::filter_if([](double el) { return el >= 0.0; }),
+ *                           hof::match_some(log))
+ *             <<= 0.0;
+ *
+ *    for (const auto& data: messages)
+ *    {
+ *        acc += p(data);
+ *    }
+ */
+template <typename... TStages>
+inline decltype(auto) pipeline(TStages&&... stages)
+{
+    using TPipeline = optional_detail::TPipeline<optional_detail::TOptionalTerminal, std::decay_t<TStages>...>;
+    return optional_detail::createHof(TPipeline(optional_detail::TOptionalTerminal{}, std::make_tuple(std::forward<TStages>(stages)...)));
+}
 
 } // namespace hof
+
+/**
+ * It sets the terminal value of a pipeline
+ * The pipeline returns the value produced by the last stage or the default if any stage yields boost::none
+ * @param p is a pipeline created by hof::pipeline
+ * @param value is a default value or a function that returns a default value
+ * @return a pipeline that returns a value instead of boost::optional
+ */
+template <typename TPipelineHof,
+          typename ValueType,
+          typename boost::enable_if_c<optional_detail::is_pipeline<std::decay_t<TPipelineHof>>::value, int>::type = 0>
+inline decltype(auto) operator<<=(TPipelineHof&& p, ValueType&& value)
+{
+    using TTerminal = optional_detail::TDefaultTerminal<std::decay_t<ValueType>>;
+    return optional_detail::createHof(std::forward<TPipelineHof>(p).withTerminal(TTerminal{std::forward<ValueType>(value)}));
+}
@@ -0,0 +1,486 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <boost/optional.hpp>
+#include <boost/optional_ext.hpp>
+
+/**
+ * Aggregates which are updated by the sinks hof::sum_into, hof::count_none_into, hof::minmax_into and hof::histogram_into
+ * Every aggregate has add(value, isSome), which ignores the value of an empty optional with a select instead of a branch,
+ * and operator+=, which merges the aggregates of different threads (see optional_ext::combinable).
+ */
+
+namespace optional_detail {
+
+/**
+ * It chooses one of two objects by the address: the addresses are combined by a mask,
+ * GCC compiles a plain ?: of two values (or of two addresses followed by a load) into a branch.
+ */
+template <typename T>
+const T& select(bool condition, const T& lhs, const T& rhs) noexcept
+{
+    const auto mask = std::uintptr_t(0) - static_cast<std::uintptr_t>(condition);
+    return *reinterpret_cast<const T*>((reinterpret_cast<std::uintptr_t>(std::addressof(lhs)) & mask)
+                                       | (reinterpret_cast<std::uintptr_t>(std::addressof(rhs)) & ~mask));
+}
+
+// the value of an engaged optional or the empty value, the empty optional isn't dereferenced
+template <typename TOptional, typename TValue>
+const TValue& selectValue(const TOptional& op, const TValue& empty, bool isSome) noexcept
+{
+    const TValue* value = isSome ? std::addressof(optional_detail::getValue(op)) : nullptr;
+    const auto mask = std::uintptr_t(0) - static_cast<std::uintptr_t>(isSome);
+    return *reinterpret_cast<const TValue*>((reinterpret_cast<std::uintptr_t>(value) & mask)
+                                            | (reinterpret_cast<std::uintptr_t>(std::addressof(empty)) & ~mask));
+}
+
+} // namespace optional_detail
+
+namespace optional_ext {
+
+template <typename T>
+struct sum_aggregate
+{
+    T sum{};
+    std::uint64_t count = 0;
+
+    void add(const T& value, bool isSome) noexcept
+    {
+        const T zero{};
+        sum += optional_detail::select(isSome, value, zero);
+        count += isSome;
+    }
+
+    T result() const noexcept
+    {
+        return sum;
+    }
+
+    double mean() const noexcept
+    {
+        return count > 0 ? static_cast<double>(sum) / static_cast<double>(count) : 0.0;
+    }
+
+    sum_aggregate& operator+=(const sum_aggregate& other) noexcept
+    {
+        sum += other.sum;
+        count += other.count;
+        return *this;
+    }
+};
+
+/**
+ * It's a compensated (Kahan-Babuska-Neumaier) sum, its error doesn't grow with the number of values
+ * It costs a few more additions per value and doesn't work with -ffast-math, which reorders them.
+ */
+template <typename T>
+struct kahan_sum_aggregate
+{
+    static_assert(std::is_floating_point<T>::value, "the compensated sum is for floating point");
+
+    T sum{};
+    T compensation{};
+    std::uint64_t count = 0;
+
+    void add(const T& value, bool isSome) noexcept
+    {
+        const T zero{};
+        const T term = optional_detail::select(isSome, value, zero);
+        const T total = sum + term;
+        const bool isSumLarger = std::abs(sum) >= std::abs(term);
+        compensation += isSumLarger ? (sum - total) + term : (term - total) + sum;
+        sum = total;
+        count += isSome;
+    }
+
+    T result() const noexcept
+    {
+        return sum + compensation;
+    }
+
+    double mean() const noexcept
+    {
+        return count > 0 ? static_cast<double>(result()) / static_cast<double>(count) : 0.0;
+    }
+
+    kahan_sum_aggregate& operator+=(const kahan_sum_aggregate& other) noexcept
+    {
+        const auto count = this->count;
+        add(other.sum, true);
+        add(other.compensation, true);
+        this->count = count + other.count;
+        return *this;
+    }
+};
+
+// min and max are the limits of T until a value is added
+template <typename T>
+struct minmax_aggregate
+{
+    T min = std::numeric_limits<T>::max();
+    T max = std::numeric_limits<T>::lowest();
+    std::uint64_t count = 0;
+
+    void add(const T& value, bool isSome) noexcept
+    {
+        min = std::min(min, optional_detail::select(isSome, value, min));
+        max = std::max(max, optional_detail::select(isSome, value, max));
+        count += isSome;
+    }
+
+    minmax_aggregate& operator+=(const minmax_aggregate& other) noexcept
+    {
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+        count += other.count;
+        return *this;
+    }
+};
+
+/**
+ * It's a histogram of [lo, hi) with bins of equal width
+ * The values below lo (and NaN) are counted by underflow(), the values from hi on by overflow().
+ */
+template <typename T>
+class histogram_aggregate
+{
+public:
+    histogram_aggregate(T lo, T hi, std::size_t bins)
+        : m_lo(lo)
+        , m_hi(hi)
+        , m_scale(static_cast<double>(std::max<std::size_t>(bins, 1)) / (static_cast<double>(hi) - static_cast<double>(lo)))
+        , m_counts(std::max<std::size_t>(bins, 1) + 3, 0)
+    {
+        if (!(lo < hi))
+        {
+            throw std::invalid_argument("histogram_aggregate: lo must be less than hi");
+        }
+    }
+
+    void add(const T& value, bool isSome) noexcept
+    {
+        // the slots are: underflow, the bins, overflow and the last one, which takes the empty optionals
+        const auto bins = this->bins();
+        const auto pos = (static_cast<double>(value) - static_cast<double>(m_lo)) * m_scale;
+        const auto bin = !(pos >= 0.0) ? 0 : pos < static_cast<double>(bins) ? 1 + static_cast<std::size_t>(pos) : bins + 1;
+        m_counts[isSome ? bin : bins + 2] += 1;
+    }
+
+    std::size_t bins() const noexcept
+    {
+        return m_counts.size() - 3;
+    }
+
+    std::uint64_t operator[](std::size_t bin) const noexcept
+    {
+        return m_counts[bin + 1];
+    }
+
+    std::uint64_t underflow() const noexcept
+    {
+        return m_counts.front();
+    }
+
+    std::uint64_t overflow() const noexcept
+    {
+        return m_counts[bins() + 1];
+    }
+
+    // the number of the added values, the empty optionals aren't counted
+    std::uint64_t count() const noexcept
+    {
+        std::uint64_t ret = 0;
+        for (std::size_t i = 0; i < bins() + 2; ++i)
+        {
+            ret += m_counts[i];
+        }
+        return ret;
+    }
+
+    T lo() const noexcept
+    {
+        return m_lo;
+    }
+
+    T hi() const noexcept
+    {
+        return m_hi;
+    }
+
+    histogram_aggregate& operator+=(const histogram_aggregate& other)
+    {
+        if (m_lo != other.m_lo || m_hi != other.m_hi || m_counts.size() != other.m_counts.size())
+        {
+            throw std::invalid_argument("histogram_aggregate: the histograms have different bins");
+        }
+
+        for (std::size_t i = 0; i < m_counts.size(); ++i)
+        {
+            m_counts[i] += other.m_counts[i];
+        }
+        return *this;
+    }
+
+private:
+    T m_lo;
+    T m_hi;
+    double m_scale;
+    std::vector<std::uint64_t> m_counts;
+};
+
+/**
+ * It's an aggregate with a copy per thread, a sink given a combinable updates the copy of the calling thread
+ * Every copy starts from the initial value, combine() merges them into it with +=.
+ * combine() and clear() must not run while other threads update their copies, e.g. call them after the threads are joined.
+ *
+ * an example of usage:
+ *
+ *    optional_ext::combinable<optional_ext::sum_aggregate<double>> total;
+ *    // on every worker thread
+ *    toOp(data) | hof::parse<double>() | hof::sum_into(total);
+ *    // after the workers are joined
+ *    std::cout << total.combine().mean();
+ */
+template <typename T>
+class combinable
+{
+public:
+    explicit combinable(T init = T())
+        : m_id(nextId())
+        , m_init(std::move(init))
+    {
+    }
+
+    combinable(const combinable&) = delete;
+    combinable& operator=(const combinable&) = delete;
+
+    // the first call of a thread creates its copy under a lock, the next ones find it in a thread-local cache
+    T& local()
+    {
+        thread_local std::array<TCacheEntry, cache_size> cache{};
+
+        auto& entry = cache[m_id % cache_size];
+        if (entry.owner != m_id)
+        {
+            entry = {m_id, &slot()};
+        }
+
+        return entry.slot->value;
+    }
+
+    T combine() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        T ret = m_init;
+        for (const auto& el : m_slots)
+        {
+            ret += el->value;
+        }
+        return ret;
+    }
+
+    // every copy starts from the initial value again
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& el : m_slots)
+        {
+            el->value = m_init;
+        }
+    }
+
+private:
+    static constexpr std::size_t cache_size = 8;
+
+    // the copies are written by different threads, so every one is on its own cache lines
+    struct alignas(64) TSlot
+    {
+        T value;
+    };
+
+    struct TCacheEntry
+    {
+        std::uint64_t owner;
+        TSlot* slot;
+    };
+
+    // the ids aren't reused, so a cache entry of a destroyed combinable is never matched
+    static std::uint64_t nextId() noexcept
+    {
+        static std::atomic<std::uint64_t> id{0};
+        return id.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    TSlot& slot()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto& ret = m_threads[std::this_thread::get_id()];
+        if (!ret)
+        {
+            m_slots.push_back(std::make_unique<TSlot>(TSlot{m_init}));
+            ret = m_slots.back().get();
+        }
+        return *ret;
+    }
+
+private:
+    const std::uint64_t m_id;
+    const T m_init;
+
+    mutable std::mutex m_mutex;
+    std::vector<std::unique_ptr<TSlot>> m_slots;
+    std::unordered_map<std::thread::id, TSlot*> m_threads;
+};
+
+} // namespace optional_ext
+
+namespace optional_detail {
+
+template <typename T>
+T& localTarget(T& target) noexcept
+{
+    return target;
+}
+
+template <typename T>
+T& localTarget(optional_ext::combinable<T>& target)
+{
+    return target.local();
+}
+
+// a plain number is a sum (or a counter), anything else is an aggregate with add(value, isSome)
+template <typename TTarget, typename TValue>
+void addTo(TTarget& target, const TValue& value, bool isSome)
+{
+    if constexpr (std::is_arithmetic<TTarget>::value)
+    {
+        const TValue zero{};
+        target += static_cast<TTarget>(select(isSome, value, zero));
+    }
+    else
+    {
+        target.add(value, isSome);
+    }
+}
+
+struct TAddValue
+{
+    template <typename TTarget, typename TValue>
+    void operator()(TTarget& target, const TValue& value, bool isSome) const
+    {
+        addTo(target, value, isSome);
+    }
+};
+
+struct TCountNone
+{
+    template <typename TTarget, typename TValue>
+    void operator()(TTarget& target, const TValue&, bool isSome) const noexcept
+    {
+        target += !isSome;
+    }
+};
+
+/**
+ * It's a sink stage: it passes the optional through and adds it to the target (an aggregate or optional_ext::combinable)
+ * The value of an empty optional is replaced by a default one and the update is told that it's empty,
+ * so operator| and hof::pipeline update the aggregate the same way.
+ */
+template <typename TTarget, typename TUpdate>
+struct TAggregateInto
+{
+    using fused_stage_tag = void;
+
+    TTarget* target;
+    TUpdate update;
+
+    template <typename TOptional>
+    decltype(auto) operator()(TOptional&& op)
+    {
+        using TValue = std::decay_t<decltype(optional_detail::getValue(op))>;
+
+        const TValue empty{};
+        const bool isSome = optional_detail::hasValue(op);
+        update(localTarget(*target), selectValue(op, empty, isSome), isSome);
+        return std::forward<TOptional>(op);
+    }
+
+    template <typename TValue, typename TNext, typename TNoneNext>
+    decltype(auto) some(TValue&& value, TNext&& next, TNoneNext&&)
+    {
+        update(localTarget(*target), value, true);
+        return next(std::forward<TValue>(value));
+    }
+
+    template <typename TValue, typename TNoneNext>
+    decltype(auto) none(TNoneNext&& next)
+    {
+        const TValue empty{};
+        update(localTarget(*target), empty, false);
+        return next();
+    }
+};
+
+template <typename TUpdate, typename TTarget>
+inline decltype(auto) createSink(TTarget& target)
+{
+    return createHof(TAggregateInto<TTarget, TUpdate>{&target, TUpdate{}});
+}
+
+} // namespace optional_detail
+
+namespace hof {
+
+/**
+ * It adds the value of an engaged optional to a number, optional_ext::sum_aggregate, optional_ext::kahan_sum_aggregate
+ * or a combinable of them, and passes the optional through
+ *
+ * an example of usage:
+ *
+ *    toOp(data) | hof::parse<double>() | hof::count_none_into(errors) | hof::filter_if(filter) | hof::sum_into(acc);
+ */
+template <typename TTarget>
+inline decltype(auto) sum_into(TTarget& target)
+{
+    return optional_detail::createSink<optional_detail::TAddValue>(target);
+}
+
+// it counts the empty optionals in an integer (or a combinable of it) and passes the optional through
+template <typename TTarget>
+inline decltype(auto) count_none_into(TTarget& target)
+{
+    return optional_detail::createSink<optional_detail::TCountNone>(target);
+}
+
+// it adds the value of an engaged optional to optional_ext::minmax_aggregate (or a combinable of it)
+template <typename TTarget>
+inline decltype(auto) minmax_into(TTarget& target)
+{
+    return optional_detail::createSink<optional_detail::TAddValue>(target);
+}
+
+// it adds the value of an engaged optional to optional_ext::histogram_aggregate (or a combinable of it)
+template <typename TTarget>
+inline decltype(auto) histogram_into(TTarget& target)
+{
+    return optional_detail::createSink<optional_detail::TAddValue>(target);
+}
+
+} // namespace hof
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace optional_ext {
+
+template <typename In, typename Out, std::size_t Capacity>
+class any_pipeline;
+
+} // namespace optional_ext
+
+namespace optional_detail {
+
+template <typename T>
+struct is_any_pipeline : public std::false_type
+{
+};
+
+template <typename In, typename Out, std::size_t Capacity>
+struct is_any_pipeline<optional_ext::any_pipeline<In, Out, Capacity>> : public std::true_type
+{
+};
+
+enum class TAnyPipelineOperation
+{
+    move,
+    destroy
+};
+
+/**
+ * It's the code of a type-erased pipeline: invoke is called per input, manage moves and destroys the stored callable
+ */
+template <typename F, typename In, typename Out>
+struct TAnyPipelineOps
+{
+    static Out invoke(void* storage, In&& in)
+    {
+        if constexpr (std::is_void<Out>::value)
+        {
+            (*std::launder(static_cast<F*>(storage)))(std::forward<In>(in));
+        }
+        else
+        {
+            return (*std::launder(static_cast<F*>(storage)))(std::forward<In>(in));
+        }
+    }
+
+    static void manage(TAnyPipelineOperation operation, void* storage, void* other) noexcept
+    {
+        auto* f = std::launder(static_cast<F*>(storage));
+        if (operation == TAnyPipelineOperation::move)
+        {
+            ::new (other) F(std::move(*f));
+        }
+        f->~F();
+    }
+};
+
+template <typename In, typename Out>
+struct TEmptyPipelineOps
+{
+    [[noreturn]] static Out invoke(void*, In&&)
+    {
+        throw std::bad_function_call();
+    }
+};
+
+} // namespace optional_detail
+
+namespace optional_ext {
+
+/**
+ * It's a type-erased pipeline which keeps the callable in an inline buffer, it never allocates
+ * It replaces std::function<Out(In)> for a pipeline kept in a handler or a container: a fused chain built by hof::pipeline
+ * (or any callable invocable as Out(In)) is stored as a whole, so a call costs a single indirect call
+ * whatever the number of stages. A callable which doesn't fit Capacity bytes is rejected at compile time.
+ * The pipeline is move-only, so move-only callables (e.g. a lambda owning a std::unique_ptr) are accepted too.
+ * Calling an empty pipeline throws std::bad_function_call.
+ *
+ * an example of usage:
+ *
+ *    std::vector<optional_ext::any_pipeline<std::string_view, double>> pipelines;
+ *    pipelines.emplace_back(hof::pipeline(hof::parse<double>(), hof::filter_if(filter)) <<= 0.0);
+ *    pipelines.emplace_back(hof::pipeline(hof::parse<int>(), [](int el) { return el * 0.5; }) <<= 0.0);
+ *
+ *    for (auto& pipeline : pipelines)
+ *    {
+ *        acc += pipeline(data);
+ *    }
+ */
+template <typename In, typename Out, std::size_t Capacity = 64>
+class any_pipeline
+{
+public:
+    static constexpr std::size_t capacity = Capacity;
+
+    any_pipeline() noexcept = default;
+
+    any_pipeline(std::nullptr_t) noexcept
+    {
+    }
+
+    template <typename F, typename = std::enable_if_t<!optional_detail::is_any_pipeline<std::decay_t<F>>::value && !std::is_same<std::decay_t<F>, std::nullptr_t>::value>>
+    any_pipeline(F&& f) noexcept(std::is_nothrow_constructible<std::decay_t<F>, F>::value)
+    {
+        emplace(std::forward<F>(f));
+    }
+
+    any_pipeline(any_pipeline&& other) noexcept
+    {
+        moveFrom(other);
+    }
+
+    any_pipeline& operator=(any_pipeline&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    template <typename F, typename = std::enable_if_t<!optional_detail::is_any_pipeline<std::decay_t<F>>::value && !std::is_same<std::decay_t<F>, std::nullptr_t>::value>>
+    any_pipeline& operator=(F&& f)
+    {
+        reset();
+        emplace(std::forward<F>(f));
+        return *this;
+    }
+
+    any_pipeline& operator=(std::nullptr_t) noexcept
+    {
+        reset();
+        return *this;
+    }
+
+    any_pipeline(const any_pipeline&) = delete;
+    any_pipeline& operator=(const any_pipeline&) = delete;
+
+    ~any_pipeline()
+    {
+        reset();
+    }
+
+    Out operator()(In in)
+    {
+        return m_invoke(m_storage, std::forward<In>(in));
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return m_manage != nullptr;
+    }
+
+    void reset() noexcept
+    {
+        if (m_manage)
+        {
+            m_manage(optional_detail::TAnyPipelineOperation::destroy, m_storage, nullptr);
+            m_manage = nullptr;
+            m_invoke = &optional_detail::TEmptyPipelineOps<In, Out>::invoke;
+        }
+    }
+
+private:
+    using TInvoke = Out (*)(void*, In&&);
+    using TManage = void (*)(optional_detail::TAnyPipelineOperation, void*, void*) noexcept;
+
+    template <typename F>
+    void emplace(F&& f)
+    {
+        using TStored = std::decay_t<F>;
+        static_assert(std::is_invocable_r<Out, TStored&, In>::value, "any_pipeline<In, Out> takes a callable invocable as Out(In)");
+        static_assert(sizeof(TStored) <= Capacity, "the pipeline doesn't fit the inline storage, increase the Capacity of any_pipeline");
+        static_assert(alignof(TStored) <= alignof(std::max_align_t), "the pipeline is over-aligned for the inline storage");
+        static_assert(std::is_nothrow_move_constructible<TStored>::value, "any_pipeline takes a callable which is nothrow move constructible");
+
+        ::new (static_cast<void*>(m_storage)) TStored(std::forward<F>(f));
+        m_invoke = &optional_detail::TAnyPipelineOps<TStored, In, Out>::invoke;
+        m_manage = &optional_detail::TAnyPipelineOps<TStored, In, Out>::manage;
+    }
+
+    void moveFrom(any_pipeline& other) noexcept
+    {
+        if (other.m_manage)
+        {
+            other.m_manage(optional_detail::TAnyPipelineOperation::move, other.m_storage, m_storage);
+            m_invoke = other.m_invoke;
+            m_manage = other.m_manage;
+            other.m_invoke = &optional_detail::TEmptyPipelineOps<In, Out>::invoke;
+            other.m_manage = nullptr;
+        }
+    }
+
+    // the call goes straight to the invoker of the stored type, an empty pipeline has one that throws
+    TInvoke m_invoke = &optional_detail::TEmptyPipelineOps<In, Out>::invoke;
+    TManage m_manage = nullptr;
+    alignas(std::max_align_t) unsigned char m_storage[Capacity];
+};
+
+} // namespace optional_ext
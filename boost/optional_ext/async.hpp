@@ -0,0 +1,536 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <boost/optional.hpp>
+#include <boost/optional_ext.hpp>
+
+namespace optional_detail {
+
+/**
+ * It's a shared state of optional_future: the result (or an exception) and the only continuation
+ * The continuation is called by the thread which sets the result or immediately if the result is already set,
+ * so it refers to the state by a raw pointer (the caller keeps the state alive).
+ */
+template <typename T>
+class TAsyncState
+{
+public:
+    void setValue(boost::optional<T>&& value)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_value = std::move(value);
+        complete(lock);
+    }
+
+    void setError(std::exception_ptr error)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_error = std::move(error);
+        complete(lock);
+    }
+
+    void subscribe(std::function<void()> continuation)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_isReady)
+            {
+                m_continuation = std::move(continuation);
+                return;
+            }
+        }
+
+        continuation();
+    }
+
+    bool isReady() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_isReady;
+    }
+
+    void wait() const
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this] { return m_isReady; });
+    }
+
+    /**
+     * It moves the result out, it's called once when the state is ready
+     */
+    boost::optional<T> take()
+    {
+        if (m_error)
+        {
+            std::rethrow_exception(m_error);
+        }
+
+        return std::move(m_value);
+    }
+
+private:
+    void complete(std::unique_lock<std::mutex>& lock)
+    {
+        m_isReady = true;
+        auto continuation = std::move(m_continuation);
+        lock.unlock();
+
+        m_cv.notify_all();
+        if (continuation)
+        {
+            continuation();
+        }
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    mutable std::condition_variable m_cv;
+    bool m_isReady = false;
+    boost::optional<T> m_value;
+    std::exception_ptr m_error;
+    std::function<void()> m_continuation;
+};
+
+template <typename T>
+using async_state_ptr = std::shared_ptr<TAsyncState<T>>;
+
+/**
+ * It's a value type of the future which keeps the result of a stage applied to an optional
+ */
+template <typename TOptional>
+using async_value_t = typename optional_traits_t<std::decay_t<TOptional>>::value_type;
+
+/**
+ * It stores the optional returned by compute() (converted to boost::optional) or the thrown exception to the state
+ */
+template <typename T, typename TCompute>
+void setAsyncResult(TAsyncState<T>& state, TCompute&& compute) noexcept
+{
+    try
+    {
+        auto&& res = compute();
+        if constexpr (std::is_same<std::decay_t<decltype(res)>, boost::optional<T>>::value)
+        {
+            state.setValue(std::move(res));
+        }
+        else if (optional_detail::hasValue(res))
+        {
+            state.setValue(boost::optional<T>(optional_detail::getValue(std::move(res))));
+        }
+        else
+        {
+            state.setValue(boost::none);
+        }
+    }
+    catch (...)
+    {
+        state.setError(std::current_exception());
+    }
+}
+
+} // namespace optional_detail
+
+namespace optional_ext {
+
+/**
+ * It's a future of boost::optional<T> produced by hof::async_map/hof::async_flat_map
+ * It's pipeable (as an rvalue):
+ *   - fut | f and fut |= f attach continuations and return a new optional_future,
+ *     f is called by the thread which completes fut (async stages are sent to their executors),
+ *   - fut <<= value waits for the result and extracts the value as for boost::optional.
+ * An exception thrown by any stage is rethrown by get() (and so by operator<<=).
+ */
+template <typename T>
+class optional_future
+{
+public:
+    using value_type = T;
+
+    explicit optional_future(optional_detail::async_state_ptr<T> state) noexcept
+        : m_state(std::move(state))
+    {
+    }
+
+    optional_future(optional_future&&) noexcept = default;
+    optional_future& operator=(optional_future&&) noexcept = default;
+    optional_future(const optional_future&) = delete;
+    optional_future& operator=(const optional_future&) = delete;
+
+    bool is_ready() const
+    {
+        return m_state->isReady();
+    }
+
+    void wait() const
+    {
+        m_state->wait();
+    }
+
+    /**
+     * It waits for the result and moves it out, the future can't be used after that
+     */
+    boost::optional<T> get() &&
+    {
+        auto state = std::move(m_state);
+        state->wait();
+        return state->take();
+    }
+
+    /**
+     * It calls apply(boost::optional<T>&&) when the result is ready and returns the future of its result
+     * apply has to return an optional or an optional_future (in the latter case the futures are joined).
+     */
+    template <typename TApply>
+    auto then(TApply&& apply) &&
+    {
+        using TApplyFunctor = std::decay_t<TApply>;
+        using TRes = std::decay_t<decltype(std::declval<TApplyFunctor&>()(std::declval<boost::optional<T>>()))>;
+
+        if constexpr (optional_detail::is_optional_future<TRes>::value)
+        {
+            using TValue = typename TRes::value_type;
+
+            auto state = std::make_shared<optional_detail::TAsyncState<TValue>>();
+            auto source = std::move(m_state);
+            source->subscribe([source = source.get(), state, apply = TApplyFunctor(std::forward<TApply>(apply))]() mutable {
+                try
+                {
+                    auto inner = apply(source->take());
+                    std::move(inner).forwardTo(state);
+                }
+                catch (...)
+                {
+                    state->setError(std::current_exception());
+                }
+            });
+
+            return optional_future<TValue>(std::move(state));
+        }
+        else
+        {
+            using TValue = optional_detail::async_value_t<TRes>;
+
+            auto state = std::make_shared<optional_detail::TAsyncState<TValue>>();
+            auto source = std::move(m_state);
+            source->subscribe([source = source.get(), state, apply = TApplyFunctor(std::forward<TApply>(apply))]() mutable {
+                optional_detail::setAsyncResult(*state, [&source, &apply]() { return apply(source->take()); });
+            });
+
+            return optional_future<TValue>(std::move(state));
+        }
+    }
+
+private:
+    template <typename U>
+    friend class optional_future;
+
+    void forwardTo(const optional_detail::async_state_ptr<T>& target) &&
+    {
+        auto source = std::move(m_state);
+        source->subscribe([source = source.get(), target]() { optional_detail::setAsyncResult(*target, [&source]() { return source->take(); }); });
+    }
+
+private:
+    optional_detail::async_state_ptr<T> m_state;
+};
+
+/**
+ * It's a work-stealing thread pool
+ * Every worker has its own deque: it takes its own tasks from the back (the most recent ones, they are hot in the cache)
+ * and steals the oldest tasks of other workers from the front. A task posted by a worker goes to its own deque,
+ * others are spread round-robin. A task mustn't throw and mustn't block on a future of the same pool.
+ */
+class thread_pool
+{
+public:
+    using task_type = std::function<void()>;
+
+    explicit thread_pool(std::size_t threads = std::max<std::size_t>(1, std::thread::hardware_concurrency()))
+    {
+        threads = std::max<std::size_t>(1, threads);
+        for (std::size_t i = 0; i < threads; ++i)
+        {
+            m_queues.push_back(std::make_unique<TQueue>());
+        }
+        for (std::size_t i = 0; i < threads; ++i)
+        {
+            m_threads.emplace_back([this, i] { run(i); });
+        }
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    /**
+     * It waits for all posted tasks to complete
+     */
+    ~thread_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_isStopped = true;
+        }
+        m_cv.notify_all();
+
+        for (auto& thread : m_threads)
+        {
+            thread.join();
+        }
+    }
+
+    void execute(task_type task)
+    {
+        const std::size_t index = t_pool == this ? t_index : m_next.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_pending;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+            m_queues[index]->tasks.push_back(std::move(task));
+        }
+        m_cv.notify_one();
+    }
+
+    std::size_t size() const noexcept
+    {
+        return m_threads.size();
+    }
+
+private:
+    struct TQueue
+    {
+        std::mutex mutex;
+        std::deque<task_type> tasks;
+    };
+
+    bool pop(std::size_t index, task_type& task)
+    {
+        {
+            auto& own = *m_queues[index];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty())
+            {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+
+        for (std::size_t i = 1; i < m_queues.size(); ++i)
+        {
+            auto& victim = *m_queues[(index + i) % m_queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty())
+            {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void run(std::size_t index)
+    {
+        t_pool = this;
+        t_index = index;
+
+        task_type task;
+        for (;;)
+        {
+            if (pop(index, task))
+            {
+                m_pending.fetch_sub(1, std::memory_order_relaxed);
+                task();
+                task = nullptr;
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this] { return m_isStopped || m_pending.load(std::memory_order_relaxed) > 0; });
+            if (m_isStopped && m_pending.load(std::memory_order_relaxed) == 0)
+            {
+                return;
+            }
+        }
+    }
+
+private:
+    static inline thread_local thread_pool* t_pool = nullptr;
+    static inline thread_local std::size_t t_index = 0;
+
+    std::vector<std::unique_ptr<TQueue>> m_queues;
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::atomic<std::size_t> m_pending{0};
+    std::atomic<std::size_t> m_next{0};
+    bool m_isStopped = false;
+};
+
+/**
+ * It's an executor which runs a task in the calling thread
+ */
+class inline_executor
+{
+public:
+    void execute(std::function<void()> task)
+    {
+        task();
+    }
+};
+
+/**
+ * It's the executor of the async HOFs by default, a pool with a worker per hardware thread
+ */
+inline thread_pool& default_executor()
+{
+    static thread_pool pool;
+    return pool;
+}
+
+} // namespace optional_ext
+
+namespace optional_detail {
+
+template <typename T>
+struct is_optional_future<optional_ext::optional_future<T>> : public boost::true_type
+{
+};
+
+/**
+ * It's a stage which applies f to the value on the executor
+ * The source optional is captured by value (moved if it's an rvalue), so a referenced value (toRefOp, pointers) has to outlive the future.
+ */
+template <typename TFunctor, typename TExecutor, bool isFlatMap>
+struct TAsyncMap
+{
+    TFunctor f;
+    TExecutor* executor;
+
+    template <typename TOptional>
+    auto operator()(TOptional&& op) const
+    {
+        using TSource = std::decay_t<TOptional>;
+        using TInvocResult = decltype(std::declval<TFunctor&>()(getValue(std::declval<TSource>())));
+        using TValue = async_value_t<pipe_result_t<TSource, TInvocResult>>;
+
+        static_assert(is_flat_map_result<TInvocResult>::value == isFlatMap,
+                      "hof::async_map takes a function which returns a value, hof::async_flat_map takes a function which returns an optional");
+
+        auto state = std::make_shared<TAsyncState<TValue>>();
+        if (!hasValue(op))
+        {
+            state->setValue(boost::none);
+        }
+        else
+        {
+            auto task = std::make_shared<std::pair<TSource, TFunctor>>(std::forward<TOptional>(op), f);
+            executor->execute([task, state]() { setAsyncResult(*state, [&task]() { return std::move(task->first) | task->second; }); });
+        }
+
+        return optional_ext::optional_future<TValue>(std::move(state));
+    }
+};
+
+template <typename TFunctor, typename TExecutor, bool isFlatMap>
+inline decltype(auto) createAsyncHof(TFunctor&& f, TExecutor& executor)
+{
+    return createHof(TAsyncMap<std::decay_t<TFunctor>, TExecutor, isFlatMap>{std::forward<TFunctor>(f), &executor});
+}
+
+} // namespace optional_detail
+
+namespace hof {
+
+/**
+ * It applies a map function to the value of an optional on an executor
+ * @param f is a function that takes the value and returns a new value, it's copied to the task
+ * @param executor is any object with execute(std::function<void()>), it must outlive the task
+ * @return a HOF which returns optional_ext::optional_future
+ *
+ * an example of usage:
+ *
+ *    auto res = toOp(frame)
+ *        | hof::async_map(decompress)
+ *        | hof::filter_if(isValid)
+ *        | parse
+ *        <<= Message{};
+ */
+template <typename TFunctor, typename TExecutor = optional_ext::thread_pool>
+inline decltype(auto) async_map(TFunctor&& f, TExecutor& executor = optional_ext::default_executor())
+{
+    return optional_detail::createAsyncHof<TFunctor, TExecutor, false>(std::forward<TFunctor>(f), executor);
+}
+
+/**
+ * It applies a flat_map function (it returns an optional) to the value of an optional on an executor
+ * @param f is a function that takes the value and returns an optional, it's copied to the task
+ * @param executor is any object with execute(std::function<void()>), it must outlive the task
+ * @return a HOF which returns optional_ext::optional_future
+ */
+template <typename TFunctor, typename TExecutor = optional_ext::thread_pool>
+inline decltype(auto) async_flat_map(TFunctor&& f, TExecutor& executor = optional_ext::default_executor())
+{
+    return optional_detail::createAsyncHof<TFunctor, TExecutor, true>(std::forward<TFunctor>(f), executor);
+}
+
+} // namespace hof
+
+/**
+ * It's a pipe operator for optional_future
+ * It has the same meaning as for boost::optional, the function is applied when the result is ready.
+ * @return a new optional_ext::optional_future
+ */
+template <typename TFuture,
+          typename Functor,
+          typename boost::enable_if_c<optional_detail::is_optional_future<TFuture>::value, int>::type = 0>
+inline auto operator|(TFuture&& fut, Functor&& f)
+{
+    return std::move(fut).then([f = std::decay_t<Functor>(std::forward<Functor>(f))](auto&& op) mutable {
+        return std::forward<decltype(op)>(op) | f;
+    });
+}
+
+/**
+ * It's a pipe operator for applying extractor for optional_future
+ * The function is called if the result is empty, when it's ready.
+ * @return a new optional_ext::optional_future
+ */
+template <typename TFuture,
+          typename Functor,
+          typename boost::enable_if_c<optional_detail::is_optional_future<TFuture>::value, int>::type = 0>
+inline auto operator|=(TFuture&& fut, Functor&& f)
+{
+    return std::move(fut).then([f = std::decay_t<Functor>(std::forward<Functor>(f))](auto&& op) mutable {
+        return std::forward<decltype(op)>(op) |= f;
+    });
+}
+
+/**
+ * It waits for the result of optional_future and extracts the value as operator<<= for boost::optional
+ * @param value is a default value or a function that returns a default value
+ * @return the value or the default
+ */
+template <typename TFuture,
+          typename ValueType,
+          typename boost::enable_if_c<optional_detail::is_optional_future<TFuture>::value, int>::type = 0>
+inline decltype(auto) operator<<=(TFuture&& fut, ValueType&& value)
+{
+    return std::move(fut).get() <<= std::forward<ValueType>(value);
+}
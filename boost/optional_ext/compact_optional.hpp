@@ -0,0 +1,264 @@
+#pragma once
+
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include <boost/none.hpp>
+#include <boost/optional.hpp>
+#include <boost/optional_ext/optional_traits.hpp>
+
+namespace optional_ext {
+
+/**
+ * It's a policy of compact_optional which marks the empty state of a floating point value with NaN
+ * Any NaN is empty, so a map function which returns NaN (e.g. 0.0 / 0.0) gives an empty optional.
+ */
+template <typename T>
+struct nan_policy
+{
+    static_assert(std::is_floating_point<T>::value, "nan_policy takes a floating point type");
+
+    static constexpr T empty_value() noexcept
+    {
+        return std::numeric_limits<T>::quiet_NaN();
+    }
+
+    static constexpr bool is_empty(T value) noexcept
+    {
+        return value != value;
+    }
+};
+
+/**
+ * It's a policy of compact_optional which reserves the value Sentinel for the empty state
+ */
+template <typename T, T Sentinel>
+struct sentinel_policy
+{
+    static_assert(std::is_integral<T>::value || std::is_enum<T>::value, "sentinel_policy takes an integer or an enum, use nan_policy for floating point");
+
+    static constexpr T empty_value() noexcept
+    {
+        return Sentinel;
+    }
+
+    static constexpr bool is_empty(T value) noexcept
+    {
+        return value == Sentinel;
+    }
+};
+
+} // namespace optional_ext
+
+namespace optional_detail {
+
+template <typename T, bool isFloatingPoint = std::is_floating_point<T>::value>
+struct TDefaultCompactPolicy
+{
+    static_assert(std::is_integral<T>::value, "compact_optional of an enum needs an explicit sentinel_policy");
+    using type = optional_ext::sentinel_policy<T, std::numeric_limits<T>::max()>;
+};
+
+template <typename T>
+struct TDefaultCompactPolicy<T, true>
+{
+    using type = optional_ext::nan_policy<T>;
+};
+
+} // namespace optional_detail
+
+namespace optional_ext {
+
+/**
+ * It's NaN for floating point and the maximum value for integers
+ */
+template <typename T>
+using default_compact_policy = typename optional_detail::TDefaultCompactPolicy<T>::type;
+
+/**
+ * It's an optional which takes no more space than the value: the empty state is a reserved value of T (see the policies)
+ * It has the interface of boost::optional and is adapted by optional_traits, so the pipe operators and hof:: keep it
+ * as long as a map function returns T (any other result is kept in boost::optional). An array of compact_optional<double>
+ * is half the size of an array of boost::optional<double>, so twice as many values fit a cache line.
+ * A value equal to the sentinel is indistinguishable from the empty state.
+ * The policy is a stateless type with static constexpr empty_value() and is_empty(value).
+ *
+ * an example of usage:
+ *
+ *    std::vector<optional_ext::compact_optional<double>> readings(count);   // 8 bytes per reading
+ *
+ *    for (const auto& reading : readings)
+ *    {
+ *        acc += reading | hof::filter_if(filter) | [](double el) { return el * scale; } <<= 0.0;
+ *    }
+ */
+template <typename T, typename Policy = default_compact_policy<T>>
+class compact_optional
+{
+    static_assert(std::is_trivially_copyable<T>::value, "compact_optional takes a trivially copyable type");
+
+public:
+    using value_type = T;
+    using policy_type = Policy;
+
+    constexpr compact_optional() noexcept
+        : m_value(Policy::empty_value())
+    {
+    }
+
+    constexpr compact_optional(boost::none_t) noexcept
+        : m_value(Policy::empty_value())
+    {
+    }
+
+    constexpr compact_optional(T value) noexcept
+        : m_value(value)
+    {
+    }
+
+    explicit compact_optional(const boost::optional<T>& op) noexcept
+        : m_value(op ? *op : Policy::empty_value())
+    {
+    }
+
+    constexpr compact_optional& operator=(boost::none_t) noexcept
+    {
+        m_value = Policy::empty_value();
+        return *this;
+    }
+
+    constexpr compact_optional& operator=(T value) noexcept
+    {
+        m_value = value;
+        return *this;
+    }
+
+    constexpr bool has_value() const noexcept
+    {
+        return !Policy::is_empty(m_value);
+    }
+
+    constexpr bool is_initialized() const noexcept
+    {
+        return has_value();
+    }
+
+    constexpr explicit operator bool() const noexcept
+    {
+        return has_value();
+    }
+
+    constexpr bool operator!() const noexcept
+    {
+        return !has_value();
+    }
+
+    constexpr const T& operator*() const& noexcept
+    {
+        return m_value;
+    }
+
+    constexpr T& operator*() & noexcept
+    {
+        return m_value;
+    }
+
+    constexpr T&& operator*() && noexcept
+    {
+        return std::move(m_value);
+    }
+
+    constexpr const T& get() const noexcept
+    {
+        return m_value;
+    }
+
+    constexpr T& get() noexcept
+    {
+        return m_value;
+    }
+
+    // it throws boost::bad_optional_access if the optional is empty
+    constexpr const T& value() const
+    {
+        if (!has_value())
+        {
+            throw boost::bad_optional_access();
+        }
+        return m_value;
+    }
+
+    constexpr T value_or(T other) const noexcept
+    {
+        return has_value() ? m_value : other;
+    }
+
+    constexpr T& emplace(T value) noexcept
+    {
+        m_value = value;
+        return m_value;
+    }
+
+    constexpr void reset() noexcept
+    {
+        m_value = Policy::empty_value();
+    }
+
+    boost::optional<T> to_optional() const noexcept
+    {
+        return has_value() ? boost::optional<T>(m_value) : boost::none;
+    }
+
+    // the empty optionals are equal whatever their stored representation (e.g. different NaNs)
+    friend constexpr bool operator==(const compact_optional& lhs, const compact_optional& rhs) noexcept
+    {
+        return lhs.has_value() == rhs.has_value() && (!lhs.has_value() || lhs.m_value == rhs.m_value);
+    }
+
+    friend constexpr bool operator!=(const compact_optional& lhs, const compact_optional& rhs) noexcept
+    {
+        return !(lhs == rhs);
+    }
+
+    friend constexpr bool operator==(const compact_optional& op, boost::none_t) noexcept
+    {
+        return !op.has_value();
+    }
+
+    friend constexpr bool operator!=(const compact_optional& op, boost::none_t) noexcept
+    {
+        return op.has_value();
+    }
+
+private:
+    T m_value;
+};
+
+/**
+ * A map function which returns T keeps compact_optional, any other result (including a reference) is kept in boost::optional
+ */
+template <typename T, typename Policy>
+struct optional_traits<compact_optional<T, Policy>>
+{
+    static constexpr bool is_optional = true;
+    static constexpr bool is_pointer = false;
+
+    using value_type = T;
+
+    template <typename U>
+    using rebind = std::conditional_t<std::is_same<U, T>::value, compact_optional<T, Policy>, boost::optional<U>>;
+
+    static constexpr bool has_value(const compact_optional<T, Policy>& op) noexcept
+    {
+        return op.has_value();
+    }
+
+    template <typename TOptional>
+    static constexpr decltype(auto) value(TOptional&& op) noexcept
+    {
+        return *std::forward<TOptional>(op);
+    }
+};
+
+} // namespace optional_ext
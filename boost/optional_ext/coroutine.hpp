@@ -0,0 +1,344 @@
+#pragma once
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define OPTIONAL_EXT_HAS_COROUTINES 1
+#endif
+#endif
+
+#ifndef OPTIONAL_EXT_HAS_COROUTINES
+#define OPTIONAL_EXT_HAS_COROUTINES 0
+#endif
+
+#if OPTIONAL_EXT_HAS_COROUTINES
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <boost/optional.hpp>
+#include <boost/optional_ext.hpp>
+
+namespace optional_detail {
+
+/**
+ * It's a per-thread cache of coroutine frames
+ * The frames of optional_coroutine live only during the call, so the same few blocks are reused by every call
+ * instead of going to the global allocator (GCC doesn't elide the allocation, Clang does it only when the call is inlined).
+ * The blocks are grouped by size classes of 64 bytes up to 1KB, larger frames use the global allocator.
+ */
+class TCoroutineFrameCache
+{
+public:
+    static constexpr std::size_t granularity = 64;
+    static constexpr std::size_t size_classes = 16;
+    static constexpr std::size_t capacity = 16;
+
+    static TCoroutineFrameCache& local() noexcept
+    {
+        thread_local TCoroutineFrameCache cache;
+        return cache;
+    }
+
+    TCoroutineFrameCache() = default;
+    TCoroutineFrameCache(const TCoroutineFrameCache&) = delete;
+    TCoroutineFrameCache& operator=(const TCoroutineFrameCache&) = delete;
+
+    ~TCoroutineFrameCache()
+    {
+        for (auto* head : m_free)
+        {
+            while (head)
+            {
+                auto* next = head->next;
+                ::operator delete(head);
+                head = next;
+            }
+        }
+    }
+
+    void* allocate(std::size_t size)
+    {
+        const auto index = (size - 1) / granularity;
+        if (index >= size_classes)
+        {
+            return ::operator new(size);
+        }
+
+        if (auto* block = m_free[index])
+        {
+            m_free[index] = block->next;
+            --m_count[index];
+            return block;
+        }
+
+        return ::operator new((index + 1) * granularity);
+    }
+
+    void deallocate(void* ptr, std::size_t size) noexcept
+    {
+        const auto index = (size - 1) / granularity;
+        if (index >= size_classes || m_count[index] == capacity)
+        {
+            ::operator delete(ptr);
+            return;
+        }
+
+        auto* block = static_cast<TBlock*>(ptr);
+        block->next = m_free[index];
+        m_free[index] = block;
+        ++m_count[index];
+    }
+
+private:
+    struct TBlock
+    {
+        TBlock* next;
+    };
+
+    TBlock* m_free[size_classes] = {};
+    std::size_t m_count[size_classes] = {};
+};
+
+/**
+ * It's an awaiter of an optional-like object (see optional_ext::optional_traits)
+ * It doesn't suspend an engaged optional, an empty one suspends the coroutine for good:
+ * the caller sees that the coroutine isn't done and returns boost::none.
+ */
+template <typename TOptional>
+struct TOptionalAwaiter
+{
+    TOptional&& op;
+
+    bool await_ready() const noexcept
+    {
+        return optional_detail::hasValue(op);
+    }
+
+    void await_suspend(std::coroutine_handle<>) const noexcept
+    {
+    }
+
+    decltype(auto) await_resume() const
+    {
+        if constexpr (std::is_lvalue_reference<TOptional>::value)
+        {
+            return optional_detail::getValue(op);
+        }
+        else
+        {
+            // the value of a temporary optional is moved out, it would dangle otherwise
+            using TValue = std::decay_t<decltype(optional_detail::getValue(std::forward<TOptional>(op)))>;
+            return TValue(optional_detail::getValue(std::forward<TOptional>(op)));
+        }
+    }
+};
+
+/**
+ * It's an awaiter of the result of a nested optional_coroutine, it keeps the result
+ */
+template <typename T>
+struct TOwningOptionalAwaiter
+{
+    boost::optional<T> op;
+
+    bool await_ready() const noexcept
+    {
+        return op.is_initialized();
+    }
+
+    void await_suspend(std::coroutine_handle<>) const noexcept
+    {
+    }
+
+    T await_resume()
+    {
+        return std::move(*op);
+    }
+};
+
+} // namespace optional_detail
+
+namespace optional_ext {
+
+/**
+ * It's a return type of a coroutine which co_awaits optionals
+ * co_await op continues with the value of op or stops the coroutine which then yields boost::none.
+ * The coroutine runs when the result is requested (get() or the conversion to boost::optional),
+ * synchronously and to the end, so its frame is reused through a per-thread cache.
+ * It's several times slower than the same stages chained with operator|, the compiler doesn't elide the frame
+ * (see bench/bench_coroutine.cpp), so it isn't meant for the hottest loops.
+ *
+ * an example of usage:
+ *
+ *    optional_ext::optional_coroutine<Order> makeOrder(const Message& msg)
+ *    {
+ *        const auto& user = co_await findUser(msg.userId);
+ *        const auto price = co_await (toOp(msg.price) | toDouble | hof::filter_if(isPositive));
+ *        const auto qty = co_await parseQty(msg.qty);
+ *        co_return Order{user, price, qty};
+ *    }
+ *
+ *    boost::optional<Order> order = makeOrder(msg);
+ */
+template <typename T>
+class optional_coroutine
+{
+public:
+    class promise_type
+    {
+    public:
+        static void* operator new(std::size_t size)
+        {
+            return optional_detail::TCoroutineFrameCache::local().allocate(size);
+        }
+
+        static void operator delete(void* ptr, std::size_t size) noexcept
+        {
+            optional_detail::TCoroutineFrameCache::local().deallocate(ptr, size);
+        }
+
+        optional_coroutine get_return_object() noexcept
+        {
+            return optional_coroutine(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() const noexcept
+        {
+            return {};
+        }
+
+        std::suspend_always final_suspend() const noexcept
+        {
+            return {};
+        }
+
+        template <typename U>
+        void return_value(U&& value)
+        {
+            if constexpr (std::is_same<std::decay_t<U>, boost::none_t>::value)
+            {
+                m_value = boost::none;
+            }
+            else
+            {
+                m_value.emplace(std::forward<U>(value));
+            }
+        }
+
+        void unhandled_exception() noexcept
+        {
+            m_error = std::current_exception();
+        }
+
+        template <typename TOptional>
+        auto await_transform(TOptional&& op) noexcept
+        {
+            static_assert(optional_detail::is_optional_type<TOptional>::value, "optional_coroutine can co_await only optionals");
+            return optional_detail::TOptionalAwaiter<TOptional>{std::forward<TOptional>(op)};
+        }
+
+        template <typename U>
+        auto await_transform(optional_coroutine<U>&& coroutine)
+        {
+            return optional_detail::TOwningOptionalAwaiter<U>{std::move(coroutine).get()};
+        }
+
+    private:
+        friend class optional_coroutine<T>;
+
+        boost::optional<T> m_value;
+        std::exception_ptr m_error;
+    };
+
+    optional_coroutine(optional_coroutine&& other) noexcept
+        : m_handle(std::exchange(other.m_handle, nullptr))
+    {
+    }
+
+    optional_coroutine& operator=(optional_coroutine&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+        return *this;
+    }
+
+    optional_coroutine(const optional_coroutine&) = delete;
+    optional_coroutine& operator=(const optional_coroutine&) = delete;
+
+    ~optional_coroutine()
+    {
+        reset();
+    }
+
+    /**
+     * It runs the coroutine and returns its result, boost::none if it has awaited an empty optional
+     * An exception thrown by the coroutine is rethrown. A coroutine runs once, a moved-from or already run one gives boost::none.
+     */
+    boost::optional<T> get() &&
+    {
+        struct TFrameGuard
+        {
+            std::coroutine_handle<promise_type> handle;
+            ~TFrameGuard()
+            {
+                if (handle)
+                {
+                    handle.destroy();
+                }
+            }
+        } guard{std::exchange(m_handle, nullptr)};
+
+        if (!guard.handle)
+        {
+            return boost::none;
+        }
+
+        guard.handle.resume();
+        if (!guard.handle.done())
+        {
+            return boost::none;
+        }
+
+        auto& promise = guard.handle.promise();
+        if (promise.m_error)
+        {
+            std::rethrow_exception(promise.m_error);
+        }
+
+        return std::move(promise.m_value);
+    }
+
+    operator boost::optional<T>() &&
+    {
+        return std::move(*this).get();
+    }
+
+private:
+    explicit optional_coroutine(std::coroutine_handle<promise_type> handle) noexcept
+        : m_handle(handle)
+    {
+    }
+
+    void reset() noexcept
+    {
+        if (m_handle)
+        {
+            m_handle.destroy();
+            m_handle = nullptr;
+        }
+    }
+
+private:
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+} // namespace optional_ext
+
+#endif // OPTIONAL_EXT_HAS_COROUTINES
@@ -0,0 +1,249 @@
+#pragma once
+
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#if __has_include(<version>)
+#include <version>
+#endif
+
+#if defined(__cpp_lib_expected)
+#include <expected>
+#endif
+
+#include <boost/optional_ext.hpp>
+#include <boost/optional_ext/optional_traits.hpp>
+
+namespace optional_ext {
+
+/**
+ * It's an error wrapped to construct optional_ext::expected, see make_unexpected
+ */
+template <typename E>
+struct unexpected
+{
+    E error;
+};
+
+template <typename E>
+constexpr unexpected<std::decay_t<E>> make_unexpected(E&& error)
+{
+    return {std::forward<E>(error)};
+}
+
+/**
+ * It's an optional-like value which carries an error instead of being empty
+ * The pipe operators and hof:: pass the error of an empty source on: a map or flat_map function isn't called,
+ * |=, <<= and the none handlers of hof::match/hof::match_none may take the error. The value-initialized error E{}
+ * stands for "no value" (a value rejected by hof::filter_if, an empty boost::optional source), so an error code enum
+ * should reserve 0 for it. A default-constructed expected holds E{}.
+ * T may be an lvalue reference, e.g. the result of hof::project. Nothing is allocated: the value or the error is kept in place.
+ *
+ * an example of usage:
+ *
+ *    enum class reason : std::uint8_t { no_value, negative };
+ *
+ *    optional_ext::expected<double, reason> checkSign(double value)
+ *    {
+ *        return value >= 0.0 ? optional_ext::expected<double, reason>(value) : optional_ext::make_unexpected(reason::negative);
+ *    }
+ *
+ *    acc += toOp(data) | hof::try_parse<double>() | checkSign |= [&errors](auto error) { errors.count(error); return 0.0; } <<= 0.0;
+ */
+template <typename T, typename E>
+class expected
+{
+    static_assert(!std::is_rvalue_reference<T>::value, "optional_ext::expected can't hold an rvalue reference");
+
+    using TStorage = std::conditional_t<std::is_lvalue_reference<T>::value, std::reference_wrapper<std::remove_reference_t<T>>, T>;
+    using TReference = std::conditional_t<std::is_lvalue_reference<T>::value, T, T&>;
+    using TConstReference = std::conditional_t<std::is_lvalue_reference<T>::value, T, const T&>;
+    using TRvalueReference = std::conditional_t<std::is_lvalue_reference<T>::value, T, T&&>;
+
+public:
+    using value_type = T;
+    using error_type = E;
+
+    constexpr expected() noexcept(std::is_nothrow_default_constructible<E>::value)
+        : m_storage(std::in_place_index<1>, E{})
+    {
+    }
+
+    template <typename U,
+              typename = std::enable_if_t<std::is_constructible<TStorage, U&&>::value
+                                          && !std::is_same<std::decay_t<U>, expected>::value
+                                          && !std::is_same<std::decay_t<U>, unexpected<E>>::value>>
+    constexpr expected(U&& value) noexcept(std::is_nothrow_constructible<TStorage, U&&>::value)
+        : m_storage(std::in_place_index<0>, std::forward<U>(value))
+    {
+    }
+
+    template <typename G, typename = std::enable_if_t<std::is_constructible<E, const G&>::value>>
+    constexpr expected(const unexpected<G>& error) noexcept(std::is_nothrow_constructible<E, const G&>::value)
+        : m_storage(std::in_place_index<1>, error.error)
+    {
+    }
+
+    template <typename G, typename = std::enable_if_t<std::is_constructible<E, G&&>::value>>
+    constexpr expected(unexpected<G>&& error) noexcept(std::is_nothrow_constructible<E, G&&>::value)
+        : m_storage(std::in_place_index<1>, std::move(error.error))
+    {
+    }
+
+    constexpr bool has_value() const noexcept
+    {
+        return m_storage.index() == 0;
+    }
+
+    constexpr explicit operator bool() const noexcept
+    {
+        return has_value();
+    }
+
+    constexpr TReference operator*() & noexcept
+    {
+        return *std::get_if<0>(&m_storage);
+    }
+
+    constexpr TConstReference operator*() const& noexcept
+    {
+        return *std::get_if<0>(&m_storage);
+    }
+
+    constexpr TRvalueReference operator*() && noexcept
+    {
+        return static_cast<TRvalueReference>(*std::get_if<0>(&m_storage));
+    }
+
+    constexpr std::remove_reference_t<TReference>* operator->() noexcept
+    {
+        return std::addressof(**this);
+    }
+
+    constexpr std::remove_reference_t<TConstReference>* operator->() const noexcept
+    {
+        return std::addressof(**this);
+    }
+
+    // it throws std::bad_variant_access if there is an error
+    constexpr TReference value() &
+    {
+        return std::get<0>(m_storage);
+    }
+
+    constexpr TConstReference value() const&
+    {
+        return std::get<0>(m_storage);
+    }
+
+    constexpr TRvalueReference value() &&
+    {
+        return static_cast<TRvalueReference>(std::get<0>(m_storage));
+    }
+
+    // it's valid only if there is no value
+    constexpr const E& error() const noexcept
+    {
+        return *std::get_if<1>(&m_storage);
+    }
+
+    template <typename U>
+    constexpr std::remove_cv_t<std::remove_reference_t<T>> value_or(U&& other) const&
+    {
+        return has_value() ? **this : static_cast<std::remove_cv_t<std::remove_reference_t<T>>>(std::forward<U>(other));
+    }
+
+    friend constexpr bool operator==(const expected& lhs, const expected& rhs)
+    {
+        if (lhs.has_value() != rhs.has_value())
+        {
+            return false;
+        }
+        return lhs.has_value() ? *lhs == *rhs : lhs.error() == rhs.error();
+    }
+
+    friend constexpr bool operator!=(const expected& lhs, const expected& rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+private:
+    std::variant<TStorage, E> m_storage;
+};
+
+template <typename T, typename E>
+struct optional_traits<expected<T, E>>
+{
+    static constexpr bool is_optional = true;
+    static constexpr bool is_pointer = false;
+
+    using value_type = T;
+    using error_type = E;
+
+    template <typename U>
+    using rebind = expected<U, E>;
+
+    static constexpr bool has_value(const expected<T, E>& op) noexcept
+    {
+        return op.has_value();
+    }
+
+    template <typename TOptional>
+    static constexpr decltype(auto) value(TOptional&& op) noexcept
+    {
+        return *std::forward<TOptional>(op);
+    }
+
+    static constexpr const E& error(const expected<T, E>& op) noexcept
+    {
+        return op.error();
+    }
+
+    static constexpr expected<T, E> make_error(const E& error)
+    {
+        return unexpected<E>{error};
+    }
+};
+
+#if defined(__cpp_lib_expected)
+/**
+ * std::expected can't hold a reference, so a map function which returns a reference produces optional_ext::expected<U&, E>
+ */
+template <typename T, typename E>
+struct optional_traits<std::expected<T, E>>
+{
+    static constexpr bool is_optional = true;
+    static constexpr bool is_pointer = false;
+
+    using value_type = T;
+    using error_type = E;
+
+    template <typename U>
+    using rebind = std::conditional_t<std::is_reference<U>::value, expected<U, E>, std::expected<U, E>>;
+
+    static constexpr bool has_value(const std::expected<T, E>& op) noexcept
+    {
+        return op.has_value();
+    }
+
+    template <typename TOptional>
+    static constexpr decltype(auto) value(TOptional&& op) noexcept
+    {
+        return *std::forward<TOptional>(op);
+    }
+
+    static constexpr const E& error(const std::expected<T, E>& op) noexcept
+    {
+        return op.error();
+    }
+
+    static constexpr std::expected<T, E> make_error(const E& error)
+    {
+        return std::unexpected<E>(error);
+    }
+};
+#endif
+
+} // namespace optional_ext
@@ -0,0 +1,422 @@
+#pragma once
+
+/**
+ * Per-stage instrumentation of the operators and hof:: combinators
+ * It's enabled by defining OPTIONAL_EXT_INSTRUMENTATION=1 for the whole program (it changes inline functions,
+ * so all translation units have to agree). When it's disabled the probes in boost/optional_ext.hpp expand to nothing.
+ * When it's enabled every call takes two clock reads, and the results of flat_map stages and hof::pipeline are moved once more.
+ * With OPTIONAL_EXT_TRACING=1 every call is also recorded as a slice of the timeline, see boost/optional_ext/tracing.hpp.
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <boost/core/typeinfo.hpp>
+#include <boost/optional_ext/optional_traits.hpp>
+#include <boost/optional_ext/tracing.hpp>
+
+namespace optional_ext {
+
+/**
+ * It's a kind of an instrumented stage
+ * A stage is identified by its kind and the type of its function, hof::pipeline is measured as a whole.
+ */
+enum class stage_kind
+{
+    map,
+    flat_map,
+    or_else,
+    value_or,
+    filter_if,
+    filter_if_not,
+    match,
+    match_some,
+    match_none,
+    pipeline
+};
+
+inline const char* to_string(stage_kind kind) noexcept
+{
+    switch (kind)
+    {
+    case stage_kind::map:
+        return "map";
+    case stage_kind::flat_map:
+        return "flat_map";
+    case stage_kind::or_else:
+        return "or_else";
+    case stage_kind::value_or:
+        return "value_or";
+    case stage_kind::filter_if:
+        return "filter_if";
+    case stage_kind::filter_if_not:
+        return "filter_if_not";
+    case stage_kind::match:
+        return "match";
+    case stage_kind::match_some:
+        return "match_some";
+    case stage_kind::match_none:
+        return "match_none";
+    case stage_kind::pipeline:
+        return "pipeline";
+    }
+
+    return "unknown";
+}
+
+// the bucket i > 0 counts the calls which took [2^(i-1), 2^i) ns, the bucket 0 the calls under 1ns
+constexpr std::size_t latency_buckets = 32;
+
+/**
+ * It's an aggregate of a stage over all threads
+ * some/none are the engaged/empty results (for |= and <<= whether the source was engaged),
+ * the calls which return a future or a plain value of a pipeline are counted only in calls.
+ */
+struct stage_stats
+{
+    stage_kind kind = stage_kind::map;
+    std::string name;
+    std::uint64_t calls = 0;
+    std::uint64_t some = 0;
+    std::uint64_t none = 0;
+    std::array<std::uint64_t, latency_buckets> latency{};
+
+    double some_ratio() const noexcept
+    {
+        return some + none > 0 ? static_cast<double>(some) / static_cast<double>(some + none) : 0.0;
+    }
+
+    // it's an upper bound of the q-quantile of the latency in ns, the resolution is a power of two
+    std::uint64_t latency_quantile(double q) const noexcept
+    {
+        const auto target = static_cast<std::uint64_t>(q * static_cast<double>(calls));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < latency_buckets; ++i)
+        {
+            seen += latency[i];
+            if (seen > target || (seen == calls && seen > 0))
+            {
+                return std::uint64_t(1) << i;
+            }
+        }
+
+        return 0;
+    }
+};
+
+} // namespace optional_ext
+
+namespace optional_detail {
+
+struct TStageCounters
+{
+    std::atomic<std::uint64_t> calls{0};
+    std::atomic<std::uint64_t> some{0};
+    std::atomic<std::uint64_t> none{0};
+    std::array<std::atomic<std::uint64_t>, optional_ext::latency_buckets> latency{};
+};
+
+// the counters are written only by the owning thread, so a relaxed load and store are enough and cost no RMW
+inline void bumpCounter(std::atomic<std::uint64_t>& counter) noexcept
+{
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+/**
+ * It's a block of counters of one thread, it's allocated by chunks when the thread meets a new stage
+ * The blocks are owned by the registry and outlive their threads, so the counts of finished threads are kept.
+ */
+class TThreadCounters
+{
+public:
+    static constexpr std::size_t chunk_size = 64;
+    static constexpr std::size_t max_chunks = 64;
+
+    ~TThreadCounters()
+    {
+        for (auto& chunk : m_chunks)
+        {
+            delete[] chunk.load(std::memory_order_relaxed);
+        }
+    }
+
+    // it's called only by the owning thread, it returns nullptr for more than chunk_size * max_chunks stages
+    TStageCounters* get(std::size_t id)
+    {
+        const auto index = id / chunk_size;
+        if (index >= max_chunks)
+        {
+            return nullptr;
+        }
+
+        auto* chunk = m_chunks[index].load(std::memory_order_relaxed);
+        if (!chunk)
+        {
+            chunk = new TStageCounters[chunk_size];
+            m_chunks[index].store(chunk, std::memory_order_release);
+        }
+
+        return chunk + id % chunk_size;
+    }
+
+    // it's called by any thread
+    const TStageCounters* find(std::size_t id) const noexcept
+    {
+        const auto index = id / chunk_size;
+        if (index >= max_chunks)
+        {
+            return nullptr;
+        }
+
+        const auto* chunk = m_chunks[index].load(std::memory_order_acquire);
+        return chunk ? chunk + id % chunk_size : nullptr;
+    }
+
+private:
+    std::array<std::atomic<TStageCounters*>, max_chunks> m_chunks{};
+};
+
+class TInstrumentationRegistry
+{
+public:
+    // it's never destroyed, threads may record after the static destructors have run
+    static TInstrumentationRegistry& instance()
+    {
+        static auto* registry = new TInstrumentationRegistry();
+        return *registry;
+    }
+
+    std::size_t registerStage(optional_ext::stage_kind kind, std::string name)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stages.push_back({kind, std::move(name), {}});
+        return m_stages.size() - 1;
+    }
+
+    TThreadCounters& local()
+    {
+        thread_local TThreadCounters* counters = nullptr;
+        if (!counters)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_threads.push_back(std::make_unique<TThreadCounters>());
+            counters = m_threads.back().get();
+        }
+
+        return *counters;
+    }
+
+    std::vector<optional_ext::stage_stats> collect()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        std::vector<optional_ext::stage_stats> ret;
+        ret.reserve(m_stages.size());
+        for (std::size_t id = 0; id < m_stages.size(); ++id)
+        {
+            auto stats = sum(id);
+            subtract(stats, m_stages[id].baseline);
+            stats.kind = m_stages[id].kind;
+            stats.name = m_stages[id].name;
+            ret.push_back(std::move(stats));
+        }
+
+        return ret;
+    }
+
+    // the counters aren't touched, the current values become the baseline of collect()
+    void reset()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (std::size_t id = 0; id < m_stages.size(); ++id)
+        {
+            m_stages[id].baseline = sum(id);
+        }
+    }
+
+private:
+    struct TStage
+    {
+        optional_ext::stage_kind kind;
+        std::string name;
+        optional_ext::stage_stats baseline;
+    };
+
+    optional_ext::stage_stats sum(std::size_t id) const
+    {
+        optional_ext::stage_stats ret;
+        for (const auto& thread : m_threads)
+        {
+            if (const auto* counters = thread->find(id))
+            {
+                ret.calls += counters->calls.load(std::memory_order_relaxed);
+                ret.some += counters->some.load(std::memory_order_relaxed);
+                ret.none += counters->none.load(std::memory_order_relaxed);
+                for (std::size_t i = 0; i < optional_ext::latency_buckets; ++i)
+                {
+                    ret.latency[i] += counters->latency[i].load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        return ret;
+    }
+
+    static void subtract(optional_ext::stage_stats& stats, const optional_ext::stage_stats& baseline) noexcept
+    {
+        stats.calls -= baseline.calls;
+        stats.some -= baseline.some;
+        stats.none -= baseline.none;
+        for (std::size_t i = 0; i < optional_ext::latency_buckets; ++i)
+        {
+            stats.latency[i] -= baseline.latency[i];
+        }
+    }
+
+private:
+    std::mutex m_mutex;
+    std::vector<TStage> m_stages;
+    std::vector<std::unique_ptr<TThreadCounters>> m_threads;
+};
+
+// the name lives as long as the program, so the trace events keep only a pointer to it
+template <optional_ext::stage_kind Kind, typename TStage>
+const std::string& stageName()
+{
+    static const std::string name = boost::core::demangled_name(BOOST_CORE_TYPEID(TStage));
+    return name;
+}
+
+template <optional_ext::stage_kind Kind, typename TStage>
+std::size_t stageId()
+{
+    static const std::size_t id = TInstrumentationRegistry::instance().registerStage(Kind, stageName<Kind, TStage>());
+    return id;
+}
+
+/**
+ * It's a probe of one call of a stage, it counts the call and its latency when it goes out of scope
+ * The outcome is set by the operator: explicitly or from the returned optional by finish().
+ */
+template <optional_ext::stage_kind Kind, typename TStage>
+class TStageProbe
+{
+public:
+    TStageProbe()
+        : m_counters(TInstrumentationRegistry::instance().local().get(stageId<Kind, TStage>()))
+        , m_start(std::chrono::steady_clock::now())
+    {
+    }
+
+    TStageProbe(const TStageProbe&) = delete;
+    TStageProbe& operator=(const TStageProbe&) = delete;
+
+    ~TStageProbe()
+    {
+        auto ns = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count());
+
+#if OPTIONAL_EXT_TRACING
+        auto& tracing = TTraceRegistry::instance();
+        if (tracing.isEnabled())
+        {
+            tracing.record(stageName<Kind, TStage>().c_str(), optional_ext::to_string(Kind), tracing.toNs(m_start), ns, 0, 'X');
+        }
+#endif
+
+        if (!m_counters)
+        {
+            return;
+        }
+
+        std::size_t bucket = 0;
+        while (ns > 0 && bucket + 1 < optional_ext::latency_buckets)
+        {
+            ns >>= 1;
+            ++bucket;
+        }
+
+        bumpCounter(m_counters->calls);
+        bumpCounter(m_counters->latency[bucket]);
+    }
+
+    void outcome(bool isSome) noexcept
+    {
+        if (m_counters)
+        {
+            bumpCounter(isSome ? m_counters->some : m_counters->none);
+        }
+    }
+
+    // it passes the result through, an optional result sets the outcome
+    template <typename TResult>
+    TResult finish(TResult&& result)
+    {
+        using TTraits = optional_ext::optional_traits<std::remove_cv_t<std::remove_reference_t<TResult>>>;
+        if constexpr (TTraits::is_optional)
+        {
+            outcome(TTraits::has_value(result));
+        }
+
+        return std::forward<TResult>(result);
+    }
+
+private:
+    TStageCounters* m_counters;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+} // namespace optional_detail
+
+namespace optional_ext {
+
+/**
+ * It returns the statistics of all stages met so far by any thread (since the last reset_stage_stats)
+ */
+inline std::vector<stage_stats> collect_stage_stats()
+{
+    return optional_detail::TInstrumentationRegistry::instance().collect();
+}
+
+inline void reset_stage_stats()
+{
+    optional_detail::TInstrumentationRegistry::instance().reset();
+}
+
+/**
+ * It prints a table of the stages which were called: calls, some ratio, p50/p99 latency and the type of the function
+ */
+inline void dump_stage_stats(std::ostream& out)
+{
+    auto stats = collect_stage_stats();
+    std::sort(stats.begin(), stats.end(), [](const stage_stats& lhs, const stage_stats& rhs) { return lhs.calls > rhs.calls; });
+
+    out << std::left << std::setw(14) << "stage" << std::right << std::setw(12) << "calls" << std::setw(8) << "some%" << std::setw(10)
+        << "p50 ns" << std::setw(10) << "p99 ns" << "  function" << std::endl;
+
+    for (const auto& el : stats)
+    {
+        if (el.calls == 0)
+        {
+            continue;
+        }
+
+        out << std::left << std::setw(14) << to_string(el.kind) << std::right << std::setw(12) << el.calls << std::setw(8) << std::fixed
+            << std::setprecision(1) << el.some_ratio() * 100.0 << std::setw(10) << el.latency_quantile(0.5) << std::setw(10)
+            << el.latency_quantile(0.99) << "  " << el.name << std::endl;
+    }
+}
+
+} // namespace optional_ext
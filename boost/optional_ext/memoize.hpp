@@ -0,0 +1,464 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <boost/optional.hpp>
+#include <boost/optional_ext.hpp>
+
+namespace optional_ext {
+
+/**
+ * It's a snapshot of the statistics of a memoized stage
+ * The lookups of an empty optional aren't counted, they never reach the cache.
+ */
+struct memoize_stats
+{
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t evictions = 0;
+    std::size_t size = 0;
+
+    double hit_ratio() const noexcept
+    {
+        return hits + misses > 0 ? static_cast<double>(hits) / static_cast<double>(hits + misses) : 0.0;
+    }
+
+    memoize_stats& operator+=(const memoize_stats& other) noexcept
+    {
+        hits += other.hits;
+        misses += other.misses;
+        evictions += other.evictions;
+        size += other.size;
+        return *this;
+    }
+};
+
+} // namespace optional_ext
+
+namespace optional_detail {
+
+/**
+ * It's a key of the cache: the owned type which is stored and the type which is used for the lookup
+ * A string is looked up by std::basic_string_view, so a hit doesn't copy the key of the input.
+ */
+template <typename T>
+struct TMemoizeKey
+{
+    using owned = T;
+    using view = T;
+};
+
+template <typename C, typename Traits, typename Alloc>
+struct TMemoizeKey<std::basic_string<C, Traits, Alloc>>
+{
+    using owned = std::basic_string<C, Traits, Alloc>;
+    using view = std::basic_string_view<C, Traits>;
+};
+
+template <typename C, typename Traits>
+struct TMemoizeKey<std::basic_string_view<C, Traits>>
+{
+    using owned = std::basic_string<C, Traits>;
+    using view = std::basic_string_view<C, Traits>;
+};
+
+// the argument of a function which isn't overloaded, it's void for generic lambdas
+template <typename F, typename = void>
+struct TMemoizeArgument
+{
+    using type = void;
+};
+
+template <typename R, typename A>
+struct TMemoizeArgument<R (*)(A), void>
+{
+    using type = A;
+};
+
+template <typename R, typename A>
+struct TMemoizeArgument<R (*)(A) noexcept, void>
+{
+    using type = A;
+};
+
+template <typename TMember>
+struct TMemoizeMemberArgument
+{
+    using type = void;
+};
+
+template <typename R, typename C, typename A>
+struct TMemoizeMemberArgument<R (C::*)(A)>
+{
+    using type = A;
+};
+
+template <typename R, typename C, typename A>
+struct TMemoizeMemberArgument<R (C::*)(A) const>
+{
+    using type = A;
+};
+
+template <typename R, typename C, typename A>
+struct TMemoizeMemberArgument<R (C::*)(A) noexcept>
+{
+    using type = A;
+};
+
+template <typename R, typename C, typename A>
+struct TMemoizeMemberArgument<R (C::*)(A) const noexcept>
+{
+    using type = A;
+};
+
+template <typename F>
+struct TMemoizeArgument<F, std::void_t<decltype(&F::operator())>> : TMemoizeMemberArgument<decltype(&F::operator())>
+{
+};
+
+template <typename TKey, typename F>
+using memoize_key_t = std::conditional_t<std::is_void<TKey>::value,
+                                         std::decay_t<typename TMemoizeArgument<std::decay_t<F>>::type>,
+                                         TKey>;
+
+// it's the cached result: a flat_map function is cached with its outcome, an error-carrying one (e.g. hof::try_parse)
+// with its error, a map function always gives an engaged value
+template <typename TResult, bool isFlatMap = is_flat_map_result<TResult>::value, bool isErrorCarrying = is_error_carrying<TResult>::value>
+struct TMemoizeValue
+{
+    using type = boost::optional<std::decay_t<TResult>>;
+};
+
+template <typename TResult>
+struct TMemoizeValue<TResult, true, false>
+{
+    using type = boost::optional<std::decay_t<typename optional_traits_t<TResult>::value_type>>;
+};
+
+template <typename TResult>
+struct TMemoizeValue<TResult, true, true>
+{
+    using type = typename optional_traits_t<TResult>::template rebind<std::decay_t<typename optional_traits_t<TResult>::value_type>>;
+};
+
+/**
+ * It's a bounded cache with the CLOCK policy, it isn't thread-safe
+ * A hit only sets the reference bit of its entry, an insertion into the full cache sweeps the hand
+ * over the entries clearing the bits and replaces the first entry which wasn't referenced since the last sweep.
+ * The entries are allocated once, the index refers to the keys stored in them.
+ */
+template <typename TKey, typename TMapped>
+class TClockCache
+{
+public:
+    using key_type = typename TMemoizeKey<TKey>::owned;
+    using view_type = typename TMemoizeKey<TKey>::view;
+    using mapped_type = TMapped;
+
+    explicit TClockCache(std::size_t capacity)
+        : m_capacity(std::max<std::size_t>(capacity, 1))
+    {
+        m_entries.reserve(m_capacity);
+        m_index.reserve(m_capacity);
+    }
+
+    const mapped_type* find(const view_type& key)
+    {
+        const auto it = m_index.find(key);
+        if (it == m_index.end())
+        {
+            ++m_stats.misses;
+            return nullptr;
+        }
+
+        ++m_stats.hits;
+        auto& entry = m_entries[it->second];
+        entry.isReferenced = true;
+        return &entry.value;
+    }
+
+    // it returns the cached value if the key was inserted meanwhile
+    const mapped_type& insert(const view_type& key, mapped_type value)
+    {
+        const auto it = m_index.find(key);
+        if (it != m_index.end())
+        {
+            return m_entries[it->second].value;
+        }
+
+        std::size_t slot = m_entries.size();
+        if (slot < m_capacity)
+        {
+            m_entries.push_back({key_type(key), std::move(value), false});
+        }
+        else
+        {
+            slot = evict();
+            auto& entry = m_entries[slot];
+            entry.key = key_type(key);
+            entry.value = std::move(value);
+            entry.isReferenced = false;
+        }
+
+        m_index.emplace(view_type(m_entries[slot].key), slot);
+        return m_entries[slot].value;
+    }
+
+    optional_ext::memoize_stats stats() const noexcept
+    {
+        auto ret = m_stats;
+        ret.size = m_entries.size();
+        return ret;
+    }
+
+private:
+    struct TEntry
+    {
+        key_type key;
+        mapped_type value;
+        bool isReferenced;
+    };
+
+    std::size_t evict()
+    {
+        while (m_entries[m_hand].isReferenced)
+        {
+            m_entries[m_hand].isReferenced = false;
+            m_hand = m_hand + 1 == m_capacity ? 0 : m_hand + 1;
+        }
+
+        const auto slot = m_hand;
+        m_hand = m_hand + 1 == m_capacity ? 0 : m_hand + 1;
+
+        m_index.erase(view_type(m_entries[slot].key));
+        ++m_stats.evictions;
+        return slot;
+    }
+
+private:
+    const std::size_t m_capacity;
+    std::vector<TEntry> m_entries;
+    std::unordered_map<view_type, std::size_t> m_index;
+    std::size_t m_hand = 0;
+    optional_ext::memoize_stats m_stats;
+};
+
+/**
+ * It's a cache split into shards by the hash of the key, every shard is a TClockCache with its own mutex
+ * The function isn't called under the lock, two threads which miss the same key may both call it, the first result is kept.
+ */
+template <typename TKey, typename TMapped>
+class TShardedClockCache
+{
+public:
+    using TShard = TClockCache<TKey, TMapped>;
+    using view_type = typename TShard::view_type;
+    using mapped_type = typename TShard::mapped_type;
+
+    TShardedClockCache(std::size_t capacity, std::size_t shards)
+    {
+        const auto count = std::max<std::size_t>(shards, 1);
+        m_shards.reserve(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            m_shards.push_back(std::make_unique<TLockedShard>((capacity + count - 1) / count));
+        }
+    }
+
+    template <typename TCompute>
+    mapped_type get(const view_type& key, TCompute&& compute)
+    {
+        auto& shard = *m_shards[std::hash<view_type>()(key) % m_shards.size()];
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            if (const auto* value = shard.cache.find(key))
+            {
+                return *value;
+            }
+        }
+
+        auto value = compute();
+
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return shard.cache.insert(key, std::move(value));
+    }
+
+    optional_ext::memoize_stats stats() const
+    {
+        optional_ext::memoize_stats ret;
+        for (const auto& shard : m_shards)
+        {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            ret += shard->cache.stats();
+        }
+        return ret;
+    }
+
+private:
+    // the shards are taken by different threads, so every one is on its own cache lines
+    struct alignas(64) TLockedShard
+    {
+        explicit TLockedShard(std::size_t capacity)
+            : cache(capacity)
+        {
+        }
+
+        mutable std::mutex mutex;
+        TShard cache;
+    };
+
+    std::vector<std::unique_ptr<TLockedShard>> m_shards;
+};
+
+template <typename TKey, typename TMapped>
+class TLocalClockCache
+{
+public:
+    using view_type = typename TClockCache<TKey, TMapped>::view_type;
+    using mapped_type = typename TClockCache<TKey, TMapped>::mapped_type;
+
+    explicit TLocalClockCache(std::size_t capacity)
+        : m_cache(capacity)
+    {
+    }
+
+    template <typename TCompute>
+    const mapped_type& get(const view_type& key, TCompute&& compute)
+    {
+        if (const auto* value = m_cache.find(key))
+        {
+            return *value;
+        }
+
+        return m_cache.insert(key, compute());
+    }
+
+    optional_ext::memoize_stats stats() const noexcept
+    {
+        return m_cache.stats();
+    }
+
+private:
+    TClockCache<TKey, TMapped> m_cache;
+};
+
+/**
+ * It's a stage which caches the results of a map or flat_map function by its argument, boost::none and errors included
+ * The cache is shared by the copies of the stage (e.g. the one moved into hof::pipeline), so stats() of any copy sees all calls.
+ */
+template <typename TKey, typename TFunctor, template <typename, typename> class TCache>
+struct TMemoize
+{
+    using TResult = decltype(std::declval<const TFunctor&>()(std::declval<const TKey&>()));
+    using TMapped = typename TMemoizeValue<TResult>::type;
+    using TStorage = TCache<TKey, TMapped>;
+    using view_type = typename TStorage::view_type;
+
+    TFunctor f;
+    std::shared_ptr<TStorage> cache;
+
+    // the error of an error-carrying input is passed on, as the other stages do
+    template <typename TOptional>
+    TMapped operator()(TOptional&& op) const
+    {
+        if (!optional_detail::hasValue(op))
+        {
+            return makeNone<TMapped>(op);
+        }
+
+        const auto& value = optional_detail::getValue(op);
+        const view_type key(value);
+        return cache->get(key, [this, &value]() -> TMapped {
+            if constexpr (is_flat_map_result<TResult>::value)
+            {
+                auto res = call(value);
+                if (optional_detail::hasValue(res))
+                {
+                    return TMapped(optional_detail::getValue(std::move(res)));
+                }
+                return makeNone<TMapped>(res);
+            }
+            else
+            {
+                return TMapped(call(value));
+            }
+        });
+    }
+
+    optional_ext::memoize_stats stats() const
+    {
+        return cache->stats();
+    }
+
+private:
+    // a view (e.g. std::string_view for a function of std::string) is converted to the key only on a miss
+    template <typename TArg>
+    TResult call(const TArg& value) const
+    {
+        if constexpr (std::is_invocable<const TFunctor&, const TArg&>::value)
+        {
+            return f(value);
+        }
+        else
+        {
+            return f(TKey(value));
+        }
+    }
+};
+
+} // namespace optional_detail
+
+namespace hof {
+
+/**
+ * It caches the results of a map or flat_map function, the empty results are cached too
+ * The cache keeps up to capacity entries and evicts by the CLOCK (second chance) policy, a string key is looked up
+ * by std::string_view, so the input isn't copied on a hit. It's for one thread, see hof::concurrent_memoize.
+ * @tparam TKey is the stored key, by default the argument type of f (it must be given for a generic lambda)
+ * @return a higher order function which returns boost::optional of the result (an error-carrying result, e.g. of hof::try_parse,
+ *         keeps its type and its error is cached too) and has stats()
+ *
+ * an example of usage:
+ *
+ *    auto toDouble = hof::memoize(expensiveParse, 1024);
+ *    acc += toOp(data) | toDouble | hof::filter_if(filter) <<= 0.0;
+ *    std::cout << toDouble.stats().hit_ratio();
+ */
+template <typename TKey = void, typename TFunctor>
+inline decltype(auto) memoize(TFunctor&& f, std::size_t capacity)
+{
+    using TMemoKey = optional_detail::memoize_key_t<TKey, TFunctor>;
+    static_assert(!std::is_void<TMemoKey>::value, "hof::memoize can't deduce the key of an overloaded function, give it as hof::memoize<Key>");
+
+    using TStage = optional_detail::TMemoize<TMemoKey, std::decay_t<TFunctor>, optional_detail::TLocalClockCache>;
+    return optional_detail::createHof(
+        TStage{std::forward<TFunctor>(f), std::make_shared<typename TStage::TStorage>(capacity)});
+}
+
+/**
+ * It's hof::memoize which can be called from many threads, the cache is split into shards with their own locks
+ * The copies of the stage share the cache, e.g. the copies of a pipeline run by the workers of services::CShardedConsumer.
+ */
+template <typename TKey = void, typename TFunctor>
+inline decltype(auto) concurrent_memoize(TFunctor&& f, std::size_t capacity, std::size_t shards = 16)
+{
+    using TMemoKey = optional_detail::memoize_key_t<TKey, TFunctor>;
+    static_assert(!std::is_void<TMemoKey>::value, "hof::concurrent_memoize can't deduce the key of an overloaded function, give it as hof::concurrent_memoize<Key>");
+
+    using TStage = optional_detail::TMemoize<TMemoKey, std::decay_t<TFunctor>, optional_detail::TShardedClockCache>;
+    return optional_detail::createHof(
+        TStage{std::forward<TFunctor>(f), std::make_shared<typename TStage::TStorage>(capacity, shards)});
+}
+
+} // namespace hof
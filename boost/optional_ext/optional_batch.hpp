@@ -0,0 +1,492 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <boost/optional.hpp>
+#include <boost/optional_ext.hpp>
+#include <boost/optional_ext/simd_filter.hpp>
+
+namespace optional_ext {
+
+/**
+ * It's a struct-of-arrays batch of optionals: a contiguous array of values and a packed validity bitmap
+ * The values of empty slots are default-constructed (or stale after filtering) and must not be observed.
+ * The pipe operators process the whole batch at once:
+ *   - map and flat_map functions are applied only to engaged values,
+ *   - hof::filter_if/hof::filter_if_not only clear bits, the values are not moved,
+ *   - operator<<= fills the empty slots with a default in one pass.
+ *
+ * an example of usage:
+ *
+ *    optional_ext::optional_batch<double> batch(readings);
+ *
+ *    std::vector<double> values = std::move(batch)
+ *        | hof::filter_if([](double el) { return el >= 0.0 && el <= 50.0; })
+ *        <<= 0.0;
+ */
+template <typename T>
+class optional_batch
+{
+public:
+    using value_type = T;
+    using word_type = std::uint64_t;
+
+    static constexpr std::size_t word_bits = 64;
+
+    optional_batch() = default;
+
+    /**
+     * It creates a batch of the given size where all slots are empty
+     */
+    explicit optional_batch(std::size_t size)
+        : m_values(size)
+        , m_validity(wordCount(size), 0)
+    {
+    }
+
+    /**
+     * It creates a batch where all slots are engaged
+     */
+    explicit optional_batch(std::vector<T> values)
+        : m_values(std::move(values))
+        , m_validity(wordCount(m_values.size()), ~word_type(0))
+    {
+        clearTail();
+    }
+
+    std::size_t size() const noexcept
+    {
+        return m_values.size();
+    }
+
+    bool empty() const noexcept
+    {
+        return m_values.empty();
+    }
+
+    /**
+     * @return a number of engaged slots
+     */
+    std::size_t count() const noexcept
+    {
+        std::size_t ret = 0;
+        for (auto bits : m_validity)
+        {
+            for (; bits != 0; bits &= bits - 1)
+            {
+                ret += 1;
+            }
+        }
+
+        return ret;
+    }
+
+    bool has_value(std::size_t index) const noexcept
+    {
+        return ((m_validity[index / word_bits] >> (index % word_bits)) & 1) != 0;
+    }
+
+    boost::optional<const T&> operator[](std::size_t index) const
+    {
+        return has_value(index) ? boost::optional<const T&>(m_values[index]) : boost::none;
+    }
+
+    boost::optional<T&> operator[](std::size_t index)
+    {
+        return has_value(index) ? boost::optional<T&>(m_values[index]) : boost::none;
+    }
+
+    void set(std::size_t index, T value)
+    {
+        m_values[index] = std::move(value);
+        m_validity[index / word_bits] |= word_type(1) << (index % word_bits);
+    }
+
+    void reset(std::size_t index) noexcept
+    {
+        m_validity[index / word_bits] &= ~(word_type(1) << (index % word_bits));
+    }
+
+    void reserve(std::size_t size)
+    {
+        m_values.reserve(size);
+        m_validity.reserve(wordCount(size));
+    }
+
+    void push_back(T value)
+    {
+        m_values.push_back(std::move(value));
+        m_validity.resize(wordCount(m_values.size()), 0);
+
+        const auto index = m_values.size() - 1;
+        m_validity[index / word_bits] |= word_type(1) << (index % word_bits);
+    }
+
+    void push_back(boost::none_t)
+    {
+        m_values.emplace_back();
+        m_validity.resize(wordCount(m_values.size()), 0);
+    }
+
+    void push_back(const boost::optional<T>& op)
+    {
+        if (op)
+        {
+            push_back(op.get());
+        }
+        else
+        {
+            push_back(boost::none);
+        }
+    }
+
+    /**
+     * The raw values, including the values of empty slots
+     */
+    const std::vector<T>& values() const& noexcept
+    {
+        return m_values;
+    }
+
+    std::vector<T>& values() & noexcept
+    {
+        return m_values;
+    }
+
+    std::vector<T> values() &&
+    {
+        return std::move(m_values);
+    }
+
+    /**
+     * The validity bitmap: the bit (index % 64) of the word (index / 64) is set for an engaged slot
+     * The bits after size() are always zero.
+     */
+    const std::vector<word_type>& validity() const noexcept
+    {
+        return m_validity;
+    }
+
+    std::vector<word_type>& validity() noexcept
+    {
+        return m_validity;
+    }
+
+    /**
+     * @return the mask of the bits of the given word that belong to the batch
+     */
+    word_type word_mask(std::size_t word) const noexcept
+    {
+        const auto tail = m_values.size() - word * word_bits;
+        return tail >= word_bits ? ~word_type(0) : (word_type(1) << tail) - 1;
+    }
+
+private:
+    static std::size_t wordCount(std::size_t size) noexcept
+    {
+        return (size + word_bits - 1) / word_bits;
+    }
+
+    void clearTail() noexcept
+    {
+        if (!m_validity.empty())
+        {
+            m_validity.back() &= word_mask(m_validity.size() - 1);
+        }
+    }
+
+private:
+    std::vector<T> m_values;
+    std::vector<word_type> m_validity;
+};
+
+} // namespace optional_ext
+
+namespace optional_detail {
+
+template <typename T>
+struct is_optional_batch : public boost::false_type
+{
+};
+
+template <typename T>
+struct is_optional_batch<optional_ext::optional_batch<T>> : public boost::true_type
+{
+};
+
+template <typename T>
+struct is_batch_filter : public boost::false_type
+{
+};
+
+template <typename TPred>
+struct is_batch_filter<THigherOrderFunction<TFilterIf<TPred>>> : public boost::true_type
+{
+    static constexpr bool is_negated = false;
+};
+
+template <typename TPred>
+struct is_batch_filter<THigherOrderFunction<TFilterIfNot<TPred>>> : public boost::true_type
+{
+    static constexpr bool is_negated = true;
+};
+
+template <typename TBatch, typename TValue>
+decltype(auto) forwardBatchValue(TValue& value) noexcept
+{
+    if constexpr (std::is_lvalue_reference<TBatch>::value)
+    {
+        return static_cast<const TValue&>(value);
+    }
+    else
+    {
+        return std::move(value);
+    }
+}
+
+/**
+ * It calls fn(index) for every engaged slot, a fully engaged word is processed without bit checks
+ */
+template <typename TBatch, typename TFunctor>
+void forEachEngaged(const TBatch& batch, TFunctor&& fn)
+{
+    const auto& validity = batch.validity();
+    for (std::size_t word = 0; word < validity.size(); ++word)
+    {
+        const auto bits = validity[word];
+        const auto first = word * TBatch::word_bits;
+
+        if (bits == ~typename TBatch::word_type(0))
+        {
+            for (std::size_t i = 0; i < TBatch::word_bits; ++i)
+            {
+                fn(first + i);
+            }
+        }
+        else if (bits != 0)
+        {
+            for (std::size_t i = 0; i < TBatch::word_bits; ++i)
+            {
+                if ((bits >> i) & 1)
+                {
+                    fn(first + i);
+                }
+            }
+        }
+    }
+}
+
+// clang-format off
+template <typename TBatch, typename TStage>
+auto filterBatch(TBatch&& batch, TStage& stage)
+{
+    using TRes = std::decay_t<TBatch>;
+    constexpr bool isNegated = is_batch_filter<std::decay_t<TStage>>::is_negated;
+
+    TRes ret(std::forward<TBatch>(batch));
+    const auto& values = ret.values();
+    auto& validity = ret.validity();
+
+    using TPred = std::decay_t<decltype(stage.pred)>;
+    if constexpr (std::is_same<TPred, optional_ext::range_predicate<typename TRes::value_type>>::value)
+    {
+        // a range predicate is evaluated by the SIMD kernel selected at runtime
+        const auto kernel = selectMaskKernel(stage.pred, optional_ext::active_simd_level());
+        for (std::size_t word = 0; word < validity.size(); ++word)
+        {
+            if (validity[word] != 0)
+            {
+                const auto first = word * TRes::word_bits;
+                const auto keep = kernel(stage.pred, values.data() + first, std::min(TRes::word_bits, values.size() - first));
+                validity[word] &= isNegated ? ~keep : keep;
+            }
+        }
+
+        return ret;
+    }
+
+    // the predicate sees only engaged values as with operator| for boost::optional, the values of empty slots may be stale
+    forEachEngaged(ret, [&ret, &values, &stage](std::size_t i) {
+        if (static_cast<bool>(stage.pred(values[i])) == isNegated)
+        {
+            ret.reset(i);
+        }
+    });
+
+    return ret;
+}
+// clang-format on
+
+template <typename TBatch, typename TStage>
+auto fusedStageBatch(TBatch&& batch, TStage& stage)
+{
+    using TRes = std::decay_t<TBatch>;
+
+    TRes ret(std::forward<TBatch>(batch));
+    auto& values = ret.values();
+
+    for (std::size_t i = 0; i < ret.size(); ++i)
+    {
+        const auto isSome = ret.has_value(i)
+            ? stage.some(values[i], [](auto&&) { return true; }, []() { return false; })
+            : stage.template none<typename TRes::value_type>([]() { return false; });
+
+        if (!isSome)
+        {
+            ret.reset(i);
+        }
+    }
+
+    return ret;
+}
+
+template <typename TBatch, typename TStage>
+auto hofBatch(TBatch&& batch, TStage& stage)
+{
+    using TValue = typename std::decay_t<TBatch>::value_type;
+    using TRefOptional = boost::optional<const TValue&>;
+    using TInvocResult = decltype(stage(std::declval<TRefOptional>()));
+    using TResValue = std::decay_t<typename std::decay_t<TInvocResult>::value_type>;
+
+    const auto& source = batch;
+    optional_ext::optional_batch<TResValue> ret(source.size());
+    for (std::size_t i = 0; i < source.size(); ++i)
+    {
+        auto&& res = stage(source[i]);
+        if (res)
+        {
+            ret.set(i, *std::forward<decltype(res)>(res));
+        }
+    }
+
+    return ret;
+}
+
+template <typename TBatch, typename TFunctor>
+auto mapBatch(TBatch&& batch, TFunctor& f)
+{
+    using TValue = typename std::decay_t<TBatch>::value_type;
+    using TInvocResult = decltype(f(forwardBatchValue<TBatch>(std::declval<TValue&>())));
+
+    if constexpr (is_flat_map_result<TInvocResult>::value)
+    {
+        using TResValue = std::decay_t<typename optional_traits_t<TInvocResult>::value_type>;
+
+        optional_ext::optional_batch<TResValue> ret(batch.size());
+        auto& values = batch.values();
+        forEachEngaged(batch, [&](std::size_t i) {
+            auto res = f(forwardBatchValue<TBatch>(values[i]));
+            if (optional_detail::hasValue(res))
+            {
+                ret.set(i, optional_detail::getValue(std::move(res)));
+            }
+        });
+
+        return ret;
+    }
+    else
+    {
+        using TResValue = std::decay_t<TInvocResult>;
+
+        optional_ext::optional_batch<TResValue> ret(batch.size());
+        auto& resValues = ret.values();
+        auto& values = batch.values();
+        forEachEngaged(batch, [&](std::size_t i) { resValues[i] = f(forwardBatchValue<TBatch>(values[i])); });
+        ret.validity() = batch.validity();
+
+        return ret;
+    }
+}
+
+} // namespace optional_detail
+
+/**
+ * It's a pipe operator for optional_batch
+ * It has the same meaning as the pipe operator for boost::optional applied to every slot of the batch
+ * @param batch is an optional_ext::optional_batch<T>
+ * @param f is a map/flat_map function or a HOF
+ * @return a new optional_ext::optional_batch
+ *
+ * The predicates of hof::filter_if/hof::filter_if_not are evaluated only for the engaged slots.
+ * An optional_ext::range_predicate (optional_ext::between, optional_ext::less, ...) is evaluated with SIMD
+ * for all slots of a word that has an engaged slot, it has no side effects and is safe for any arithmetic value.
+ */
+template <typename TBatch,
+          typename Functor,
+          typename boost::enable_if_c<optional_detail::is_optional_batch<std::decay_t<TBatch>>::value, int>::type = 0>
+inline auto operator|(TBatch&& batch, Functor&& f)
+{
+    using TStage = std::decay_t<Functor>;
+
+    if constexpr (optional_detail::is_batch_filter<TStage>::value)
+    {
+        return optional_detail::filterBatch(std::forward<TBatch>(batch), f);
+    }
+    else if constexpr (optional_detail::is_fused_stage<TStage>::value)
+    {
+        return optional_detail::fusedStageBatch(std::forward<TBatch>(batch), f);
+    }
+    else if constexpr (optional_detail::is_higher_order_function<TStage>::value)
+    {
+        return optional_detail::hofBatch(std::forward<TBatch>(batch), f);
+    }
+    else
+    {
+        return optional_detail::mapBatch(std::forward<TBatch>(batch), f);
+    }
+}
+
+/**
+ * It's an extractor for optional_batch
+ * The empty slots are filled by the default value (or by the result of the given function) in one pass
+ * @param batch is an optional_ext::optional_batch<T>
+ * @param value is a default value or a function that returns a default value
+ * @return std::vector<T>
+ */
+template <typename TBatch,
+          typename ValueType,
+          typename boost::enable_if_c<optional_detail::is_optional_batch<std::decay_t<TBatch>>::value, int>::type = 0>
+inline auto operator<<=(TBatch&& batch, ValueType&& value)
+{
+    using TBatchType = std::decay_t<TBatch>;
+    using TValue = typename TBatchType::value_type;
+
+    // only the values are moved out of an rvalue batch, so the bitmap stays valid,
+    // the masks of the words are computed from the size of the moved values (the batch is empty after the move)
+    using word_type = typename TBatchType::word_type;
+    const auto& validity = static_cast<const TBatchType&>(batch).validity();
+    std::vector<TValue> ret = std::forward<TBatch>(batch).values();
+
+    for (std::size_t word = 0; word < validity.size(); ++word)
+    {
+        const auto first = word * TBatchType::word_bits;
+        const auto last = std::min(first + TBatchType::word_bits, ret.size());
+        const auto bits = validity[word];
+        const auto mask = last - first == TBatchType::word_bits ? ~word_type(0) : (word_type(1) << (last - first)) - 1;
+
+        if (bits == mask)
+        {
+            continue;
+        }
+
+        for (std::size_t i = first; i < last; ++i)
+        {
+            if (((bits >> (i - first)) & 1) == 0)
+            {
+                if constexpr (type_traits::is_callable<ValueType>::value)
+                {
+                    ret[i] = value();
+                }
+                else
+                {
+                    ret[i] = value;
+                }
+            }
+        }
+    }
+
+    return ret;
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <type_traits>
+
+#include <boost/optional.hpp>
+
+namespace optional_detail {
+
+/**
+ * It's a common part of the traits of pointers: a null pointer is an empty optional and the pointee is never moved from
+ * A map function which returns a reference produces a raw pointer, any other result is kept in boost::optional.
+ */
+template <typename TPointer, typename T>
+struct TPointerTraits
+{
+    static constexpr bool is_optional = true;
+    static constexpr bool is_pointer = true;
+
+    using value_type = T;
+
+    template <typename U>
+    using rebind = std::conditional_t<std::is_lvalue_reference<U>::value, std::remove_reference_t<U>*, boost::optional<U>>;
+
+    static constexpr bool has_value(const TPointer& op) noexcept
+    {
+        return static_cast<bool>(op);
+    }
+
+    static constexpr T& value(const TPointer& op) noexcept
+    {
+        return *op;
+    }
+};
+
+} // namespace optional_detail
+
+namespace optional_ext {
+
+/**
+ * It's a customization point which adapts an optional-like type to the pipe operators, toRefOp and hof::
+ * The type is used as is, it isn't converted to boost::optional. A specialization provides:
+ *   is_optional   - true,
+ *   is_pointer    - true if the type refers to a value owned by someone else (a stage which returns it is a map, not a flat_map),
+ *   value_type    - the type of the contained value,
+ *   rebind<U>     - the optional-like type which holds the result U of a map function (U may be a reference),
+ *   has_value(op) - it returns true if op isn't empty,
+ *   value(op)     - it returns the contained value and keeps the value category of op.
+ * A default-constructed object of the type has to be empty.
+ * An error-carrying type (see boost/optional_ext/expected.hpp) also provides:
+ *   error_type        - the type of the error, its value-initialized object stands for "no value",
+ *   error(op)         - it returns the error of an empty op,
+ *   make_error(error) - it returns an empty object of the type with the error.
+ *
+ * an example of usage:
+ *
+ *    namespace optional_ext {
+ *
+ *    template <typename T>
+ *    struct optional_traits<my::maybe<T>>
+ *    {
+ *        static constexpr bool is_optional = true;
+ *        static constexpr bool is_pointer = false;
+ *
+ *        using value_type = T;
+ *
+ *        template <typename U>
+ *        using rebind = my::maybe<U>;
+ *
+ *        static bool has_value(const my::maybe<T>& op) noexcept { return !op.empty(); }
+ *
+ *        template <typename TOptional>
+ *        static decltype(auto) value(TOptional&& op) noexcept { return std::forward<TOptional>(op).unsafe_get(); }
+ *    };
+ *
+ *    } // namespace optional_ext
+ */
+template <typename T, typename = void>
+struct optional_traits
+{
+    static constexpr bool is_optional = false;
+    static constexpr bool is_pointer = false;
+};
+
+template <typename T>
+struct optional_traits<boost::optional<T>>
+{
+    static constexpr bool is_optional = true;
+    static constexpr bool is_pointer = false;
+
+    using value_type = T;
+
+    template <typename U>
+    using rebind = boost::optional<U>;
+
+    static constexpr bool has_value(const boost::optional<T>& op) noexcept
+    {
+        return op.is_initialized();
+    }
+
+    template <typename TOptional>
+    static constexpr decltype(auto) value(TOptional&& op) noexcept
+    {
+        return *std::forward<TOptional>(op);
+    }
+};
+
+/**
+ * std::optional can't hold a reference, so a map function which returns a reference produces boost::optional<U&>
+ */
+template <typename T>
+struct optional_traits<std::optional<T>>
+{
+    static constexpr bool is_optional = true;
+    static constexpr bool is_pointer = false;
+
+    using value_type = T;
+
+    template <typename U>
+    using rebind = std::conditional_t<std::is_reference<U>::value, boost::optional<U>, std::optional<U>>;
+
+    static constexpr bool has_value(const std::optional<T>& op) noexcept
+    {
+        return op.has_value();
+    }
+
+    template <typename TOptional>
+    static constexpr decltype(auto) value(TOptional&& op) noexcept
+    {
+        return *std::forward<TOptional>(op);
+    }
+};
+
+template <typename T>
+struct optional_traits<T*, std::enable_if_t<!std::is_void<T>::value && !std::is_function<T>::value>> : optional_detail::TPointerTraits<T*, T>
+{
+};
+
+template <typename T, typename TDeleter>
+struct optional_traits<std::unique_ptr<T, TDeleter>> : optional_detail::TPointerTraits<std::unique_ptr<T, TDeleter>, T>
+{
+};
+
+template <typename T>
+struct optional_traits<std::shared_ptr<T>> : optional_detail::TPointerTraits<std::shared_ptr<T>, T>
+{
+};
+
+} // namespace optional_ext
@@ -0,0 +1,331 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include <boost/optional.hpp>
+#include <boost/optional_ext.hpp>
+#include <boost/optional_ext/async.hpp>
+
+/**
+ * OPTIONAL_EXT_STD_EXECUTION=1 makes optional_ext::transform and optional_ext::for_each accept the policies of <execution>
+ * It's off by default: libstdc++ runs them on TBB, so a program which includes <execution> has to link it.
+ */
+#ifndef OPTIONAL_EXT_STD_EXECUTION
+#define OPTIONAL_EXT_STD_EXECUTION 0
+#endif
+
+#if OPTIONAL_EXT_STD_EXECUTION
+#include <execution>
+#endif
+
+namespace optional_ext {
+namespace execution {
+
+struct sequenced_policy
+{
+};
+
+/**
+ * It's a policy which splits a range into chunks and runs them on an executor, the calling thread runs chunks too
+ * @param executor is any object with execute(std::function<void()>), nullptr means optional_ext::default_executor()
+ * @param chunk is a number of elements of a task, 0 means about 4 chunks per worker and at least min_chunk elements
+ */
+template <typename TExecutor = thread_pool>
+struct parallel_policy
+{
+    static constexpr std::size_t min_chunk = 1024;
+
+    TExecutor* executor = nullptr;
+    std::size_t chunk = 0;
+
+    template <typename TOther>
+    parallel_policy<TOther> on(TOther& other) const noexcept
+    {
+        return {&other, chunk};
+    }
+
+    parallel_policy with_chunk(std::size_t size) const noexcept
+    {
+        return {executor, size};
+    }
+};
+
+inline constexpr sequenced_policy seq{};
+inline constexpr parallel_policy<> par{};
+
+} // namespace execution
+} // namespace optional_ext
+
+namespace optional_detail {
+
+template <typename T>
+struct is_parallel_policy : public std::false_type
+{
+};
+
+template <typename TExecutor>
+struct is_parallel_policy<optional_ext::execution::parallel_policy<TExecutor>> : public std::true_type
+{
+};
+
+template <typename T, typename = void>
+struct is_std_execution_policy : public std::false_type
+{
+};
+
+#if OPTIONAL_EXT_STD_EXECUTION
+template <typename T>
+struct is_std_execution_policy<T, std::enable_if_t<std::is_execution_policy_v<T>>> : public std::true_type
+{
+};
+#endif
+
+/**
+ * It applies a stage to an optional as operator| does, a pipeline is called instead: it may have a terminal value
+ */
+template <typename TStage, typename TOptional>
+decltype(auto) applyStage(TStage& stage, TOptional&& op)
+{
+    if constexpr (is_pipeline<std::decay_t<TStage>>::value)
+    {
+        return stage(std::forward<TOptional>(op));
+    }
+    else
+    {
+        return std::forward<TOptional>(op) | stage;
+    }
+}
+
+/**
+ * It applies a stage to an element of a range,
+ * an element which isn't an optional is passed as boost::optional of a reference (or of the value for a prvalue)
+ */
+template <typename TStage, typename TElement>
+decltype(auto) applyChain(TStage& stage, TElement&& element)
+{
+    if constexpr (is_optional_type<std::decay_t<TElement>>::value)
+    {
+        return applyStage(stage, std::forward<TElement>(element));
+    }
+    else if constexpr (std::is_lvalue_reference<TElement>::value)
+    {
+        return applyStage(stage, boost::optional<std::remove_reference_t<TElement>&>(element));
+    }
+    else
+    {
+        return applyStage(stage, boost::optional<std::decay_t<TElement>>(std::forward<TElement>(element)));
+    }
+}
+
+template <typename TExecutor>
+std::size_t executorConcurrency(const TExecutor& executor) noexcept
+{
+    if constexpr (std::is_same<TExecutor, optional_ext::thread_pool>::value)
+    {
+        return executor.size();
+    }
+    else
+    {
+        (void)executor;
+        return std::max<std::size_t>(1, std::thread::hardware_concurrency());
+    }
+}
+
+/**
+ * It calls chunk(begin, end) for the chunks of [0, size) on the executor and the calling thread and waits for them
+ * The chunks are claimed from a shared counter, so a helper task which starts late (or never, when the calling thread
+ * is a busy worker of the same pool) doesn't delay the others. The first exception is rethrown when all chunks are done.
+ */
+template <typename TExecutor, typename TChunk>
+void runChunks(const optional_ext::execution::parallel_policy<TExecutor>& policy, std::size_t size, TChunk& chunk)
+{
+    auto& executor = [&policy]() -> TExecutor& {
+        if constexpr (std::is_same<TExecutor, optional_ext::thread_pool>::value)
+        {
+            return policy.executor ? *policy.executor : optional_ext::default_executor();
+        }
+        else
+        {
+            return *policy.executor;
+        }
+    }();
+
+    const auto workers = executorConcurrency(executor);
+    const auto chunkSize = policy.chunk > 0 ? policy.chunk : std::max(policy.min_chunk, (size + workers * 4 - 1) / (workers * 4));
+    const auto chunks = (size + chunkSize - 1) / chunkSize;
+    if (chunks <= 1)
+    {
+        chunk(std::size_t(0), size);
+        return;
+    }
+
+    // the state outlives the call: a helper which starts after the last chunk only reads the counter and exits
+    struct TShared
+    {
+        std::atomic<std::size_t> next{0};
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::size_t done = 0;
+        std::exception_ptr error;
+    };
+    auto shared = std::make_shared<TShared>();
+
+    auto work = [shared, &chunk, size, chunkSize, chunks]() {
+        for (auto i = shared->next.fetch_add(1, std::memory_order_relaxed); i < chunks; i = shared->next.fetch_add(1, std::memory_order_relaxed))
+        {
+            std::exception_ptr error;
+            try
+            {
+                chunk(i * chunkSize, std::min(size, (i + 1) * chunkSize));
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+
+            std::lock_guard<std::mutex> lock(shared->mutex);
+            if (error && !shared->error)
+            {
+                shared->error = error;
+            }
+            if (++shared->done == chunks)
+            {
+                shared->cv.notify_all();
+            }
+        }
+    };
+
+    for (std::size_t i = 0; i < std::min(workers, chunks - 1); ++i)
+    {
+        executor.execute(work);
+    }
+    work();
+
+    std::unique_lock<std::mutex> lock(shared->mutex);
+    shared->cv.wait(lock, [&shared, chunks]() { return shared->done == chunks; });
+    if (shared->error)
+    {
+        std::rethrow_exception(shared->error);
+    }
+}
+
+} // namespace optional_detail
+
+namespace optional_ext {
+
+/**
+ * It applies a stage to every element of [first, last) and writes the results to out, as std::transform does
+ * The elements are optionals or plain values (those are passed as boost::optional of a reference), the stage is anything
+ * which can follow operator|: a map or flat_map function, a hof:: combinator or hof::pipeline.
+ * With execution::par every chunk runs on its own copy of the stage, so a stage which shares state between the copies
+ * (e.g. hof::memoize or a sink) has to be thread-safe (hof::concurrent_memoize, a sink into optional_ext::combinable).
+ * The parallel policies need random access iterators.
+ * @return the end of the output range
+ *
+ * an example of usage:
+ *
+ *    std::vector<double> values(texts.size());
+ *    optional_ext::transform(optional_ext::execution::par, texts.begin(), texts.end(), values.begin(),
+ *                            hof::pipeline(hof::parse<double>(), hof::filter_if(filter)) <<= 0.0);
+ */
+template <typename TPolicy, typename TInputIt, typename TOutputIt, typename TStage>
+TOutputIt transform(TPolicy&& policy, TInputIt first, TInputIt last, TOutputIt out, TStage&& stage)
+{
+    using TPolicyType = std::decay_t<TPolicy>;
+
+    if constexpr (std::is_same<TPolicyType, execution::sequenced_policy>::value)
+    {
+        for (; first != last; ++first, ++out)
+        {
+            *out = optional_detail::applyChain(stage, *first);
+        }
+        return out;
+    }
+    else if constexpr (optional_detail::is_parallel_policy<TPolicyType>::value)
+    {
+        static_assert(std::is_base_of<std::random_access_iterator_tag, typename std::iterator_traits<TInputIt>::iterator_category>::value
+                          && std::is_base_of<std::random_access_iterator_tag, typename std::iterator_traits<TOutputIt>::iterator_category>::value,
+                      "the parallel transform needs random access iterators");
+
+        const auto size = static_cast<std::size_t>(std::distance(first, last));
+        auto chunk = [&stage, first, out](std::size_t begin, std::size_t end) {
+            auto local = stage;
+            for (auto i = begin; i < end; ++i)
+            {
+                out[i] = optional_detail::applyChain(local, first[i]);
+            }
+        };
+        optional_detail::runChunks(policy, size, chunk);
+        return out + size;
+    }
+    else
+    {
+        static_assert(optional_detail::is_std_execution_policy<TPolicyType>::value,
+                      "it's an unknown execution policy (the policies of <execution> need OPTIONAL_EXT_STD_EXECUTION=1)");
+
+        return std::transform(std::forward<TPolicy>(policy), first, last, out, [&stage](auto&& element) {
+            auto local = stage;
+            return optional_detail::applyChain(local, std::forward<decltype(element)>(element));
+        });
+    }
+}
+
+/**
+ * It applies a stage to every element of [first, last) for its side effects, e.g. a chain which ends with sinks
+ * The requirements are the ones of optional_ext::transform.
+ *
+ * an example of usage:
+ *
+ *    optional_ext::combinable<optional_ext::sum_aggregate<double>> total;
+ *    optional_ext::for_each(optional_ext::execution::par, texts.begin(), texts.end(),
+ *                           hof::pipeline(hof::parse<double>(), hof::sum_into(total)));
+ */
+template <typename TPolicy, typename TInputIt, typename TStage>
+void for_each(TPolicy&& policy, TInputIt first, TInputIt last, TStage&& stage)
+{
+    using TPolicyType = std::decay_t<TPolicy>;
+
+    if constexpr (std::is_same<TPolicyType, execution::sequenced_policy>::value)
+    {
+        for (; first != last; ++first)
+        {
+            optional_detail::applyChain(stage, *first);
+        }
+    }
+    else if constexpr (optional_detail::is_parallel_policy<TPolicyType>::value)
+    {
+        static_assert(std::is_base_of<std::random_access_iterator_tag, typename std::iterator_traits<TInputIt>::iterator_category>::value,
+                      "the parallel for_each needs random access iterators");
+
+        auto chunk = [&stage, first](std::size_t begin, std::size_t end) {
+            auto local = stage;
+            for (auto i = begin; i < end; ++i)
+            {
+                optional_detail::applyChain(local, first[i]);
+            }
+        };
+        optional_detail::runChunks(policy, static_cast<std::size_t>(std::distance(first, last)), chunk);
+    }
+    else
+    {
+        static_assert(optional_detail::is_std_execution_policy<TPolicyType>::value,
+                      "it's an unknown execution policy (the policies of <execution> need OPTIONAL_EXT_STD_EXECUTION=1)");
+
+        std::for_each(std::forward<TPolicy>(policy), first, last, [&stage](auto&& element) {
+            auto local = stage;
+            optional_detail::applyChain(local, std::forward<decltype(element)>(element));
+        });
+    }
+}
+
+} // namespace optional_ext
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+#if !defined(__cpp_lib_to_chars)
+#include <locale.h>
+#if defined(__APPLE__)
+#include <xlocale.h>
+#endif
+#endif
+
+#include <boost/optional.hpp>
+#include <boost/optional_ext.hpp>
+#include <boost/optional_ext/expected.hpp>
+
+namespace optional_ext {
+
+/**
+ * It's a set of options of hof::parse, they can be combined with |
+ *   strict  - the whole text must be a number, nothing is skipped,
+ *   trim    - the leading and trailing whitespace is skipped,
+ *   partial - a number at the beginning of the text is enough, the rest is ignored.
+ */
+enum class parse_flags : unsigned
+{
+    strict = 0,
+    trim = 1,
+    partial = 2
+};
+
+constexpr parse_flags operator|(parse_flags lhs, parse_flags rhs) noexcept
+{
+    return static_cast<parse_flags>(static_cast<unsigned>(lhs) | static_cast<unsigned>(rhs));
+}
+
+/**
+ * It's the reason why hof::try_parse has no value
+ *   no_value            - there was no text (an empty source) or the value was filtered out later in the chain,
+ *   invalid             - the text isn't a number,
+ *   out_of_range        - the number doesn't fit the type,
+ *   trailing_characters - the number is followed by a text (see parse_flags::partial).
+ */
+enum class parse_error : std::uint8_t
+{
+    no_value = 0,
+    invalid,
+    out_of_range,
+    trailing_characters
+};
+
+} // namespace optional_ext
+
+namespace optional_detail {
+
+constexpr bool hasParseFlag(optional_ext::parse_flags flags, optional_ext::parse_flags flag) noexcept
+{
+    return (static_cast<unsigned>(flags) & static_cast<unsigned>(flag)) != 0;
+}
+
+inline bool isParseSpace(char ch) noexcept
+{
+    return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r' || ch == '\f' || ch == '\v';
+}
+
+#if !defined(__cpp_lib_to_chars)
+// strtod reads the decimal point of the global locale, the number is read in the "C" locale instead
+inline double strtodClassic(const char* text, char** end) noexcept
+{
+#if defined(_WIN32)
+    static const _locale_t classic = _create_locale(LC_ALL, "C");
+    return _strtod_l(text, end, classic);
+#else
+    static const locale_t classic = newlocale(LC_ALL_MASK, "C", locale_t(0));
+    return strtod_l(text, end, classic);
+#endif
+}
+#endif
+
+/**
+ * It's a flat_map stage which parses a number from a text with std::from_chars
+ * It doesn't throw, allocate or look at the locale, a text which isn't a number (or is out of range) gives boost::none.
+ * A leading '+' is accepted like boost::lexical_cast does, std::from_chars alone rejects it.
+ * TTryParse shares the parser and keeps the reason of a failure.
+ */
+template <typename T>
+struct TParse
+{
+    static_assert(std::is_arithmetic<T>::value && !std::is_same<T, bool>::value, "hof::parse supports integers and floating point");
+
+    optional_ext::parse_flags flags;
+    int base;
+
+    boost::optional<T> operator()(std::string_view text) const noexcept
+    {
+        T value{};
+        optional_ext::parse_error error{};
+        if (!parse(text, value, error))
+        {
+            return boost::none;
+        }
+
+        return value;
+    }
+
+    // it returns whether the text is a number, the reason of a failure is written to error
+    bool parse(std::string_view text, T& value, optional_ext::parse_error& error) const noexcept
+    {
+        const char* first = text.data();
+        const char* last = text.data() + text.size();
+
+        if (hasParseFlag(flags, optional_ext::parse_flags::trim))
+        {
+            while (first != last && isParseSpace(*first))
+            {
+                ++first;
+            }
+            while (first != last && isParseSpace(*(last - 1)))
+            {
+                --last;
+            }
+        }
+
+        if (last - first > 1 && *first == '+' && *(first + 1) != '-')
+        {
+            ++first;
+        }
+
+        const auto [ptr, ec] = fromChars(first, last, value);
+        if (ec == std::errc::result_out_of_range)
+        {
+            error = optional_ext::parse_error::out_of_range;
+            return false;
+        }
+        if (ec != std::errc())
+        {
+            error = optional_ext::parse_error::invalid;
+            return false;
+        }
+        if (ptr != last && !hasParseFlag(flags, optional_ext::parse_flags::partial))
+        {
+            error = optional_ext::parse_error::trailing_characters;
+            return false;
+        }
+
+        return true;
+    }
+
+private:
+    std::from_chars_result fromChars(const char* first, const char* last, T& value) const noexcept
+    {
+        if constexpr (std::is_integral<T>::value)
+        {
+            return std::from_chars(first, last, value, base);
+        }
+#if defined(__cpp_lib_to_chars)
+        else
+        {
+            return std::from_chars(first, last, value, std::chars_format::general);
+        }
+#else
+        else
+        {
+            // std::from_chars for floating point isn't available, strtod needs a terminated copy
+            char buffer[128];
+            const auto size = static_cast<std::size_t>(last - first);
+            if (size == 0 || size >= sizeof(buffer) || isParseSpace(*first))
+            {
+                return {first, std::errc::invalid_argument};
+            }
+
+            std::char_traits<char>::copy(buffer, first, size);
+            buffer[size] = '\0';
+
+            char* end = nullptr;
+            errno = 0;
+            value = static_cast<T>(strtodClassic(buffer, &end));
+            if (end == buffer)
+            {
+                return {first, std::errc::invalid_argument};
+            }
+
+            return {first + (end - buffer), errno == ERANGE ? std::errc::result_out_of_range : std::errc()};
+        }
+#endif
+    }
+};
+
+template <typename T>
+struct TTryParse
+{
+    TParse<T> parser;
+
+    optional_ext::expected<T, optional_ext::parse_error> operator()(std::string_view text) const noexcept
+    {
+        T value{};
+        optional_ext::parse_error error{};
+        if (!parser.parse(text, value, error))
+        {
+            return optional_ext::make_unexpected(error);
+        }
+
+        return value;
+    }
+};
+
+} // namespace optional_detail
+
+namespace hof {
+
+/**
+ * It parses a number from a string (or anything convertible to std::string_view) without exceptions
+ * @param flags are optional_ext::parse_flags, by default the whole text must be a number
+ * @param base is a base of integers, it's ignored for floating point
+ * @return a flat_map function which returns boost::optional<T>
+ *
+ * an example of usage:
+ *
+ *    acc += toOp(data)
+ *        | hof::parse<double>(optional_ext::parse_flags::trim)
+ *        | hof::filter_if(filter)
+ *        <<= 0.0;
+ */
+template <typename T>
+inline optional_detail::TParse<T> parse(optional_ext::parse_flags flags = optional_ext::parse_flags::strict, int base = 10) noexcept
+{
+    return optional_detail::TParse<T>{flags, base};
+}
+
+/**
+ * It parses a number as hof::parse does but keeps the reason of a failure
+ * The result carries optional_ext::parse_error instead of being empty, the next stages pass it on
+ * and |=, <<=, hof::match and hof::match_none may take it (see optional_ext::expected).
+ * @param flags are optional_ext::parse_flags, by default the whole text must be a number
+ * @param base is a base of integers, it's ignored for floating point
+ * @return a flat_map function which returns optional_ext::expected<T, optional_ext::parse_error>
+ *
+ * an example of usage:
+ *
+ *    acc += toOp(data)
+ *        | hof::try_parse<double>()
+ *        | hof::match_none([&errors](optional_ext::parse_error error) { ++errors[static_cast<std::size_t>(error)]; })
+ *        <<= 0.0;
+ */
+template <typename T>
+inline optional_detail::TTryParse<T> try_parse(optional_ext::parse_flags flags = optional_ext::parse_flags::strict, int base = 10) noexcept
+{
+    return optional_detail::TTryParse<T>{optional_detail::TParse<T>{flags, base}};
+}
+
+} // namespace hof
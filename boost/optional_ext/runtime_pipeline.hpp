@@ -0,0 +1,681 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <boost/optional.hpp>
+#include <boost/optional_ext.hpp>
+#include <boost/optional_ext/parse.hpp>
+
+namespace optional_ext {
+
+/**
+ * It's a set of named callbacks which a runtime pipeline refers to from match(some, none)
+ */
+template <typename T>
+struct runtime_actions
+{
+    std::unordered_map<std::string, std::function<void(const T&)>> some;
+    std::unordered_map<std::string, std::function<void()>> none;
+};
+
+} // namespace optional_ext
+
+namespace optional_detail {
+
+/**
+ * It's an entry of the flat stage table of a runtime pipeline: the kernels instantiated for the kind of the stage and its operands
+ * A kernel works on the value in place with the semantics of the compile-time stage it's built from and returns
+ * whether the result is engaged. some is called for an engaged value, none for boost::none (the value is then unspecified),
+ * a stage which passes boost::none through has no none kernel.
+ */
+template <typename T>
+struct TRuntimeStage
+{
+    using TKernel = bool (*)(const TRuntimeStage&, T&);
+
+    TKernel some = nullptr;
+    TKernel none = nullptr;
+    // it's the index of the next stage which handles boost::none, the stages between are skipped for an empty optional
+    std::size_t skip = 0;
+    T lhs{};
+    T rhs{};
+    const std::function<void(const T&)>* onSome = nullptr;
+    const std::function<void()>* onNone = nullptr;
+};
+
+template <typename T>
+struct TInRange
+{
+    bool operator()(const T& value, const T& lo, const T& hi) const noexcept
+    {
+        return lo <= value && value <= hi;
+    }
+};
+
+template <typename T>
+struct TIsFinite
+{
+    bool operator()(const T& value, const T&, const T&) const noexcept
+    {
+        if constexpr (std::is_floating_point<T>::value)
+        {
+            return std::isfinite(value);
+        }
+        else
+        {
+            return true;
+        }
+    }
+};
+
+// the binary predicates and transforms take the first operand, the others take both or none
+template <typename TOp>
+struct TWithOperand
+{
+    template <typename T>
+    decltype(auto) operator()(const T& value, const T& lhs, const T&) const
+    {
+        return TOp{}(value, lhs);
+    }
+};
+
+template <typename T>
+struct TMin
+{
+    T operator()(const T& value, const T& lhs, const T&) const noexcept
+    {
+        return std::min(value, lhs);
+    }
+};
+
+template <typename T>
+struct TMax
+{
+    T operator()(const T& value, const T& lhs, const T&) const noexcept
+    {
+        return std::max(value, lhs);
+    }
+};
+
+template <typename T>
+struct TClamp
+{
+    T operator()(const T& value, const T& lo, const T& hi) const noexcept
+    {
+        return std::clamp(value, lo, hi);
+    }
+};
+
+template <typename T>
+struct TAbs
+{
+    T operator()(const T& value, const T&, const T&) const noexcept
+    {
+        if constexpr (std::is_signed<T>::value)
+        {
+            return value < T() ? -value : value;
+        }
+        else
+        {
+            return value;
+        }
+    }
+};
+
+template <typename T>
+boost::optional<T> parseRuntimeValue(std::string_view text) noexcept
+{
+    return boost::make_optional(text) | hof::parse<T>();
+}
+
+template <typename T, typename TPred>
+bool filterIfKernel(const TRuntimeStage<T>& stage, T& value)
+{
+    return TPred{}(value, stage.lhs, stage.rhs);
+}
+
+template <typename T, typename TPred>
+bool filterIfNotKernel(const TRuntimeStage<T>& stage, T& value)
+{
+    return !TPred{}(value, stage.lhs, stage.rhs);
+}
+
+template <typename T, typename TMap>
+bool mapKernel(const TRuntimeStage<T>& stage, T& value)
+{
+    value = static_cast<T>(TMap{}(value, stage.lhs, stage.rhs));
+    return true;
+}
+
+template <typename T>
+bool matchSomeKernel(const TRuntimeStage<T>& stage, T& value)
+{
+    (*stage.onSome)(value);
+    return true;
+}
+
+template <typename T>
+bool matchNoneKernel(const TRuntimeStage<T>& stage, T&)
+{
+    (*stage.onNone)();
+    return false;
+}
+
+template <typename T>
+bool keepKernel(const TRuntimeStage<T>&, T&)
+{
+    return true;
+}
+
+// |= and <<= give the operand for boost::none
+template <typename T>
+bool fallbackKernel(const TRuntimeStage<T>& stage, T& value)
+{
+    value = stage.lhs;
+    return true;
+}
+
+/**
+ * It compiles a pipeline description into a stage table, see optional_ext::compile_pipeline for the grammar
+ */
+template <typename T>
+class TRuntimeCompiler
+{
+public:
+    using TStage = TRuntimeStage<T>;
+
+    TRuntimeCompiler(std::string_view text, const optional_ext::runtime_actions<T>& actions)
+        : m_text(text)
+        , m_actions(actions)
+    {
+    }
+
+    std::vector<TStage> compile()
+    {
+        std::vector<TStage> stages;
+
+        skipSpace();
+        if (!atEnd() && !isNext("|") && !isNext("<<="))
+        {
+            stages.push_back(stage());
+        }
+
+        while (true)
+        {
+            // the terminal and the fallback differ only in that nothing follows the terminal
+            if (consume("<<="))
+            {
+                stages.push_back(operand(&keepKernel<T>, &fallbackKernel<T>));
+                break;
+            }
+            if (consume("|="))
+            {
+                stages.push_back(operand(&keepKernel<T>, &fallbackKernel<T>));
+                continue;
+            }
+            if (consume("|"))
+            {
+                stages.push_back(stage());
+                continue;
+            }
+            break;
+        }
+
+        skipSpace();
+        if (!atEnd())
+        {
+            fail("an unexpected text");
+        }
+
+        auto skip = stages.size();
+        for (auto i = stages.size(); i-- > 0;)
+        {
+            stages[i].skip = skip;
+            if (stages[i].none)
+            {
+                skip = i;
+            }
+        }
+        m_entry = skip;
+        return stages;
+    }
+
+    // it's the index of the first stage which handles boost::none
+    std::size_t entry() const noexcept
+    {
+        return m_entry;
+    }
+
+private:
+    TStage stage()
+    {
+        const auto name = identifier();
+        expect("(");
+
+        TStage ret;
+        if (name == "filter_if")
+        {
+            ret = predicate<true>();
+        }
+        else if (name == "filter_if_not")
+        {
+            ret = predicate<false>();
+        }
+        else if (name == "map")
+        {
+            ret = transform();
+        }
+        else if (name == "match")
+        {
+            ret.some = &matchSomeKernel<T>;
+            ret.none = &matchNoneKernel<T>;
+            ret.onSome = action(m_actions.some, identifier());
+            expect(",");
+            ret.onNone = action(m_actions.none, identifier());
+        }
+        else
+        {
+            fail("an unknown stage '" + std::string(name) + "'", position(name));
+        }
+
+        expect(")");
+        return ret;
+    }
+
+    template <bool isFilterIf, typename TPred>
+    static typename TStage::TKernel filter() noexcept
+    {
+        if constexpr (isFilterIf)
+        {
+            return &filterIfKernel<T, TPred>;
+        }
+        else
+        {
+            return &filterIfNotKernel<T, TPred>;
+        }
+    }
+
+    template <bool isFilterIf>
+    TStage predicate()
+    {
+        if (consume("<="))
+        {
+            return operand(filter<isFilterIf, TWithOperand<std::less_equal<T>>>());
+        }
+        if (consume(">="))
+        {
+            return operand(filter<isFilterIf, TWithOperand<std::greater_equal<T>>>());
+        }
+        if (consume("=="))
+        {
+            return operand(filter<isFilterIf, TWithOperand<std::equal_to<T>>>());
+        }
+        if (consume("!="))
+        {
+            return operand(filter<isFilterIf, TWithOperand<std::not_equal_to<T>>>());
+        }
+        if (consume("<"))
+        {
+            return operand(filter<isFilterIf, TWithOperand<std::less<T>>>());
+        }
+        if (consume(">"))
+        {
+            return operand(filter<isFilterIf, TWithOperand<std::greater<T>>>());
+        }
+
+        const auto name = identifier();
+        if (name == "in")
+        {
+            auto ret = operand(filter<isFilterIf, TInRange<T>>());
+            ret.rhs = value();
+            if (ret.rhs < ret.lhs)
+            {
+                fail("an empty range", m_valuePos);
+            }
+            return ret;
+        }
+        if (name == "finite")
+        {
+            TStage ret;
+            ret.some = filter<isFilterIf, TIsFinite<T>>();
+            return ret;
+        }
+
+        fail("an unknown predicate '" + std::string(name) + "'", position(name));
+    }
+
+    TStage transform()
+    {
+        if (consume("+"))
+        {
+            return operand(&mapKernel<T, TWithOperand<std::plus<T>>>);
+        }
+        if (consume("-"))
+        {
+            return operand(&mapKernel<T, TWithOperand<std::minus<T>>>);
+        }
+        if (consume("*"))
+        {
+            return operand(&mapKernel<T, TWithOperand<std::multiplies<T>>>);
+        }
+        if (consume("/"))
+        {
+            auto ret = operand(&mapKernel<T, TWithOperand<std::divides<T>>>);
+            if (std::is_integral<T>::value && ret.lhs == T())
+            {
+                fail("a division by zero", m_valuePos);
+            }
+            return ret;
+        }
+
+        const auto name = identifier();
+        if (name == "min")
+        {
+            return operand(&mapKernel<T, TMin<T>>);
+        }
+        if (name == "max")
+        {
+            return operand(&mapKernel<T, TMax<T>>);
+        }
+        if (name == "clamp")
+        {
+            auto ret = operand(&mapKernel<T, TClamp<T>>);
+            ret.rhs = value();
+            if (ret.rhs < ret.lhs)
+            {
+                fail("an empty range", m_valuePos);
+            }
+            return ret;
+        }
+        if (name == "abs")
+        {
+            TStage ret;
+            ret.some = &mapKernel<T, TAbs<T>>;
+            return ret;
+        }
+
+        fail("an unknown transform '" + std::string(name) + "'", position(name));
+    }
+
+    template <typename TCallback>
+    const TCallback* action(const std::unordered_map<std::string, TCallback>& actions, std::string_view name)
+    {
+        const auto it = actions.find(std::string(name));
+        if (it == actions.end() || !it->second)
+        {
+            fail("an unknown action '" + std::string(name) + "'", position(name));
+        }
+        return &it->second;
+    }
+
+    TStage operand(typename TStage::TKernel some, typename TStage::TKernel none = nullptr)
+    {
+        TStage ret;
+        ret.some = some;
+        ret.none = none;
+        ret.lhs = value();
+        return ret;
+    }
+
+    T value()
+    {
+        skipSpace();
+        const auto start = m_pos;
+        while (!atEnd() && !isDelimiter(m_text[m_pos]))
+        {
+            ++m_pos;
+        }
+
+        const auto ret = parseRuntimeValue<T>(m_text.substr(start, m_pos - start));
+        m_valuePos = start;
+        if (!ret)
+        {
+            fail("a wrong value", start);
+        }
+        return *ret;
+    }
+
+    std::string_view identifier()
+    {
+        skipSpace();
+        const auto start = m_pos;
+        while (!atEnd() && (std::isalnum(static_cast<unsigned char>(m_text[m_pos])) || m_text[m_pos] == '_'))
+        {
+            ++m_pos;
+        }
+        if (start == m_pos)
+        {
+            fail("a missing name");
+        }
+        return m_text.substr(start, m_pos - start);
+    }
+
+    void expect(std::string_view token)
+    {
+        if (!consume(token))
+        {
+            fail("a missing '" + std::string(token) + "'");
+        }
+    }
+
+    bool consume(std::string_view token)
+    {
+        if (isNext(token))
+        {
+            m_pos += token.size();
+            return true;
+        }
+        return false;
+    }
+
+    bool isNext(std::string_view token)
+    {
+        skipSpace();
+        return m_text.substr(m_pos, token.size()) == token;
+    }
+
+    // the whitespace and the comments from # to the end of a line are skipped, so a description can span a config file
+    void skipSpace() noexcept
+    {
+        while (!atEnd())
+        {
+            if (m_text[m_pos] == '#')
+            {
+                while (!atEnd() && m_text[m_pos] != '\n')
+                {
+                    ++m_pos;
+                }
+            }
+            else if (isParseSpace(m_text[m_pos]))
+            {
+                ++m_pos;
+            }
+            else
+            {
+                break;
+            }
+        }
+    }
+
+    static bool isDelimiter(char ch) noexcept
+    {
+        return isParseSpace(ch) || ch == ',' || ch == '(' || ch == ')' || ch == '|' || ch == '<' || ch == '#';
+    }
+
+    bool atEnd() const noexcept
+    {
+        return m_pos >= m_text.size();
+    }
+
+    std::size_t position(std::string_view token) const noexcept
+    {
+        return static_cast<std::size_t>(token.data() - m_text.data());
+    }
+
+    [[noreturn]] void fail(const std::string& what) const
+    {
+        fail(what, m_pos);
+    }
+
+    [[noreturn]] void fail(const std::string& what, std::size_t pos) const
+    {
+        throw std::invalid_argument("the pipeline description has " + what + " at " + std::to_string(pos));
+    }
+
+    std::string_view m_text;
+    const optional_ext::runtime_actions<T>& m_actions;
+    std::size_t m_pos = 0;
+    std::size_t m_entry = 0;
+    // it's the position of the last value for the errors found after it's parsed
+    std::size_t m_valuePos = 0;
+};
+
+} // namespace optional_detail
+
+namespace optional_ext {
+
+/**
+ * It's a pipeline of T configured at runtime, it's built by optional_ext::compile_pipeline
+ * The stages are kept in a contiguous table, a call is a loop over the table calling the kernel of a stage directly,
+ * the kernels have the semantics of hof::filter_if, hof::filter_if_not, hof::match, map, |= and <<=
+ * and work on one value in place, the engaged flag is kept by the loop.
+ * The copies share the actions of match, so a pipeline copied to other threads needs thread-safe actions.
+ */
+template <typename T>
+class runtime_pipeline
+{
+public:
+    using value_type = T;
+
+    // it's an empty pipeline, it returns the input
+    runtime_pipeline() = default;
+
+    runtime_pipeline(std::vector<optional_detail::TRuntimeStage<T>> stages, std::size_t entry, std::shared_ptr<const runtime_actions<T>> actions) noexcept
+        : m_stages(std::move(stages))
+        , m_entry(entry)
+        , m_actions(std::move(actions))
+    {
+    }
+
+    // an empty optional goes straight to the next stage which handles boost::none, as a fused chain does
+    boost::optional<T> operator()(boost::optional<T> op) const
+    {
+        auto isEngaged = op.has_value();
+        T value = isEngaged ? std::move(*op) : T();
+
+        const auto* stages = m_stages.data();
+        const auto size = m_stages.size();
+        for (auto i = isEngaged ? std::size_t(0) : m_entry; i < size;)
+        {
+            // an empty value stops only at the stages which have a none kernel
+            const auto& stage = stages[i];
+            isEngaged = isEngaged ? stage.some(stage, value) : stage.none(stage, value);
+            i = isEngaged ? i + 1 : stage.skip;
+        }
+
+        if (!isEngaged)
+        {
+            return boost::none;
+        }
+        return boost::optional<T>(std::move(value));
+    }
+
+    // a text is parsed by hof::parse<T>() before the stages, a wrong one is boost::none
+    boost::optional<T> operator()(std::string_view text) const
+    {
+        return (*this)(optional_detail::parseRuntimeValue<T>(text));
+    }
+
+    std::size_t size() const noexcept
+    {
+        return m_stages.size();
+    }
+
+private:
+    std::vector<optional_detail::TRuntimeStage<T>> m_stages;
+    std::size_t m_entry = 0;
+    std::shared_ptr<const runtime_actions<T>> m_actions;
+};
+
+/**
+ * It compiles a pipeline description, e.g. read from a config file at startup, into a runtime pipeline
+ * The description is written like the C++ chain, the stages are separated by | and the values are parsed by hof::parse<T>:
+ *   filter_if(p) and filter_if_not(p) where p is one of < v, <= v, > v, >= v, == v, != v, in lo hi, finite,
+ *   map(m) where m is one of + v, - v, * v, / v, min v, max v, clamp lo hi, abs,
+ *   match(some, none) where some and none are names of the actions,
+ *   |= v replaces boost::none with v, the next stages are applied to it,
+ *   <<= v ends the pipeline, the result is always engaged.
+ * The text from # to the end of a line is a comment.
+ * @param description is a text of the pipeline
+ * @param actions are callbacks which match refers to by name
+ * @return a runtime pipeline
+ * @throw std::invalid_argument when the description is wrong, the message has the position
+ *
+ * an example of usage:
+ *
+ *    auto pipeline = optional_ext::compile_pipeline<double>(
+ *        "filter_if(in 0 50) | map(* 2) |= 0 | filter_if_not(== 13) <<= -1");
+ *
+ *    acc += *pipeline(data);
+ */
+template <typename T>
+runtime_pipeline<T> compile_pipeline(std::string_view description, runtime_actions<T> actions = {})
+{
+    auto shared = std::make_shared<const runtime_actions<T>>(std::move(actions));
+    optional_detail::TRuntimeCompiler<T> compiler(description, *shared);
+    auto stages = compiler.compile();
+    return runtime_pipeline<T>(std::move(stages), compiler.entry(), std::move(shared));
+}
+
+} // namespace optional_ext
+
+namespace optional_detail {
+
+template <typename T>
+struct TRuntime
+{
+    optional_ext::runtime_pipeline<T> pipeline;
+
+    template <typename TOptional>
+    boost::optional<T> operator()(TOptional&& op) const
+    {
+        if (hasValue(op))
+        {
+            return pipeline(boost::optional<T>(getValue(std::forward<TOptional>(op))));
+        }
+        return pipeline(boost::optional<T>());
+    }
+};
+
+} // namespace optional_detail
+
+namespace hof {
+
+/**
+ * It makes a stage of a compile-time chain from a runtime pipeline, the value is converted to T
+ * The stage keeps a copy of the pipeline, so it's better created once, out of a loop.
+ *
+ * an example of usage:
+ *
+ *    auto filter = hof::runtime(optional_ext::compile_pipeline<double>(config));
+ *    toOp(data) | hof::parse<double>() | hof::count_none_into(errors) | filter | hof::sum_into(acc);
+ */
+template <typename T>
+inline decltype(auto) runtime(optional_ext::runtime_pipeline<T> pipeline)
+{
+    return optional_detail::createHof(optional_detail::TRuntime<T>{std::move(pipeline)});
+}
+
+} // namespace hof
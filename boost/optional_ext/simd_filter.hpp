@@ -0,0 +1,440 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#if !defined(OPTIONAL_EXT_NO_SIMD) && (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define OPTIONAL_EXT_HAS_X86_SIMD 1
+#include <immintrin.h>
+#define OPTIONAL_EXT_SIMD_TARGET(isa) __attribute__((target(isa)))
+#else
+#define OPTIONAL_EXT_HAS_X86_SIMD 0
+#endif
+
+namespace optional_ext {
+
+enum class simd_level
+{
+    scalar,
+    sse2,
+    avx2,
+    avx512
+};
+
+/**
+ * It's a comparison predicate which can be evaluated by SIMD kernels
+ * It's a regular callable, so it can be used with hof::filter_if/hof::filter_if_not for boost::optional as well.
+ * For optional_batch of double/float/int32_t/int64_t the filters evaluate it with SSE2/AVX2/AVX-512
+ * which is selected at runtime, other types use the scalar kernel.
+ */
+template <typename T>
+struct range_predicate
+{
+    T lo;
+    T hi;
+    bool lo_inclusive;
+    bool hi_inclusive;
+
+    template <typename U>
+    constexpr bool operator()(const U& value) const noexcept
+    {
+        return (lo_inclusive ? value >= lo : value > lo) && (hi_inclusive ? value <= hi : value < hi);
+    }
+};
+
+} // namespace optional_ext
+
+namespace optional_detail {
+
+template <typename T>
+constexpr T lowestBound() noexcept
+{
+    return std::numeric_limits<T>::has_infinity ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::lowest();
+}
+
+template <typename T>
+constexpr T highestBound() noexcept
+{
+    return std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max();
+}
+
+template <typename T>
+struct is_simd_type
+    : std::integral_constant<bool,
+                             std::is_same<T, double>::value || std::is_same<T, float>::value || std::is_same<T, std::int32_t>::value
+                                 || std::is_same<T, std::int64_t>::value>
+{
+};
+
+template <typename T>
+using TMaskKernel = std::uint64_t (*)(const optional_ext::range_predicate<T>&, const T*, std::size_t);
+
+template <typename T, bool loInclusive, bool hiInclusive>
+inline std::uint64_t scalarMask(const optional_ext::range_predicate<T>& pred, const T* values, std::size_t first, std::size_t last) noexcept
+{
+    std::uint64_t bits = 0;
+    for (std::size_t i = first; i < last; ++i)
+    {
+        const bool isLo = loInclusive ? values[i] >= pred.lo : values[i] > pred.lo;
+        const bool isHi = hiInclusive ? values[i] <= pred.hi : values[i] < pred.hi;
+        bits |= std::uint64_t(isLo && isHi) << i;
+    }
+
+    return bits;
+}
+
+template <typename T, bool loInclusive, bool hiInclusive>
+std::uint64_t scalarWord(const optional_ext::range_predicate<T>& pred, const T* values, std::size_t size) noexcept
+{
+    return scalarMask<T, loInclusive, hiInclusive>(pred, values, 0, size);
+}
+
+#if OPTIONAL_EXT_HAS_X86_SIMD
+
+// clang-format off
+
+// It combines the lane masks of "x >(=) lo" and "x <(=) hi" computed as "greater than" masks
+template <bool loInclusive, bool hiInclusive>
+inline unsigned combineGreaterMasks(unsigned xGtLo, unsigned loGtX, unsigned xGtHi, unsigned hiGtX, unsigned full) noexcept
+{
+    const unsigned isLo = loInclusive ? ~loGtX & full : xGtLo;
+    const unsigned isHi = hiInclusive ? ~xGtHi & full : hiGtX;
+    return isLo & isHi;
+}
+
+struct TSse2
+{
+    template <typename T>
+    static constexpr std::size_t lanes = 16 / sizeof(T);
+
+    template <bool loInclusive, bool hiInclusive>
+    OPTIONAL_EXT_SIMD_TARGET("sse2") static unsigned mask(const double* values, __m128d lo, __m128d hi) noexcept
+    {
+        const __m128d x = _mm_loadu_pd(values);
+        const __m128d isLo = loInclusive ? _mm_cmpge_pd(x, lo) : _mm_cmpgt_pd(x, lo);
+        const __m128d isHi = hiInclusive ? _mm_cmple_pd(x, hi) : _mm_cmplt_pd(x, hi);
+        return static_cast<unsigned>(_mm_movemask_pd(_mm_and_pd(isLo, isHi)));
+    }
+
+    template <bool loInclusive, bool hiInclusive>
+    OPTIONAL_EXT_SIMD_TARGET("sse2") static unsigned mask(const float* values, __m128 lo, __m128 hi) noexcept
+    {
+        const __m128 x = _mm_loadu_ps(values);
+        const __m128 isLo = loInclusive ? _mm_cmpge_ps(x, lo) : _mm_cmpgt_ps(x, lo);
+        const __m128 isHi = hiInclusive ? _mm_cmple_ps(x, hi) : _mm_cmplt_ps(x, hi);
+        return static_cast<unsigned>(_mm_movemask_ps(_mm_and_ps(isLo, isHi)));
+    }
+
+    template <bool loInclusive, bool hiInclusive>
+    OPTIONAL_EXT_SIMD_TARGET("sse2") static unsigned mask(const std::int32_t* values, __m128i lo, __m128i hi) noexcept
+    {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+        return combineGreaterMasks<loInclusive, hiInclusive>(
+            movemask32(_mm_cmpgt_epi32(x, lo)), movemask32(_mm_cmpgt_epi32(lo, x)),
+            movemask32(_mm_cmpgt_epi32(x, hi)), movemask32(_mm_cmpgt_epi32(hi, x)), 0xFu);
+    }
+
+    OPTIONAL_EXT_SIMD_TARGET("sse2") static unsigned movemask32(__m128i m) noexcept
+    {
+        return static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(m)));
+    }
+
+    OPTIONAL_EXT_SIMD_TARGET("sse2") static __m128d broadcast(double value) noexcept { return _mm_set1_pd(value); }
+    OPTIONAL_EXT_SIMD_TARGET("sse2") static __m128 broadcast(float value) noexcept { return _mm_set1_ps(value); }
+    OPTIONAL_EXT_SIMD_TARGET("sse2") static __m128i broadcast(std::int32_t value) noexcept { return _mm_set1_epi32(value); }
+};
+
+struct TAvx2
+{
+    template <typename T>
+    static constexpr std::size_t lanes = 32 / sizeof(T);
+
+    template <bool loInclusive, bool hiInclusive>
+    OPTIONAL_EXT_SIMD_TARGET("avx2") static unsigned mask(const double* values, __m256d lo, __m256d hi) noexcept
+    {
+        const __m256d x = _mm256_loadu_pd(values);
+        const __m256d isLo = _mm256_cmp_pd(x, lo, loInclusive ? _CMP_GE_OQ : _CMP_GT_OQ);
+        const __m256d isHi = _mm256_cmp_pd(x, hi, hiInclusive ? _CMP_LE_OQ : _CMP_LT_OQ);
+        return static_cast<unsigned>(_mm256_movemask_pd(_mm256_and_pd(isLo, isHi)));
+    }
+
+    template <bool loInclusive, bool hiInclusive>
+    OPTIONAL_EXT_SIMD_TARGET("avx2") static unsigned mask(const float* values, __m256 lo, __m256 hi) noexcept
+    {
+        const __m256 x = _mm256_loadu_ps(values);
+        const __m256 isLo = _mm256_cmp_ps(x, lo, loInclusive ? _CMP_GE_OQ : _CMP_GT_OQ);
+        const __m256 isHi = _mm256_cmp_ps(x, hi, hiInclusive ? _CMP_LE_OQ : _CMP_LT_OQ);
+        return static_cast<unsigned>(_mm256_movemask_ps(_mm256_and_ps(isLo, isHi)));
+    }
+
+    template <bool loInclusive, bool hiInclusive>
+    OPTIONAL_EXT_SIMD_TARGET("avx2") static unsigned mask(const std::int32_t* values, __m256i lo, __m256i hi) noexcept
+    {
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values));
+        return combineGreaterMasks<loInclusive, hiInclusive>(
+            movemask32(_mm256_cmpgt_epi32(x, lo)), movemask32(_mm256_cmpgt_epi32(lo, x)),
+            movemask32(_mm256_cmpgt_epi32(x, hi)), movemask32(_mm256_cmpgt_epi32(hi, x)), 0xFFu);
+    }
+
+    template <bool loInclusive, bool hiInclusive>
+    OPTIONAL_EXT_SIMD_TARGET("avx2") static unsigned mask(const std::int64_t* values, __m256i lo, __m256i hi) noexcept
+    {
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values));
+        return combineGreaterMasks<loInclusive, hiInclusive>(
+            movemask64(_mm256_cmpgt_epi64(x, lo)), movemask64(_mm256_cmpgt_epi64(lo, x)),
+            movemask64(_mm256_cmpgt_epi64(x, hi)), movemask64(_mm256_cmpgt_epi64(hi, x)), 0xFu);
+    }
+
+    OPTIONAL_EXT_SIMD_TARGET("avx2") static unsigned movemask32(__m256i m) noexcept
+    {
+        return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(m)));
+    }
+
+    OPTIONAL_EXT_SIMD_TARGET("avx2") static unsigned movemask64(__m256i m) noexcept
+    {
+        return static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(m)));
+    }
+
+    OPTIONAL_EXT_SIMD_TARGET("avx2") static __m256d broadcast(double value) noexcept { return _mm256_set1_pd(value); }
+    OPTIONAL_EXT_SIMD_TARGET("avx2") static __m256 broadcast(float value) noexcept { return _mm256_set1_ps(value); }
+    OPTIONAL_EXT_SIMD_TARGET("avx2") static __m256i broadcast(std::int32_t value) noexcept { return _mm256_set1_epi32(value); }
+    OPTIONAL_EXT_SIMD_TARGET("avx2") static __m256i broadcast(std::int64_t value) noexcept { return _mm256_set1_epi64x(value); }
+};
+
+struct TAvx512
+{
+    template <typename T>
+    static constexpr std::size_t lanes = 64 / sizeof(T);
+
+    template <bool loInclusive, bool hiInclusive>
+    OPTIONAL_EXT_SIMD_TARGET("avx512f") static unsigned mask(const double* values, __m512d lo, __m512d hi) noexcept
+    {
+        const __m512d x = _mm512_loadu_pd(values);
+        return _mm512_cmp_pd_mask(x, lo, loInclusive ? _CMP_GE_OQ : _CMP_GT_OQ) & _mm512_cmp_pd_mask(x, hi, hiInclusive ? _CMP_LE_OQ : _CMP_LT_OQ);
+    }
+
+    template <bool loInclusive, bool hiInclusive>
+    OPTIONAL_EXT_SIMD_TARGET("avx512f") static unsigned mask(const float* values, __m512 lo, __m512 hi) noexcept
+    {
+        const __m512 x = _mm512_loadu_ps(values);
+        return _mm512_cmp_ps_mask(x, lo, loInclusive ? _CMP_GE_OQ : _CMP_GT_OQ) & _mm512_cmp_ps_mask(x, hi, hiInclusive ? _CMP_LE_OQ : _CMP_LT_OQ);
+    }
+
+    template <bool loInclusive, bool hiInclusive>
+    OPTIONAL_EXT_SIMD_TARGET("avx512f") static unsigned mask(const std::int32_t* values, __m512i lo, __m512i hi) noexcept
+    {
+        const __m512i x = _mm512_loadu_si512(values);
+        return _mm512_cmp_epi32_mask(x, lo, loInclusive ? _MM_CMPINT_NLT : _MM_CMPINT_NLE)
+            & _mm512_cmp_epi32_mask(x, hi, hiInclusive ? _MM_CMPINT_LE : _MM_CMPINT_LT);
+    }
+
+    template <bool loInclusive, bool hiInclusive>
+    OPTIONAL_EXT_SIMD_TARGET("avx512f") static unsigned mask(const std::int64_t* values, __m512i lo, __m512i hi) noexcept
+    {
+        const __m512i x = _mm512_loadu_si512(values);
+        return _mm512_cmp_epi64_mask(x, lo, loInclusive ? _MM_CMPINT_NLT : _MM_CMPINT_NLE)
+            & _mm512_cmp_epi64_mask(x, hi, hiInclusive ? _MM_CMPINT_LE : _MM_CMPINT_LT);
+    }
+
+    OPTIONAL_EXT_SIMD_TARGET("avx512f") static __m512d broadcast(double value) noexcept { return _mm512_set1_pd(value); }
+    OPTIONAL_EXT_SIMD_TARGET("avx512f") static __m512 broadcast(float value) noexcept { return _mm512_set1_ps(value); }
+    OPTIONAL_EXT_SIMD_TARGET("avx512f") static __m512i broadcast(std::int32_t value) noexcept { return _mm512_set1_epi32(value); }
+    OPTIONAL_EXT_SIMD_TARGET("avx512f") static __m512i broadcast(std::int64_t value) noexcept { return _mm512_set1_epi64(value); }
+};
+
+// The word kernels are spelled out per ISA: the loop must have the same target as the lane masks to inline them
+template <typename T, bool loInclusive, bool hiInclusive>
+OPTIONAL_EXT_SIMD_TARGET("sse2") std::uint64_t sse2Word(const optional_ext::range_predicate<T>& pred, const T* values, std::size_t size) noexcept
+{
+    constexpr auto lanes = TSse2::lanes<T>;
+    const auto lo = TSse2::broadcast(pred.lo);
+    const auto hi = TSse2::broadcast(pred.hi);
+
+    std::uint64_t bits = 0;
+    std::size_t i = 0;
+    for (; i + lanes <= size; i += lanes)
+    {
+        bits |= std::uint64_t(TSse2::mask<loInclusive, hiInclusive>(values + i, lo, hi)) << i;
+    }
+
+    return bits | scalarMask<T, loInclusive, hiInclusive>(pred, values, i, size);
+}
+
+template <typename T, bool loInclusive, bool hiInclusive>
+OPTIONAL_EXT_SIMD_TARGET("avx2") std::uint64_t avx2Word(const optional_ext::range_predicate<T>& pred, const T* values, std::size_t size) noexcept
+{
+    constexpr auto lanes = TAvx2::lanes<T>;
+    const auto lo = TAvx2::broadcast(pred.lo);
+    const auto hi = TAvx2::broadcast(pred.hi);
+
+    std::uint64_t bits = 0;
+    std::size_t i = 0;
+    for (; i + lanes <= size; i += lanes)
+    {
+        bits |= std::uint64_t(TAvx2::mask<loInclusive, hiInclusive>(values + i, lo, hi)) << i;
+    }
+
+    return bits | scalarMask<T, loInclusive, hiInclusive>(pred, values, i, size);
+}
+
+template <typename T, bool loInclusive, bool hiInclusive>
+OPTIONAL_EXT_SIMD_TARGET("avx512f") std::uint64_t avx512Word(const optional_ext::range_predicate<T>& pred, const T* values, std::size_t size) noexcept
+{
+    constexpr auto lanes = TAvx512::lanes<T>;
+    const auto lo = TAvx512::broadcast(pred.lo);
+    const auto hi = TAvx512::broadcast(pred.hi);
+
+    std::uint64_t bits = 0;
+    std::size_t i = 0;
+    for (; i + lanes <= size; i += lanes)
+    {
+        bits |= std::uint64_t(TAvx512::mask<loInclusive, hiInclusive>(values + i, lo, hi)) << i;
+    }
+
+    return bits | scalarMask<T, loInclusive, hiInclusive>(pred, values, i, size);
+}
+// clang-format on
+
+inline optional_ext::simd_level detectSimdLevel() noexcept
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        return optional_ext::simd_level::avx512;
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return optional_ext::simd_level::avx2;
+    }
+    if (__builtin_cpu_supports("sse2"))
+    {
+        return optional_ext::simd_level::sse2;
+    }
+
+    return optional_ext::simd_level::scalar;
+}
+
+#else
+
+inline optional_ext::simd_level detectSimdLevel() noexcept
+{
+    return optional_ext::simd_level::scalar;
+}
+
+#endif
+
+template <typename T, bool loInclusive, bool hiInclusive>
+TMaskKernel<T> selectMaskKernel(optional_ext::simd_level level) noexcept
+{
+#if OPTIONAL_EXT_HAS_X86_SIMD
+    if constexpr (is_simd_type<T>::value)
+    {
+        switch (level)
+        {
+        case optional_ext::simd_level::avx512:
+            return &avx512Word<T, loInclusive, hiInclusive>;
+        case optional_ext::simd_level::avx2:
+            return &avx2Word<T, loInclusive, hiInclusive>;
+        case optional_ext::simd_level::sse2:
+            // there is no 64-bit integer comparison in SSE2
+            if constexpr (!std::is_same<T, std::int64_t>::value)
+            {
+                return &sse2Word<T, loInclusive, hiInclusive>;
+            }
+            break;
+        case optional_ext::simd_level::scalar:
+            break;
+        }
+    }
+#else
+    (void)level;
+#endif
+
+    return &scalarWord<T, loInclusive, hiInclusive>;
+}
+
+template <typename T>
+TMaskKernel<T> selectMaskKernel(const optional_ext::range_predicate<T>& pred, optional_ext::simd_level level) noexcept
+{
+    if (pred.lo_inclusive)
+    {
+        return pred.hi_inclusive ? selectMaskKernel<T, true, true>(level) : selectMaskKernel<T, true, false>(level);
+    }
+
+    return pred.hi_inclusive ? selectMaskKernel<T, false, true>(level) : selectMaskKernel<T, false, false>(level);
+}
+
+} // namespace optional_detail
+
+namespace optional_ext {
+
+/**
+ * @return the best instruction set supported by the CPU, it's detected once
+ */
+inline simd_level active_simd_level() noexcept
+{
+    static const simd_level level = optional_detail::detectSimdLevel();
+    return level;
+}
+
+template <typename T>
+constexpr range_predicate<T> between(T lo, T hi) noexcept
+{
+    return {lo, hi, true, true};
+}
+
+template <typename T>
+constexpr range_predicate<T> greater(T value) noexcept
+{
+    return {value, optional_detail::highestBound<T>(), false, true};
+}
+
+template <typename T>
+constexpr range_predicate<T> greater_equal(T value) noexcept
+{
+    return {value, optional_detail::highestBound<T>(), true, true};
+}
+
+template <typename T>
+constexpr range_predicate<T> less(T value) noexcept
+{
+    return {optional_detail::lowestBound<T>(), value, true, false};
+}
+
+template <typename T>
+constexpr range_predicate<T> less_equal(T value) noexcept
+{
+    return {optional_detail::lowestBound<T>(), value, true, true};
+}
+
+/**
+ * It evaluates the predicate for a span of values and clears the bits of the validity mask
+ * where the predicate isn't satisfied, the words of the mask that are already zero are skipped
+ * @param pred is a range predicate
+ * @param values is a span of values
+ * @param size is a number of values
+ * @param mask is a validity mask of (size + 63) / 64 words, the bit (i % 64) of the word (i / 64) is for values[i]
+ * @param level is an instruction set, it can't be higher than active_simd_level()
+ *
+ * an example of usage:
+ *
+ *    std::vector<std::uint64_t> mask((values.size() + 63) / 64, ~std::uint64_t(0));
+ *    optional_ext::filter_mask(optional_ext::between(0.0, 50.0), values.data(), values.size(), mask.data());
+ */
+template <typename T>
+void filter_mask(const range_predicate<T>& pred, const T* values, std::size_t size, std::uint64_t* mask, simd_level level = active_simd_level()) noexcept
+{
+    const auto kernel = optional_detail::selectMaskKernel(pred, level);
+
+    for (std::size_t first = 0, word = 0; first < size; first += 64, ++word)
+    {
+        if (mask[word] != 0)
+        {
+            mask[word] &= kernel(pred, values + first, size - first < 64 ? size - first : 64);
+        }
+    }
+}
+
+} // namespace optional_ext
@@ -0,0 +1,356 @@
+#pragma once
+
+/**
+ * Timeline tracing into the Chrome Trace Event format (it's opened by chrome://tracing and ui.perfetto.dev)
+ * It's enabled by defining OPTIONAL_EXT_TRACING=1 for the whole program, it also enables OPTIONAL_EXT_INSTRUMENTATION,
+ * so every probed stage becomes a slice. When it's disabled the OPTIONAL_EXT_TRACE_* macros expand to nothing.
+ * The events are recorded only between optional_ext::start_tracing() and optional_ext::stop_tracing().
+ */
+
+#ifndef OPTIONAL_EXT_TRACING
+#define OPTIONAL_EXT_TRACING 0
+#endif
+
+#if OPTIONAL_EXT_TRACING
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#ifndef OPTIONAL_EXT_TRACE_BUFFER_EVENTS
+#define OPTIONAL_EXT_TRACE_BUFFER_EVENTS (1 << 18)
+#endif
+
+namespace optional_detail {
+
+/**
+ * It's an event of the trace, the names have to be static (string literals or names of the instrumented stages)
+ * 'X' is a slice [ts, ts + dur), 's'/'f' are the ends of a flow arrow between slices of different threads.
+ */
+struct TTraceEvent
+{
+    const char* name;
+    const char* category;
+    std::uint64_t ts;
+    std::uint64_t dur;
+    std::uint64_t id;
+    char phase;
+};
+
+/**
+ * It's a buffer of events of one thread
+ * Only the owning thread appends, the size is published with release, so write_trace reads the events without a lock.
+ * A full buffer drops new events.
+ */
+class TTraceBuffer
+{
+public:
+    static constexpr std::size_t capacity = OPTIONAL_EXT_TRACE_BUFFER_EVENTS;
+
+    explicit TTraceBuffer(std::uint32_t tid)
+        : m_tid(tid)
+        , m_events(new TTraceEvent[capacity])
+    {
+    }
+
+    void push(const TTraceEvent& event) noexcept
+    {
+        const auto size = m_size.load(std::memory_order_relaxed);
+        if (size == capacity)
+        {
+            m_dropped.store(m_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return;
+        }
+
+        m_events[size] = event;
+        m_size.store(size + 1, std::memory_order_release);
+    }
+
+    std::uint32_t tid() const noexcept
+    {
+        return m_tid;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return m_size.load(std::memory_order_acquire);
+    }
+
+    const TTraceEvent& operator[](std::size_t i) const noexcept
+    {
+        return m_events[i];
+    }
+
+    std::uint64_t dropped() const noexcept
+    {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
+    void setName(std::string name)
+    {
+        std::lock_guard<std::mutex> lock(m_nameMutex);
+        m_name = std::move(name);
+    }
+
+    std::string name() const
+    {
+        std::lock_guard<std::mutex> lock(m_nameMutex);
+        return m_name;
+    }
+
+private:
+    const std::uint32_t m_tid;
+    std::unique_ptr<TTraceEvent[]> m_events;
+    std::atomic<std::size_t> m_size{0};
+    std::atomic<std::uint64_t> m_dropped{0};
+
+    mutable std::mutex m_nameMutex;
+    std::string m_name;
+};
+
+class TTraceRegistry
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // it's never destroyed, threads may record after the static destructors have run
+    static TTraceRegistry& instance()
+    {
+        static auto* registry = new TTraceRegistry();
+        return *registry;
+    }
+
+    bool isEnabled() const noexcept
+    {
+        return m_isEnabled.load(std::memory_order_relaxed);
+    }
+
+    void setEnabled(bool isEnabled) noexcept
+    {
+        m_isEnabled.store(isEnabled, std::memory_order_relaxed);
+    }
+
+    std::uint64_t now() const noexcept
+    {
+        return toNs(Clock::now());
+    }
+
+    std::uint64_t toNs(Clock::time_point time) const noexcept
+    {
+        if (time < m_epoch)
+        {
+            return 0;
+        }
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(time - m_epoch).count());
+    }
+
+    TTraceBuffer& local()
+    {
+        thread_local TTraceBuffer* buffer = nullptr;
+        if (!buffer)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_buffers.push_back(std::make_unique<TTraceBuffer>(static_cast<std::uint32_t>(m_buffers.size() + 1)));
+            buffer = m_buffers.back().get();
+        }
+
+        return *buffer;
+    }
+
+    void record(const char* name, const char* category, std::uint64_t ts, std::uint64_t dur, std::uint64_t id, char phase) noexcept
+    {
+        if (isEnabled())
+        {
+            local().push({name, category, ts, dur, id, phase});
+        }
+    }
+
+    void write(std::ostream& out)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+        bool isFirst = true;
+        auto separator = [&out, &isFirst]() -> std::ostream& {
+            out << (isFirst ? "" : ",\n");
+            isFirst = false;
+            return out;
+        };
+
+        out << std::fixed << std::setprecision(3);
+        for (const auto& buffer : m_buffers)
+        {
+            const auto name = buffer->name();
+            if (!name.empty())
+            {
+                separator() << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << buffer->tid() << ",\"args\":{\"name\":";
+                writeString(out, name.c_str()) << "}}";
+            }
+
+            const auto size = buffer->size();
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                const auto& event = (*buffer)[i];
+                separator() << "{\"ph\":\"" << event.phase << "\",\"name\":";
+                writeString(out, event.name) << ",\"cat\":";
+                writeString(out, event.category) << ",\"pid\":1,\"tid\":" << buffer->tid() << ",\"ts\":" << static_cast<double>(event.ts) / 1000.0;
+
+                if (event.phase == 'X')
+                {
+                    out << ",\"dur\":" << static_cast<double>(event.dur) / 1000.0;
+                }
+                else
+                {
+                    // a flow ends at the enclosing slice
+                    out << ",\"id\":" << event.id << (event.phase == 'f' ? ",\"bp\":\"e\"" : "");
+                }
+                out << "}";
+            }
+
+            if (buffer->dropped() > 0)
+            {
+                separator() << "{\"ph\":\"M\",\"name\":\"dropped_events\",\"pid\":1,\"tid\":" << buffer->tid()
+                            << ",\"args\":{\"count\":" << buffer->dropped() << "}}";
+            }
+        }
+
+        out << "\n]}\n";
+    }
+
+private:
+    TTraceRegistry()
+        : m_epoch(Clock::now())
+    {
+    }
+
+    static std::ostream& writeString(std::ostream& out, const char* str)
+    {
+        out << '"';
+        for (; *str; ++str)
+        {
+            const auto ch = *str;
+            if (ch == '"' || ch == '\\')
+            {
+                out << '\\' << ch;
+            }
+            else if (static_cast<unsigned char>(ch) < 0x20)
+            {
+                out << ' ';
+            }
+            else
+            {
+                out << ch;
+            }
+        }
+        return out << '"';
+    }
+
+private:
+    const Clock::time_point m_epoch;
+    std::atomic<bool> m_isEnabled{false};
+
+    std::mutex m_mutex;
+    std::vector<std::unique_ptr<TTraceBuffer>> m_buffers;
+};
+
+/**
+ * It records a slice from its construction to its destruction
+ */
+class TTraceScope
+{
+public:
+    TTraceScope(const char* name, const char* category) noexcept
+        : m_name(name)
+        , m_category(category)
+        , m_start(TTraceRegistry::instance().isEnabled() ? TTraceRegistry::instance().now() : 0)
+        , m_isEnabled(TTraceRegistry::instance().isEnabled())
+    {
+    }
+
+    TTraceScope(const TTraceScope&) = delete;
+    TTraceScope& operator=(const TTraceScope&) = delete;
+
+    ~TTraceScope()
+    {
+        if (m_isEnabled)
+        {
+            auto& registry = TTraceRegistry::instance();
+            registry.record(m_name, m_category, m_start, registry.now() - m_start, 0, 'X');
+        }
+    }
+
+private:
+    const char* m_name;
+    const char* m_category;
+    std::uint64_t m_start;
+    bool m_isEnabled;
+};
+
+} // namespace optional_detail
+
+namespace optional_ext {
+
+inline void start_tracing() noexcept
+{
+    optional_detail::TTraceRegistry::instance().setEnabled(true);
+}
+
+inline void stop_tracing() noexcept
+{
+    optional_detail::TTraceRegistry::instance().setEnabled(false);
+}
+
+// the name of the calling thread in the trace
+inline void set_trace_thread_name(std::string name)
+{
+    optional_detail::TTraceRegistry::instance().local().setName(std::move(name));
+}
+
+/**
+ * It writes all events recorded so far as Chrome Trace Event JSON
+ * It can be called while other threads record, their events recorded after the call started may be missing.
+ */
+inline void write_trace(std::ostream& out)
+{
+    optional_detail::TTraceRegistry::instance().write(out);
+}
+
+inline bool write_trace(const std::string& path)
+{
+    std::ofstream out(path);
+    write_trace(out);
+    return static_cast<bool>(out);
+}
+
+} // namespace optional_ext
+
+#define OPTIONAL_EXT_TRACE_CONCAT_IMPL(a, b) a##b
+#define OPTIONAL_EXT_TRACE_CONCAT(a, b) OPTIONAL_EXT_TRACE_CONCAT_IMPL(a, b)
+
+// a slice of the enclosing scope, the name is a string literal
+#define OPTIONAL_EXT_TRACE_SCOPE(name, category) \
+    optional_detail::TTraceScope OPTIONAL_EXT_TRACE_CONCAT(optionalExtTraceScope, __LINE__)(name, category)
+// the ends of an arrow from a slice of one thread to a slice of another one, e.g. a message handed over through a queue
+// the arrows are matched by the name and the id
+#define OPTIONAL_EXT_TRACE_FLOW_BEGIN(name, id) \
+    optional_detail::TTraceRegistry::instance().record(name, name, optional_detail::TTraceRegistry::instance().now(), 0, id, 's')
+#define OPTIONAL_EXT_TRACE_FLOW_END(name, id) \
+    optional_detail::TTraceRegistry::instance().record(name, name, optional_detail::TTraceRegistry::instance().now(), 0, id, 'f')
+#define OPTIONAL_EXT_TRACE_THREAD_NAME(name) optional_ext::set_trace_thread_name(name)
+
+#else
+
+#define OPTIONAL_EXT_TRACE_SCOPE(name, category)
+#define OPTIONAL_EXT_TRACE_FLOW_BEGIN(name, id)
+#define OPTIONAL_EXT_TRACE_FLOW_END(name, id)
+#define OPTIONAL_EXT_TRACE_THREAD_NAME(name)
+
+#endif // OPTIONAL_EXT_TRACING
@@ -0,0 +1,219 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <boost/optional.hpp>
+#include <boost/optional_ext.hpp>
+#include <boost/optional_ext/parallel.hpp>
+
+namespace optional_detail {
+
+/**
+ * It's an element of the tuple made by hof::zip: a reference to the value of an lvalue optional (or a pointer),
+ * the value of a temporary optional is moved into the tuple
+ */
+template <typename TOptional>
+using zip_element_t = std::conditional_t<std::is_lvalue_reference<TOptional>::value || optional_traits_t<TOptional>::is_pointer,
+                                         decltype(optional_detail::getValue(std::declval<TOptional>())),
+                                         typename optional_traits_t<TOptional>::value_type>;
+
+template <typename TResult, bool isOptional = is_optional_type<std::decay_t<TResult>>::value>
+struct TProducerValue
+{
+    using type = std::decay_t<TResult>;
+};
+
+template <typename TResult>
+struct TProducerValue<TResult, true>
+{
+    using type = zip_element_t<TResult>;
+};
+
+template <typename TProducer>
+using producer_value_t = typename TProducerValue<std::invoke_result_t<TProducer&>>::type;
+
+template <typename TFunctor>
+struct TApply
+{
+    TFunctor f;
+
+    template <typename TTuple>
+    decltype(auto) operator()(TTuple&& values)
+    {
+        return std::apply(f, std::forward<TTuple>(values));
+    }
+};
+
+/**
+ * It calls the producers of hof::when_all and keeps their values until all of them are ready
+ * A producer which yields none sets the flag, so the producers which haven't started yet aren't called.
+ */
+template <typename... TProducers>
+class TWhenAll
+{
+public:
+    using TResult = boost::optional<std::tuple<producer_value_t<TProducers>...>>;
+
+    explicit TWhenAll(TProducers&... producers) noexcept
+        : m_producers(producers...)
+    {
+    }
+
+    TResult run(optional_ext::execution::sequenced_policy)
+    {
+        runAll(std::index_sequence_for<TProducers...>());
+        return finish(std::index_sequence_for<TProducers...>());
+    }
+
+    template <typename TExecutor>
+    TResult run(const optional_ext::execution::parallel_policy<TExecutor>& policy)
+    {
+        auto chunk = [this](std::size_t begin, std::size_t end) {
+            for (auto i = begin; i < end; ++i)
+            {
+                runAt(i, std::index_sequence_for<TProducers...>());
+            }
+        };
+        runChunks(policy.with_chunk(1), sizeof...(TProducers), chunk);
+        return finish(std::index_sequence_for<TProducers...>());
+    }
+
+private:
+    template <std::size_t I>
+    void runOne()
+    {
+        if (m_failed.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+
+        using TValue = std::tuple_element_t<I, std::tuple<producer_value_t<TProducers>...>>;
+        decltype(auto) result = std::get<I>(m_producers)();
+
+        if constexpr (is_optional_type<std::decay_t<decltype(result)>>::value)
+        {
+            if (!optional_detail::hasValue(result))
+            {
+                m_failed.store(true, std::memory_order_relaxed);
+                return;
+            }
+            std::get<I>(m_values) = boost::optional<TValue>(optional_detail::getValue(std::forward<decltype(result)>(result)));
+        }
+        else
+        {
+            std::get<I>(m_values) = boost::optional<TValue>(std::forward<decltype(result)>(result));
+        }
+    }
+
+    template <std::size_t... Is>
+    void runAll(std::index_sequence<Is...>)
+    {
+        (runOne<Is>(), ...);
+    }
+
+    template <std::size_t... Is>
+    void runAt(std::size_t index, std::index_sequence<Is...>)
+    {
+        ((index == Is ? runOne<Is>() : void()), ...);
+    }
+
+    template <std::size_t... Is>
+    TResult finish(std::index_sequence<Is...>)
+    {
+        if (m_failed.load(std::memory_order_relaxed))
+        {
+            return TResult();
+        }
+
+        return TResult(boost::in_place_init, *std::move(std::get<Is>(m_values))...);
+    }
+
+    std::tuple<TProducers&...> m_producers;
+    std::tuple<boost::optional<producer_value_t<TProducers>>...> m_values;
+    std::atomic<bool> m_failed{false};
+};
+
+} // namespace optional_detail
+
+namespace hof {
+
+/**
+ * It combines optionals into an optional of a tuple of their values, it's empty if any optional is empty
+ * The optionals may be of different kinds (see optional_ext::optional_traits). The values of lvalue optionals
+ * are referenced, the values of temporaries are moved into the tuple.
+ * @param ops are optionals
+ * @return boost::optional<std::tuple<...>>
+ *
+ * an example of usage:
+ *
+ *    const auto order = hof::zip(toOp(fields.id) | hof::parse<int>(), toOp(fields.price) | hof::parse<double>())
+ *        | hof::apply([](int id, double price) { return Order{id, price}; });
+ */
+template <typename... TOptionals>
+inline auto zip(TOptionals&&... ops) -> boost::optional<std::tuple<optional_detail::zip_element_t<TOptionals>...>>
+{
+    static_assert(sizeof...(TOptionals) > 0, "hof::zip takes at least one optional");
+    static_assert((optional_detail::is_optional_type<TOptionals>::value && ...), "hof::zip takes optionals");
+
+    using TResult = boost::optional<std::tuple<optional_detail::zip_element_t<TOptionals>...>>;
+
+    if ((optional_detail::hasValue(ops) && ...))
+    {
+        return TResult(boost::in_place_init, optional_detail::getValue(std::forward<TOptionals>(ops))...);
+    }
+
+    return TResult();
+}
+
+/**
+ * It makes a map (or flat_map) function which takes the tuple made by hof::zip or hof::when_all and calls f with its elements
+ */
+template <typename TFunctor>
+inline auto apply(TFunctor&& f)
+{
+    return optional_detail::TApply<std::decay_t<TFunctor>>{std::forward<TFunctor>(f)};
+}
+
+/**
+ * It calls the producers and combines their optionals as hof::zip does
+ * The producers are called one by one and the first one which yields none stops the rest.
+ * With optional_ext::execution::par (its executor is optional_ext::default_executor() unless .on(executor) is given)
+ * the producers run concurrently on the executor and the calling thread, so the latency is the one of the slowest producer,
+ * a producer which hasn't started when another one yields none isn't called. The call waits for all started producers,
+ * so they are referenced rather than copied. The first exception thrown by a producer is rethrown.
+ * A producer returns an optional or a value which is always present.
+ * @param producers are functions without arguments, optionally preceded by an execution policy
+ * @return boost::optional<std::tuple<...>> of the values of the producers
+ *
+ * an example of usage:
+ *
+ *    const auto profile = hof::when_all(optional_ext::execution::par.on(pool),
+ *                                       [&id]() { return loadUser(id); },
+ *                                       [&id]() { return loadBalance(id); },
+ *                                       [&id]() { return loadHistory(id); })
+ *        | hof::apply(makeProfile);
+ */
+template <typename TFirst, typename... TRest>
+inline auto when_all(TFirst&& first, TRest&&... rest)
+{
+    using TFirstType = std::decay_t<TFirst>;
+
+    if constexpr (std::is_same<TFirstType, optional_ext::execution::sequenced_policy>::value
+                  || optional_detail::is_parallel_policy<TFirstType>::value)
+    {
+        static_assert(sizeof...(TRest) > 0, "hof::when_all takes at least one producer");
+        return optional_detail::TWhenAll<std::remove_reference_t<TRest>...>(rest...).run(first);
+    }
+    else
+    {
+        return optional_detail::TWhenAll<std::remove_reference_t<TFirst>, std::remove_reference_t<TRest>...>(first, rest...)
+            .run(optional_ext::execution::seq);
+    }
+}
+
+} // namespace hof
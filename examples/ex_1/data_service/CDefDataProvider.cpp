@@ -1,15 +1,98 @@
 #include "CDefDataProvider.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <vector>
 
 #include <boost/random/random_device.hpp>
 #include <boost/random/uniform_real_distribution.hpp>
 #include <boost/random/uniform_int_distribution.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/optional_ext/tracing.hpp>
 
 namespace services
 {
-    CDefDataProvider::CDefDataProvider()
+namespace
+{
+    /**
+     * It's a splitmix64 generator, it's seeded explicitly and costs a few instructions per draw
+     */
+    class CFastRng
+    {
+        public:
+        using result_type = std::uint64_t;
+
+        explicit CFastRng(std::uint64_t seed) noexcept
+            : m_state(seed)
+        {}
+
+        static constexpr result_type min() noexcept
+        {
+            return 0;
+        }
+
+        static constexpr result_type max() noexcept
+        {
+            return ~result_type(0);
+        }
+
+        result_type operator()() noexcept
+        {
+            auto z = (m_state += 0x9e3779b97f4a7c15ull);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            return z ^ (z >> 31);
+        }
+
+        private:
+        std::uint64_t m_state;
+    };
+
+    // the errors are spread over the pool, so every pass over it has exactly the configured ratio
+    std::vector<IDataProvider::Data> makePool(const CDefDataProvider::LoadConfig& config)
+    {
+        CFastRng rng(config.seed);
+        boost::random::uniform_real_distribution<> dist(-100.0, 100.0);
+
+        const auto size = std::max<std::size_t>(config.poolSize, 1);
+        const auto errors = static_cast<std::size_t>(std::lround(std::clamp(config.errorRatio, 0.0, 1.0) * static_cast<double>(size)));
+
+        std::vector<IDataProvider::Data> pool;
+        pool.reserve(size);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            pool.push_back(i < errors ? IDataProvider::Data("an error") : boost::lexical_cast<std::string>(dist(rng)));
+        }
+        std::shuffle(pool.begin(), pool.end(), rng);
+
+        return pool;
+    }
+
+    // it removes the handlers whose connections are closed
+    template <typename THandler>
+    void pruneHandlers(std::vector<std::pair<IDataProvider::Connection, THandler>>& handlers)
+    {
+        handlers.erase(std::remove_if(handlers.begin(), handlers.end(), [](const auto& el) { return !el.first.connected(); }),
+                       handlers.end());
+    }
+
+    // the connection is checked per call, so a handler isn't called after its connection is closed
+    template <typename THandler, typename TData>
+    void callHandlers(const std::vector<std::pair<IDataProvider::Connection, THandler>>& handlers, const TData& data)
+    {
+        for (const auto& el : handlers)
+        {
+            if (el.first.connected())
+            {
+                el.second(data);
+            }
+        }
+    }
+} // end namespace
+
+    CDefDataProvider::CDefDataProvider(std::size_t ringCapacity)
+        : m_ringCapacity(ringCapacity)
     {}
 
     CDefDataProvider::~CDefDataProvider()
@@ -20,44 +103,243 @@ namespace services
 
     IDataProvider::Connection CDefDataProvider::onNewData(const FNewDataHandler& handler)
     {
-        return m_newDataReady.connect(handler);
+        auto connection = m_newDataReady.connect(handler);
+        {
+            std::lock_guard<std::mutex> lock(m_handlersMutex);
+            pruneHandlers(m_handlers);
+            m_handlers.emplace_back(connection, handler);
+        }
+        m_handlersVersion.fetch_add(1, std::memory_order_release);
+        return connection;
+    }
+
+    IDataProvider::Connection CDefDataProvider::onNewDataView(const FNewDataViewHandler& handler)
+    {
+        auto connection = m_newDataViewReady.connect(handler);
+        {
+            std::lock_guard<std::mutex> lock(m_handlersMutex);
+            pruneHandlers(m_viewHandlers);
+            m_viewHandlers.emplace_back(connection, handler);
+        }
+        m_handlersVersion.fetch_add(1, std::memory_order_release);
+        return connection;
+    }
+
+    void CDefDataProvider::setDeliveryMode(DeliveryMode mode)
+    {
+        m_mode = mode;
+    }
+
+    void CDefDataProvider::setLoadMode(const LoadConfig& config)
+    {
+        m_isLoadMode = true;
+        m_loadConfig = config;
+    }
+
+    std::uint64_t CDefDataProvider::droppedCount() const noexcept
+    {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t CDefDataProvider::producedCount() const noexcept
+    {
+        return m_produced.load(std::memory_order_relaxed);
+    }
+
+    template <typename TData>
+    void CDefDataProvider::setNewData(TData&& data)
+    {
+        OPTIONAL_EXT_TRACE_SCOPE("setNewData", "provider");
+
+        m_produced.store(m_produced.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        if (m_mode == DeliveryMode::synchronous)
+        {
+            emitNewData(data);
+            return;
+        }
+
+        // the ring is FIFO, so the n-th pushed data is the n-th delivered one
+        // the begin is recorded before the push, so it precedes the end the consumer may record at once,
+        // a dropped data leaves a begin whose id is taken by the next pushed one
+        OPTIONAL_EXT_TRACE_FLOW_BEGIN("ring", m_produced.load(std::memory_order_relaxed) - m_dropped.load(std::memory_order_relaxed));
+
+        // the producer never waits for the consumer, a full ring means the consumer is behind
+        if (!m_ring->tryPush(std::forward<TData>(data)))
+        {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
     }
 
-    void CDefDataProvider::setNewData(const Data& data)
+    void CDefDataProvider::emitNewData(const Data& data)
     {
+        OPTIONAL_EXT_TRACE_SCOPE("emitNewData", "provider");
+
         if (!m_newDataReady.empty())
         {
             m_newDataReady(data);
         }
+
+        // the view points into the pool, the sample or the consumer's buffer, none of them changes until the handlers return
+        if (!m_newDataViewReady.empty())
+        {
+            m_newDataViewReady(DataView(data));
+        }
+    }
+
+    void CDefDataProvider::drain()
+    {
+        OPTIONAL_EXT_TRACE_THREAD_NAME("provider consumer");
+
+        // a delivery doesn't lock the signals, the handlers are copied again only when one is added
+        std::vector<std::pair<Connection, FNewDataHandler>> handlers;
+        std::vector<std::pair<Connection, FNewDataViewHandler>> viewHandlers;
+        std::uint64_t handlersVersion = 0;
+        bool isCopied = false;
+
+        Data data;
+        std::size_t idle = 0;
+
+        while (true)
+        {
+            // the flag is read before the ring, so an empty ring after the last push means there is nothing left
+            const auto isProducing = m_isProducing.load(std::memory_order_acquire);
+
+            if (m_ring->tryPop(data))
+            {
+                OPTIONAL_EXT_TRACE_SCOPE("deliver", "consumer");
+                ++m_delivered;
+                OPTIONAL_EXT_TRACE_FLOW_END("ring", m_delivered);
+
+                const auto version = m_handlersVersion.load(std::memory_order_acquire);
+                if (!isCopied || version != handlersVersion)
+                {
+                    std::lock_guard<std::mutex> lock(m_handlersMutex);
+                    handlers = m_handlers;
+                    viewHandlers = m_viewHandlers;
+                    handlersVersion = version;
+                    isCopied = true;
+                }
+
+                callHandlers(handlers, data);
+                callHandlers(viewHandlers, DataView(data));
+                idle = 0;
+                continue;
+            }
+
+            if (!isProducing)
+            {
+                break;
+            }
+
+            using namespace std::chrono_literals;
+
+            if (++idle < 64)
+            {
+                std::this_thread::yield();
+            }
+            else
+            {
+                std::this_thread::sleep_for(50us);
+            }
+        }
     }
 
     void CDefDataProvider::start()
     {
         m_isStopped.store(false, std::memory_order_relaxed);
+        m_isProducing.store(true, std::memory_order_relaxed);
+
+        if (m_mode == DeliveryMode::ring)
+        {
+            if (!m_ring)
+            {
+                m_ring = std::make_unique<CSpscRing<Data>>(m_ringCapacity);
+            }
+            m_consumer = std::thread([this] { drain(); });
+        }
+
         m_worker = std::thread([this] {
-            boost::random::random_device rng;
+            OPTIONAL_EXT_TRACE_THREAD_NAME("provider worker");
+
+            if (m_isLoadMode)
+            {
+                generateLoad();
+            }
+            else
+            {
+                generateSamples();
+            }
 
-            boost::random::uniform_real_distribution<> dist(-100.0, 100.0);
-            boost::random::uniform_int_distribution<> errDist(1, 100);
+            m_isProducing.store(false, std::memory_order_release);
+        });
+    }
+
+    void CDefDataProvider::generateSamples()
+    {
+        boost::random::random_device rng;
 
-            while (!m_isStopped.load(std::memory_order_relaxed))
-            { 
-                using namespace std::chrono_literals;
+        boost::random::uniform_real_distribution<> dist(-100.0, 100.0);
+        boost::random::uniform_int_distribution<> errDist(1, 100);
 
-                auto isError = errDist(rng) % 5 == 0;
+        while (!m_isStopped.load(std::memory_order_relaxed))
+        { 
+            using namespace std::chrono_literals;
+
+            auto isError = errDist(rng) % 5 == 0;
+
+            if (isError)
+            {
+                setNewData(Data("an error"));
+            }
+            else {
+                auto newValue = dist(rng);
+                setNewData(boost::lexical_cast<std::string>(newValue));
+            }
+
+            std::this_thread::sleep_for(1s);
+        }
+    }
 
-                if (isError)
+    void CDefDataProvider::generateLoad()
+    {
+        using namespace std::chrono_literals;
+        using Clock = std::chrono::steady_clock;
+
+        // the messages are passed by reference, in the ring mode they are copied into the slots which keep their buffers
+        const auto pool = makePool(m_loadConfig);
+        const auto isPaced = m_loadConfig.rate > 0.0;
+        const auto period = isPaced ? std::chrono::duration<double>(1.0 / m_loadConfig.rate) : std::chrono::duration<double>::zero();
+        const auto start = Clock::now();
+
+        std::size_t index = 0;
+        for (std::uint64_t sent = 0; m_loadConfig.messages == 0 || sent < m_loadConfig.messages; ++sent)
+        {
+            if (m_isStopped.load(std::memory_order_relaxed))
+            {
+                break;
+            }
+
+            if (isPaced)
+            {
+                // the schedule is absolute, a late message is sent at once and the rate catches up
+                const auto due = start + std::chrono::duration_cast<Clock::duration>(period * static_cast<double>(sent));
+                for (auto now = Clock::now(); now < due; now = Clock::now())
                 {
-                    setNewData("an error");   
-                }
-                else {
-                    auto newValue = dist(rng);
-                    setNewData(boost::lexical_cast<std::string>(newValue));
+                    if (due - now > 200us)
+                    {
+                        std::this_thread::sleep_until(due - 100us);
+                    }
+                    else
+                    {
+                        std::this_thread::yield();
+                    }
                 }
-
-                std::this_thread::sleep_for(1s);
             }
-        });
+
+            setNewData(pool[index]);
+            index = index + 1 == pool.size() ? 0 : index + 1;
+        }
     }
 
     void CDefDataProvider::stop()
@@ -71,6 +353,12 @@ namespace services
         {
             m_worker.join();
         }
+
+        // the consumer delivers everything the worker has pushed before it exits
+        if (m_consumer.joinable())
+        {
+            m_consumer.join();
+        }
     }
 
 } // end namepsace services
\ No newline at end of file
@@ -1,10 +1,16 @@
 #pragma once
 
 #include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <thread>
+#include <utility>
+#include <vector>
 #include <boost/noncopyable.hpp>
 #include <boost/signals2/signal.hpp>
 #include "IDataProvider.h"
+#include "CSpscRing.h"
 
 namespace services
 {
@@ -12,7 +18,24 @@ class CDefDataProvider: public IDataProvider, boost::noncopyable
 {
     public:
 
-    CDefDataProvider();
+    static constexpr std::size_t defaultRingCapacity = 1024;
+
+    // It's a configuration of the load-generator mode
+    struct LoadConfig
+    {
+        // messages per second, 0 means as fast as possible
+        double rate = 0.0;
+        // the same seed gives the same sequence of messages
+        std::uint64_t seed = 42;
+        // the share of messages which aren't numbers
+        double errorRatio = 0.2;
+        // the messages are drawn from a pool generated once by start()
+        std::size_t poolSize = 4096;
+        // the worker stops by itself after this number of messages, 0 means only stop() stops it
+        std::uint64_t messages = 0;
+    };
+
+    explicit CDefDataProvider(std::size_t ringCapacity = defaultRingCapacity);
     ~CDefDataProvider() override;
 
     void start() override;
@@ -20,16 +43,55 @@ class CDefDataProvider: public IDataProvider, boost::noncopyable
 
     void wait() override;
 
+    // in the ring mode the consumer calls the handlers directly instead of through the signals,
+    // it copies them again only when a handler is added and checks the connection of each one per data
     Connection onNewData(const FNewDataHandler& handler) override;
+    Connection onNewDataView(const FNewDataViewHandler& handler) override;
+
+    void setDeliveryMode(DeliveryMode mode) override;
+
+    // it switches the worker from one random message per second to the load generator, it must be called before start()
+    void setLoadMode(const LoadConfig& config);
+
+    // the number of data dropped because the ring was full
+    std::uint64_t droppedCount() const noexcept;
+    // the number of data produced by the worker
+    std::uint64_t producedCount() const noexcept;
 
     private:
-    void setNewData(const Data& data);
+    void generateSamples();
+    void generateLoad();
+
+    template <typename TData>
+    void setNewData(TData&& data);
+    void emitNewData(const Data& data);
+    void drain();
 
     private:
     boost::signals2::signal<IDataProvider::FNewData> m_newDataReady;
+    boost::signals2::signal<IDataProvider::FNewDataView> m_newDataViewReady;
+    // the handlers with their connections, the ring consumer doesn't go through the signals for every data
+    std::mutex m_handlersMutex;
+    std::vector<std::pair<Connection, FNewDataHandler>> m_handlers;
+    std::vector<std::pair<Connection, FNewDataViewHandler>> m_viewHandlers;
+    // it's increased when a handler is added, the consumer copies the handlers when it changes
+    std::atomic<std::uint64_t> m_handlersVersion{0};
+
+    DeliveryMode m_mode = DeliveryMode::synchronous;
+    std::size_t m_ringCapacity;
+    std::unique_ptr<CSpscRing<Data>> m_ring;
+    std::atomic<std::uint64_t> m_dropped{0};
+    std::atomic<std::uint64_t> m_produced{0};
+    // the number of data taken from the ring by the consumer, it's the id of the data's flow in the trace
+    std::uint64_t m_delivered = 0;
+
+    bool m_isLoadMode = false;
+    LoadConfig m_loadConfig;
 
     std::atomic<bool> m_isStopped{true};
+    std::atomic<bool> m_isProducing{false};
     std::thread m_worker;
+    std::thread m_consumer;
 
 };
 
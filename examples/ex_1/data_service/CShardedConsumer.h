@@ -0,0 +1,232 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <boost/optional_ext/tracing.hpp>
+#include "IDataProvider.h"
+#include "CSpscRing.h"
+
+namespace services
+{
+/**
+ * It's a consumer which shards the data across worker threads, every worker runs its own copy of the pipeline
+ * The pipeline is called as pipeline(data, partial) and folds the data into the worker's partial aggregate.
+ * The workers publish their partials after every batch into padded per-shard slots, combine() sums them with +=.
+ * The data is dispatched by one thread (e.g. a handler of IDataProvider::onNewDataView), it's copied into a ring slot
+ * whose buffer is reused, a message which fits no ring is dropped.
+ *
+ * an example of usage:
+ *
+ *    services::CShardedConsumer<Partial, decltype(pipeline)> consumer(std::thread::hardware_concurrency(), pipeline);
+ *    provider.onNewDataView([&consumer](services::IDataProvider::DataView data) { consumer.dispatch(data); });
+ *
+ *    consumer.start();
+ *    provider.start();
+ *    consumer.waitUntil([](const Partial& total) { return total.acc >= 100; });
+ */
+template <typename TPartial, typename TPipeline>
+class CShardedConsumer: boost::noncopyable
+{
+    public:
+
+    static constexpr std::size_t defaultRingCapacity = 4096;
+    static constexpr std::size_t batchSize = 256;
+
+    CShardedConsumer(std::size_t shards, const TPipeline& pipeline, std::size_t ringCapacity = defaultRingCapacity)
+    {
+        m_shards.reserve(shards > 0 ? shards : 1);
+        for (std::size_t i = 0; i < m_shards.capacity(); ++i)
+        {
+            m_shards.push_back(std::make_unique<CShard>(pipeline, ringCapacity));
+        }
+    }
+
+    ~CShardedConsumer()
+    {
+        stop();
+        wait();
+    }
+
+    std::size_t shards() const noexcept
+    {
+        return m_shards.size();
+    }
+
+    void start()
+    {
+        m_isStopped.store(false, std::memory_order_relaxed);
+        for (std::size_t i = 0; i < m_shards.size(); ++i)
+        {
+            m_shards[i]->worker = std::thread([this, i] { run(i); });
+        }
+    }
+
+    // the workers process everything dispatched before stop() and exit, the data dispatched later may be left in the rings
+    void stop()
+    {
+        m_isStopped.store(true, std::memory_order_release);
+    }
+
+    void wait()
+    {
+        for (auto& shard : m_shards)
+        {
+            if (shard->worker.joinable())
+            {
+                shard->worker.join();
+            }
+        }
+    }
+
+    // it's called by one thread, the shards are tried round-robin starting from the next one
+    void dispatch(IDataProvider::DataView data)
+    {
+        OPTIONAL_EXT_TRACE_SCOPE("dispatch", "consumer");
+
+        for (std::size_t i = 0; i < m_shards.size(); ++i)
+        {
+            const auto index = m_next;
+            auto& shard = *m_shards[index];
+            m_next = m_next + 1 == m_shards.size() ? 0 : m_next + 1;
+
+            // the rings are FIFO, the n-th data pushed into a shard is the n-th one it processes
+            // the begin precedes the push, a full ring leaves a begin whose id is taken by the next data pushed into the shard
+            OPTIONAL_EXT_TRACE_FLOW_BEGIN("shard", flowId(index, shard.pushed + 1));
+
+            if (shard.ring.tryPush(data))
+            {
+                ++shard.pushed;
+                return;
+            }
+        }
+
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // the number of data dropped because all rings were full
+    std::uint64_t droppedCount() const noexcept
+    {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
+    // it sums the last published partials, a worker publishes after every batch
+    TPartial combine() const
+    {
+        TPartial ret{};
+        for (const auto& shard : m_shards)
+        {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            ret += shard->published;
+        }
+        return ret;
+    }
+
+    // it polls the combined partial until the predicate is true, then stops the workers
+    template <typename TPred>
+    TPartial waitUntil(TPred&& pred, std::chrono::microseconds interval = std::chrono::microseconds(500))
+    {
+        auto total = combine();
+        while (!pred(total))
+        {
+            std::this_thread::sleep_for(interval);
+            total = combine();
+        }
+
+        stop();
+        return total;
+    }
+
+    private:
+    // every shard is on its own cache lines, so the publishing of one worker doesn't disturb the others
+    struct alignas(64) CShard
+    {
+        CShard(const TPipeline& pipeline, std::size_t ringCapacity)
+            : pipeline(pipeline)
+            , ring(ringCapacity)
+        {}
+
+        TPipeline pipeline;
+        CSpscRing<IDataProvider::Data> ring;
+        // it's written only by the dispatching thread, it numbers the flows of the trace
+        std::uint64_t pushed = 0;
+
+        // the ring's producer line is written by the dispatching thread, the published partial is kept off it
+        alignas(64) mutable std::mutex mutex;
+        TPartial published{};
+        // it's the counterpart of pushed written by the worker
+        std::uint64_t popped = 0;
+
+        std::thread worker;
+    };
+
+    std::uint64_t flowId(std::size_t index, std::uint64_t sequence) const noexcept
+    {
+        return sequence * m_shards.size() + index;
+    }
+
+    void run(std::size_t index)
+    {
+        OPTIONAL_EXT_TRACE_THREAD_NAME("shard " + std::to_string(index));
+
+        auto& shard = *m_shards[index];
+        TPartial partial{};
+        IDataProvider::Data data;
+        std::size_t idle = 0;
+
+        while (true)
+        {
+            // the flag is read before the ring, so an empty ring after stop() means there is nothing left
+            const auto isStopped = m_isStopped.load(std::memory_order_acquire);
+
+            std::size_t processed = 0;
+            while (processed < batchSize && shard.ring.tryPop(data))
+            {
+                OPTIONAL_EXT_TRACE_SCOPE("process", "consumer");
+                ++shard.popped;
+                OPTIONAL_EXT_TRACE_FLOW_END("shard", flowId(index, shard.popped));
+
+                shard.pipeline(IDataProvider::DataView(data), partial);
+                ++processed;
+            }
+
+            if (processed > 0)
+            {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                shard.published = partial;
+                idle = 0;
+                continue;
+            }
+
+            if (isStopped)
+            {
+                break;
+            }
+
+            using namespace std::chrono_literals;
+
+            if (++idle < 64)
+            {
+                std::this_thread::yield();
+            }
+            else
+            {
+                std::this_thread::sleep_for(50us);
+            }
+        }
+    }
+
+    private:
+    std::vector<std::unique_ptr<CShard>> m_shards;
+    std::size_t m_next = 0;
+    std::atomic<std::uint64_t> m_dropped{0};
+    std::atomic<bool> m_isStopped{true};
+};
+
+} // end namespace services
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <boost/noncopyable.hpp>
+
+namespace services
+{
+/**
+ * It's a bounded lock-free ring buffer for one producer thread and one consumer thread
+ * The capacity is rounded up to a power of two. Each side keeps a cached copy of the other side's index,
+ * so the shared cache lines are touched only when the cached value says the ring is full (or empty).
+ */
+template <typename T>
+class CSpscRing: boost::noncopyable
+{
+    public:
+
+    explicit CSpscRing(std::size_t capacity)
+        : m_capacity(roundUp(capacity))
+        , m_mask(m_capacity - 1)
+        , m_slots(new T[m_capacity])
+    {}
+
+    std::size_t capacity() const noexcept
+    {
+        return m_capacity;
+    }
+
+    // it's called only by the producer, it returns false and keeps the value if the ring is full
+    template <typename U>
+    bool tryPush(U&& value)
+    {
+        const auto tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_cachedHead == m_capacity)
+        {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail - m_cachedHead == m_capacity)
+            {
+                return false;
+            }
+        }
+
+        m_slots[tail & m_mask] = std::forward<U>(value);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // it's called only by the consumer, it returns false if the ring is empty
+    // The value is swapped with the slot, so a buffer (e.g. of a string) goes back to the ring and is reused by the next push.
+    bool tryPop(T& value)
+    {
+        const auto head = m_head.load(std::memory_order_relaxed);
+        if (head == m_cachedTail)
+        {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head == m_cachedTail)
+            {
+                return false;
+            }
+        }
+
+        using std::swap;
+        swap(value, m_slots[head & m_mask]);
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const noexcept
+    {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+    private:
+    static std::size_t roundUp(std::size_t capacity) noexcept
+    {
+        std::size_t ret = 1;
+        while (ret < capacity)
+        {
+            ret <<= 1;
+        }
+        return ret;
+    }
+
+    private:
+    static constexpr std::size_t cacheLine = 64;
+
+    const std::size_t m_capacity;
+    const std::size_t m_mask;
+    std::unique_ptr<T[]> m_slots;
+
+    // the consumer's line
+    alignas(cacheLine) std::atomic<std::size_t> m_head{0};
+    std::size_t m_cachedTail = 0;
+
+    // the producer's line
+    alignas(cacheLine) std::atomic<std::size_t> m_tail{0};
+    std::size_t m_cachedHead = 0;
+};
+
+} // end namespace services
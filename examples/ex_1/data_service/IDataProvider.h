@@ -1,6 +1,8 @@
 #pragma once
 
 #include <functional>
+#include <string>
+#include <string_view>
 #include <boost/signals2/connection.hpp>
 
 namespace services
@@ -15,6 +17,20 @@ namespace services
         using FNewData = void(const Data&);
         using FNewDataHandler = std::function<FNewData>;
 
+        // A view points into a buffer owned by the provider and is valid only until the handler returns,
+        // a handler which needs the data later has to copy it. The bytes of binary payloads are viewed as chars.
+        using DataView = std::string_view;
+        using FNewDataView = void(DataView);
+        using FNewDataViewHandler = std::function<FNewDataView>;
+
+        // synchronous: the handlers run on the producer thread
+        // ring: the producer pushes into a bounded lock-free queue, a consumer thread runs the handlers
+        enum class DeliveryMode
+        {
+            synchronous,
+            ring
+        };
+
         virtual ~IDataProvider() = default;
 
         virtual void start() = 0;
@@ -22,6 +38,11 @@ namespace services
         virtual void wait() = 0;
 
         virtual Connection onNewData(const FNewDataHandler& handler) = 0;
+        // the handler gets the same data without a std::string, see DataView for the lifetime of the view
+        virtual Connection onNewDataView(const FNewDataViewHandler& handler) = 0;
+
+        // it must be called before start()
+        virtual void setDeliveryMode(DeliveryMode mode) = 0;
 
     };
 } // end namespace service
\ No newline at end of file
@@ -1,15 +1,28 @@
 #include "data_service/CDefDataProvider.h"
+#include "data_service/CShardedConsumer.h"
 #include <stdio.h>
+#include <algorithm>
 #include <chrono>
+#include <fstream>
 #include <iterator>
+#include <memory>
 #include <iostream>
 #include <numeric>
+#include <sstream>
+#include <stdexcept>
 #include <cstdlib> 
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
 
 #include <boost/optional.hpp>
 #include <boost/optional_ext.hpp>
-
-#include <boost/lexical_cast.hpp>
+#include <boost/optional_ext/aggregate.hpp>
+#include <boost/optional_ext/any_pipeline.hpp>
+#include <boost/optional_ext/parse.hpp>
+#include <boost/optional_ext/runtime_pipeline.hpp>
+#include <boost/optional_ext/tracing.hpp>
 
 template<typename T>
 boost::optional<const T&> toOp(const T& value)
@@ -23,29 +36,154 @@ boost::optional<T&> toOp(T& value)
     return value;
 }
 
-boost::optional<double> toDouble(const std::string& value) noexcept
+template<typename T>
+void print(const T& value) noexcept
 {
-    try {
-        return boost::lexical_cast<double>(value);
-    }
-    catch (const boost::bad_lexical_cast& exc)
+    std::cout << "new value from provider: " << value << std::endl;
+}
+
+// It's a partial aggregate of a shard of the load mode
+struct LoadTotals
+{
+    double acc = 0.0;
+    std::uint64_t errors = 0;
+    std::uint64_t processed = 0;
+
+    LoadTotals& operator+=(const LoadTotals& other) noexcept
     {
-        std::cerr << exc.what() << std::endl;
-        return boost::none;
+        acc += other.acc;
+        errors += other.errors;
+        processed += other.processed;
+        return *this;
     }
-}
+};
 
-template<typename T>
-void print(const T& value) noexcept
+// it saturates the pipeline with generated messages and prints the throughput:
+//   boost_optional_ext_example --load [messages per second, 0 is as fast as possible] [number of messages] [number of shards]
+//                                     [a file with a description of the filter, see optional_ext::compile_pipeline]
+template <typename TFilter>
+int runLoad(double rate, std::uint64_t messages, std::size_t shards, TFilter filter)
 {
-    std::cout << "new value from provider: " << value << std::endl;
+    services::CDefDataProvider provider;
+
+    services::CDefDataProvider::LoadConfig config;
+    config.rate = rate;
+    config.messages = messages;
+    provider.setLoadMode(config);
+
+    // every shard runs its own copy of the pipeline, the stages are quiet, the printing would be measured otherwise
+    // the data is parsed right from the ring's buffer, no string is created per message
+    // the sinks update the shard's partial without branches on the outcome
+    auto pipeline = [parse = hof::parse<double>(), filter](services::IDataProvider::DataView data, LoadTotals& totals) mutable {
+        toOp(data) | parse | hof::count_none_into(totals.errors) | filter | hof::sum_into(totals.acc);
+        totals.processed += 1;
+    };
+
+    // the generator thread dispatches straight into the shards' rings
+    services::CShardedConsumer<LoadTotals, decltype(pipeline)> consumer(shards, pipeline);
+    provider.onNewDataView([&consumer](services::IDataProvider::DataView data) { consumer.dispatch(data); });
+
+    const auto start = std::chrono::steady_clock::now();
+    consumer.start();
+    provider.start();
+
+    // the stop condition is evaluated against the combined partials of all shards
+    const auto totals = consumer.waitUntil([&consumer, messages](const LoadTotals& total) {
+        return total.processed + consumer.droppedCount() >= messages;
+    });
+    const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    provider.stop();
+    provider.wait();
+    consumer.wait();
+
+    std::cout << "Shards: " << consumer.shards() << ", Produced: " << provider.producedCount() << ", Processed: " << totals.processed
+              << ", Dropped: " << consumer.droppedCount() << ", Errors: " << totals.errors
+              << ", Throughput: " << static_cast<double>(totals.processed) / seconds << " msg/s, Acc: " << totals.acc << std::endl;
+
+    return 0;
 }
 
-int main()
+// It's a tracing session of the whole run, the trace is written when it goes out of scope:
+//   boost_optional_ext_example --trace <file> [other options]
+class TraceSession
+{
+    public:
+    explicit TraceSession(std::string path)
+        : m_path(std::move(path))
+    {
+#if OPTIONAL_EXT_TRACING
+        OPTIONAL_EXT_TRACE_THREAD_NAME("main");
+        optional_ext::start_tracing();
+#else
+        std::cerr << "the example is built without OPTIONAL_EXT_TRACING, " << m_path << " won't be written" << std::endl;
+#endif
+    }
+
+    ~TraceSession()
+    {
+#if OPTIONAL_EXT_TRACING
+        optional_ext::stop_tracing();
+        if (!optional_ext::write_trace(m_path))
+        {
+            std::cerr << "the trace can't be written to " << m_path << std::endl;
+        }
+#endif
+    }
+
+    private:
+    std::string m_path;
+};
+
+int main(int argc, char* argv[])
 {
+    std::unique_ptr<TraceSession> trace;
+    if (argc > 2 && std::strcmp(argv[1], "--trace") == 0)
+    {
+        trace = std::make_unique<TraceSession>(argv[2]);
+        argc -= 2;
+        argv += 2;
+    }
+
+    if (argc > 1 && std::strcmp(argv[1], "--load") == 0)
+    {
+        const auto rate = argc > 2 ? std::stod(argv[2]) : 0.0;
+        const auto messages = argc > 3 ? std::stoull(argv[3]) : 10000000ull;
+        const auto shards = argc > 4 ? std::stoul(argv[4]) : std::max(1u, std::thread::hardware_concurrency() / 2);
+        if (argc > 5)
+        {
+            // the filter is configured without recompiling, it's the same as the default one for "filter_if(in 0 50)"
+            std::ifstream file(argv[5]);
+            std::stringstream description;
+            description << file.rdbuf();
+            if (!file)
+            {
+                std::cerr << "the filter can't be read from " << argv[5] << std::endl;
+                return 1;
+            }
+
+            optional_ext::runtime_pipeline<double> filter;
+            try
+            {
+                filter = optional_ext::compile_pipeline<double>(description.str());
+            }
+            catch (const std::invalid_argument& exc)
+            {
+                std::cerr << argv[5] << ": " << exc.what() << std::endl;
+                return 1;
+            }
+            return runLoad(rate, messages, shards, hof::runtime(std::move(filter)));
+        }
+
+        auto filter = [](double el) noexcept { return std::isgreaterequal(el, 0.0) && std::islessequal(el, 50.0); };
+        return runLoad(rate, messages, shards, hof::filter_if(filter));
+    }
 
     services::CDefDataProvider provider;
 
+    // the worker only pushes into a lock-free ring, the pipeline runs on the provider's consumer thread
+    provider.setDeliveryMode(services::IDataProvider::DeliveryMode::ring);
+
     double acc = 0.0;
     uint32_t errors = 0;
 
@@ -54,22 +192,30 @@ int main()
     std::list<double> items;
     auto bi = std::back_inserter(items);
 
-    provider.onNewData([&avarageTime, &count, &acc, &errors, &bi, &provider](const services::IDataProvider::Data& data) mutable {
+    auto errorHandler = [&errors] () mutable noexcept {
+        std::cout << "a wrong data recieved" << std::endl;
+        errors += 1;
+    };
 
-        auto errorHandler = [&errors] () mutable noexcept {
-            std::cout << "a wrong data recieved" << std::endl;
-            errors += 1;
+    auto filter = [] (auto&& el) noexcept
+        { 
+            return std::isgreaterequal(el, 0.0) && std::islessequal(el, 50.0);
         };
 
-        auto filter = [] (auto&& el) noexcept
-            { 
-                return std::isgreaterequal(el, 0.0) && std::islessequal(el, 50.0);
-            };
+    auto accept = [&bi] (auto&& el) mutable noexcept {
+        *bi = el;
+        std::cout << "New Value accepted: " << el << std::endl;
+    };
 
-        auto accept = [&bi] (auto&& el) mutable noexcept {
-            *bi = el;
-            std::cout << "New Value accepted: " << el << std::endl;
-        };
+    // the pipeline is built once and applied to every new data, it's kept type-erased without an allocation
+    optional_ext::any_pipeline<const services::IDataProvider::Data&, double> pipeline =
+        hof::pipeline(hof::parse<double>(),
+                      hof::match(print<double>, errorHandler),
+                      hof::filter_if(filter),
+                      hof::match_some(accept))
+        <<= 0.0;
+
+    provider.onNewData([&avarageTime, &count, &acc, &pipeline, &provider](const services::IDataProvider::Data& data) mutable {
 
         auto start = std::chrono::high_resolution_clock::now(); 
 
@@ -92,12 +238,9 @@ int main()
             };
         */
 
-        acc += toOp(data)
-                 | toDouble
-                 | hof::match(print<double>, errorHandler)
-                 | hof::filter_if(filter)
-                 | hof::match_some(accept)
-                 <<= 0.0;
+        // it's the same as:
+        //   toOp(data) | hof::parse<double>() | hof::match(print<double>, errorHandler) | hof::filter_if(filter) | hof::match_some(accept) <<= 0.0;
+        acc += pipeline(data);
 
         auto stop = std::chrono::high_resolution_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
@@ -117,7 +260,7 @@ int main()
 
     provider.wait();
 
-    std::cout << "Final Acc: [" << acc << "], Errors: " << errors << std::endl;
+    std::cout << "Final Acc: [" << acc << "], Errors: " << errors << ", Dropped: " << provider.droppedCount() << std::endl;
     std::cout << "Elements are: ";
     auto check = 0;
     for (const auto& el: items)
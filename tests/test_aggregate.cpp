@@ -0,0 +1,187 @@
+#include <boost/test/unit_test.hpp>
+
+#include <boost/optional.hpp>
+#include <boost/optional_ext.hpp>
+#include <boost/optional_ext/aggregate.hpp>
+#include <boost/optional_ext/parse.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE( aggregate )
+
+namespace {
+
+struct Point
+{
+    double x;
+    double y;
+};
+
+/**
+ * It's a user aggregate of a value type which can't be made from a number
+ */
+struct CentroidAggregate
+{
+    void add(const Point& value, bool isSome)
+    {
+        x += isSome ? value.x : 0.0;
+        y += isSome ? value.y : 0.0;
+        count += isSome;
+    }
+
+    double x = 0.0;
+    double y = 0.0;
+    std::uint64_t count = 0;
+};
+
+} // end namespace
+
+BOOST_AUTO_TEST_CASE(case_sum_and_count)
+{
+    double acc = 0.0;
+    std::uint64_t errors = 0;
+    optional_ext::sum_aggregate<double> sum;
+
+    const std::vector<std::string> inputs = {"1.5", "an error", "-3", "70", "2"};
+    for (const auto& el : inputs)
+    {
+        const auto res = boost::make_optional(el) | hof::parse<double>() | hof::count_none_into(errors)
+            | hof::filter_if([](double value) { return value >= 0.0 && value <= 50.0; }) | hof::sum_into(acc) | hof::sum_into(sum);
+        (void)res;
+    }
+
+    BOOST_CHECK_EQUAL(acc, 3.5);
+    BOOST_CHECK_EQUAL(errors, 1u);
+    BOOST_CHECK_EQUAL(sum.result(), 3.5);
+    BOOST_CHECK_EQUAL(sum.count, 2u);
+    BOOST_CHECK_EQUAL(sum.mean(), 1.75);
+
+    // the sinks pass the optional through
+    BOOST_CHECK_EQUAL(std::make_optional(2) | hof::sum_into(acc) <<= 0, 2);
+    BOOST_CHECK_EQUAL(acc, 5.5);
+}
+
+BOOST_AUTO_TEST_CASE(case_pipeline)
+{
+    double acc = 0.0;
+    std::uint64_t errors = 0;
+    optional_ext::minmax_aggregate<double> range;
+
+    auto pipeline = hof::pipeline(hof::parse<double>(), hof::count_none_into(errors), hof::sum_into(acc), hof::minmax_into(range)) <<= 0.0;
+
+    BOOST_CHECK_EQUAL(pipeline(std::string("4")), 4.0);
+    BOOST_CHECK_EQUAL(pipeline(std::string("x")), 0.0);
+    BOOST_CHECK_EQUAL(pipeline(std::string("-2")), -2.0);
+    BOOST_CHECK_EQUAL(pipeline(boost::optional<std::string>()), 0.0);
+
+    BOOST_CHECK_EQUAL(acc, 2.0);
+    BOOST_CHECK_EQUAL(errors, 2u);
+    BOOST_CHECK_EQUAL(range.min, -2.0);
+    BOOST_CHECK_EQUAL(range.max, 4.0);
+    BOOST_CHECK_EQUAL(range.count, 2u);
+}
+
+BOOST_AUTO_TEST_CASE(case_user_aggregate)
+{
+    CentroidAggregate centroid;
+
+    auto toPoint = [](double el) { return el >= 0.0 ? boost::make_optional(Point{el, 2.0 * el}) : boost::none; };
+    auto pipeline = hof::pipeline(toPoint, hof::sum_into(centroid));
+
+    for (double el : {1.0, -1.0, 3.0})
+    {
+        (void)pipeline(el);
+    }
+    (void)(boost::optional<Point>() | hof::sum_into(centroid));
+
+    BOOST_CHECK_EQUAL(centroid.x, 4.0);
+    BOOST_CHECK_EQUAL(centroid.y, 8.0);
+    BOOST_CHECK_EQUAL(centroid.count, 2u);
+}
+
+BOOST_AUTO_TEST_CASE(case_kahan)
+{
+    optional_ext::sum_aggregate<float> naive;
+    optional_ext::kahan_sum_aggregate<float> kahan;
+
+    (void)(boost::make_optional(1.0f) | hof::sum_into(naive) | hof::sum_into(kahan));
+    for (int i = 0; i < 100000; ++i)
+    {
+        (void)(boost::make_optional(1e-8f) | hof::sum_into(naive) | hof::sum_into(kahan));
+    }
+
+    BOOST_CHECK_EQUAL(naive.result(), 1.0f);
+    BOOST_CHECK_CLOSE(kahan.result(), 1.001f, 1e-3);
+    BOOST_CHECK_EQUAL(kahan.count, 100001u);
+
+    optional_ext::kahan_sum_aggregate<float> other;
+    other.add(-1.0f, true);
+    kahan += other;
+    BOOST_CHECK_CLOSE(kahan.result(), 0.001f, 1e-1);
+    BOOST_CHECK_EQUAL(kahan.count, 100002u);
+}
+
+BOOST_AUTO_TEST_CASE(case_histogram)
+{
+    optional_ext::histogram_aggregate<double> histogram(0.0, 10.0, 5);
+
+    for (double el : {-1.0, 0.0, 1.9, 2.0, 9.99, 10.0, 1e9})
+    {
+        (void)(boost::make_optional(el) | hof::histogram_into(histogram));
+    }
+    (void)(boost::optional<double>() | hof::histogram_into(histogram));
+    (void)(boost::make_optional(std::numeric_limits<double>::quiet_NaN()) | hof::histogram_into(histogram));
+
+    BOOST_CHECK_EQUAL(histogram.bins(), 5u);
+    BOOST_CHECK_EQUAL(histogram.underflow(), 2u);
+    BOOST_CHECK_EQUAL(histogram[0], 2u);
+    BOOST_CHECK_EQUAL(histogram[1], 1u);
+    BOOST_CHECK_EQUAL(histogram[4], 1u);
+    BOOST_CHECK_EQUAL(histogram.overflow(), 2u);
+    BOOST_CHECK_EQUAL(histogram.count(), 8u);
+
+    optional_ext::histogram_aggregate<double> other(0.0, 10.0, 4);
+    BOOST_CHECK_THROW(histogram += other, std::invalid_argument);
+    BOOST_CHECK_THROW(optional_ext::histogram_aggregate<double>(1.0, 1.0, 4), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(case_combinable)
+{
+    optional_ext::combinable<optional_ext::sum_aggregate<std::int64_t>> total;
+    optional_ext::combinable<std::uint64_t> empty;
+    optional_ext::combinable<optional_ext::histogram_aggregate<int>> histogram(optional_ext::histogram_aggregate<int>(0, 100, 10));
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < 1000; ++i)
+            {
+                auto op = i % 10 == 0 ? boost::optional<int>() : boost::make_optional(i % 100);
+                (void)(op | hof::count_none_into(empty) | hof::sum_into(total) | hof::histogram_into(histogram));
+            }
+        });
+    }
+    for (auto& el : threads)
+    {
+        el.join();
+    }
+
+    const auto sum = total.combine();
+    BOOST_CHECK_EQUAL(sum.count, 3600u);
+    BOOST_CHECK_EQUAL(sum.sum, 4 * 10 * (4950 - 450));
+    BOOST_CHECK_EQUAL(empty.combine(), 400u);
+    BOOST_CHECK_EQUAL(histogram.combine().count(), 3600u);
+    BOOST_CHECK_EQUAL(histogram.combine()[0], 4u * 10u * 9u);
+
+    total.clear();
+    BOOST_CHECK_EQUAL(total.combine().count, 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,104 @@
+#include <boost/test/unit_test.hpp>
+
+#include <boost/optional.hpp>
+#include <boost/optional_ext.hpp>
+#include <boost/optional_ext/any_pipeline.hpp>
+#include <boost/optional_ext/parse.hpp>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE( any_pipeline )
+
+BOOST_AUTO_TEST_CASE(case_fused_pipelines_in_a_container)
+{
+    int errors = 0;
+    auto filter = [](double el) { return el >= 0.0 && el <= 50.0; };
+
+    std::vector<optional_ext::any_pipeline<std::string_view, double>> pipelines;
+    pipelines.emplace_back(hof::pipeline(hof::parse<double>(), hof::match_none([&errors]() { ++errors; }), hof::filter_if(filter)) <<= -1.0);
+    pipelines.emplace_back(hof::pipeline(hof::parse<int>(), [](int el) { return el * 0.5; }) <<= 0.0);
+    pipelines.emplace_back([](std::string_view el) { return static_cast<double>(el.size()); });
+
+    const std::string text = "42";
+    BOOST_CHECK_EQUAL(pipelines[0](text), 42.0);
+    BOOST_CHECK_EQUAL(pipelines[1](text), 21.0);
+    BOOST_CHECK_EQUAL(pipelines[2](text), 2.0);
+
+    BOOST_CHECK_EQUAL(pipelines[0]("an error"), -1.0);
+    BOOST_CHECK_EQUAL(pipelines[0]("70"), -1.0);
+    BOOST_CHECK_EQUAL(errors, 1);
+
+    // the growth of the vector moves the pipelines
+    for (int i = 0; i < 16; ++i)
+    {
+        pipelines.emplace_back(hof::pipeline(hof::parse<double>()) <<= static_cast<double>(i));
+    }
+    BOOST_CHECK_EQUAL(pipelines[0]("1.5"), 1.5);
+    BOOST_CHECK_EQUAL(pipelines[18]("x"), 15.0);
+}
+
+BOOST_AUTO_TEST_CASE(case_move_only)
+{
+    auto scale = std::make_unique<int>(3);
+    optional_ext::any_pipeline<const boost::optional<int>&, int> pipeline = [scale = std::move(scale)](const boost::optional<int>& op) {
+        return op | [&scale](int el) { return el * *scale; } <<= 0;
+    };
+
+    static_assert(!std::is_copy_constructible<decltype(pipeline)>::value, "any_pipeline is move-only");
+    BOOST_CHECK_EQUAL(pipeline(boost::make_optional(2)), 6);
+
+    auto moved = std::move(pipeline);
+    BOOST_CHECK(!pipeline);
+    BOOST_CHECK(static_cast<bool>(moved));
+    BOOST_CHECK_EQUAL(moved(boost::optional<int>()), 0);
+    BOOST_CHECK_THROW(pipeline(boost::make_optional(2)), std::bad_function_call);
+
+    pipeline = std::move(moved);
+    BOOST_CHECK_EQUAL(pipeline(boost::make_optional(1)), 3);
+    pipeline = nullptr;
+    BOOST_CHECK(!pipeline);
+}
+
+BOOST_AUTO_TEST_CASE(case_lifetime)
+{
+    auto counter = std::make_shared<int>(0);
+    {
+        optional_ext::any_pipeline<int, void> pipeline = [counter](int el) { *counter += el; };
+        pipeline(2);
+        BOOST_CHECK_EQUAL(counter.use_count(), 2);
+
+        optional_ext::any_pipeline<int, void> other = std::move(pipeline);
+        other(3);
+        BOOST_CHECK_EQUAL(counter.use_count(), 2);
+
+        other = [](int) {};
+        BOOST_CHECK_EQUAL(counter.use_count(), 1);
+
+        other = [counter](int el) { *counter -= el; };
+        other(1);
+    }
+    BOOST_CHECK_EQUAL(counter.use_count(), 1);
+    BOOST_CHECK_EQUAL(*counter, 4);
+}
+
+BOOST_AUTO_TEST_CASE(case_capacity)
+{
+    struct Big
+    {
+        char data[100];
+        int operator()(int el) const { return el + data[0]; }
+    };
+
+    // a larger callable needs a larger buffer, it's never allocated on the heap
+    optional_ext::any_pipeline<int, int, sizeof(Big)> pipeline = Big{{1}};
+    BOOST_CHECK_EQUAL(pipeline(1), 2);
+    static_assert(sizeof(decltype(pipeline)) <= sizeof(Big) + 3 * sizeof(void*) + alignof(std::max_align_t), "the buffer is inline");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,135 @@
+#include <boost/test/unit_test.hpp>
+
+#include <boost/optional.hpp>
+#include <boost/optional_ext.hpp>
+#include <boost/optional_ext/async.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+BOOST_AUTO_TEST_SUITE( async )
+
+BOOST_AUTO_TEST_CASE(case_async_map)
+{
+    auto res = boost::make_optional(std::string("21")) | hof::async_map([](const std::string& el) { return std::stoi(el) * 2; });
+    auto none = boost::optional<std::string>() | hof::async_map([](const std::string& el) { return std::stoi(el) * 2; });
+
+    static_assert(std::is_same<decltype(res), optional_ext::optional_future<int>>::value, "async_map returns a future");
+    BOOST_CHECK_EQUAL(std::move(res).get().get(), 42);
+    BOOST_CHECK(none.is_ready());
+    BOOST_CHECK(!std::move(none).get().has_value());
+}
+
+BOOST_AUTO_TEST_CASE(case_async_flat_map)
+{
+    auto toInt = [](const std::string& el) -> boost::optional<int> {
+        try
+        {
+            return std::stoi(el);
+        }
+        catch (...)
+        {
+            return boost::none;
+        }
+    };
+
+    const int res = boost::make_optional(std::string("7")) | hof::async_flat_map(toInt) <<= -1;
+    const int error = boost::make_optional(std::string("x")) | hof::async_flat_map(toInt) <<= -1;
+
+    BOOST_CHECK_EQUAL(res, 7);
+    BOOST_CHECK_EQUAL(error, -1);
+}
+
+BOOST_AUTO_TEST_CASE(case_pipeable_future)
+{
+    std::atomic<int> someCounter{0};
+
+    const auto value = boost::make_optional(10)
+        | hof::async_map([](int el) { return el + 1; })
+        | hof::filter_if([](int el) { return el % 2 == 1; })
+        | hof::match_some([&someCounter](int) { ++someCounter; })
+        | [](int el) { return el * 2; }
+        | hof::async_map([](int el) { return std::to_string(el); })
+        <<= std::string("none");
+
+    auto orElse = boost::make_optional(1) | hof::async_flat_map([](int) { return boost::optional<int>(); }) |= []() { return 5; };
+
+    BOOST_CHECK_EQUAL(value, "22");
+    BOOST_CHECK_EQUAL(someCounter.load(), 1);
+    BOOST_CHECK_EQUAL(std::move(orElse) <<= 0, 5);
+}
+
+BOOST_AUTO_TEST_CASE(case_exception)
+{
+    auto fut = boost::make_optional(1) | hof::async_map([](int) -> int { throw std::runtime_error("error"); }) | [](int el) { return el + 1; };
+
+    BOOST_CHECK_THROW(std::move(fut).get(), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(case_executors)
+{
+    optional_ext::inline_executor executor;
+    auto fut = boost::make_optional(1) | hof::async_map([](int el) { return el + 1; }, executor);
+
+    BOOST_CHECK(fut.is_ready());
+    BOOST_CHECK_EQUAL(std::move(fut).get().get(), 2);
+
+    optional_ext::thread_pool pool(2);
+    const auto res = std::make_optional(std::make_unique<int>(3))
+        | hof::async_map([](std::unique_ptr<int>&& el) { return *el * 3; }, pool)
+        <<= 0;
+    BOOST_CHECK_EQUAL(res, 9);
+}
+
+BOOST_AUTO_TEST_CASE(case_thread_pool_runs_all_tasks)
+{
+    std::atomic<int> counter{0};
+    {
+        optional_ext::thread_pool pool(4);
+        for (int i = 0; i < 1000; ++i)
+        {
+            pool.execute([&counter, &pool]() {
+                // a task posted by a worker goes to its own deque
+                pool.execute([&counter]() { ++counter; });
+            });
+        }
+    }
+
+    BOOST_CHECK_EQUAL(counter.load(), 1000);
+}
+
+BOOST_AUTO_TEST_CASE(case_stages_overlap)
+{
+    constexpr int tasks = 4;
+    optional_ext::thread_pool pool(tasks);
+    std::atomic<int> started{0};
+
+    // every task waits for all others, it completes only if they run concurrently
+    auto rendezvous = [&started](int el) {
+        ++started;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (started.load() < tasks && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::yield();
+        }
+        return started.load() == tasks ? el : -1;
+    };
+
+    std::vector<optional_ext::optional_future<int>> futures;
+    for (int i = 0; i < tasks; ++i)
+    {
+        futures.push_back(boost::make_optional(i) | hof::async_map(rendezvous, pool));
+    }
+
+    for (int i = 0; i < tasks; ++i)
+    {
+        BOOST_CHECK_EQUAL(std::move(futures[i]) <<= -2, i);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
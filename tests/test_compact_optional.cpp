@@ -0,0 +1,121 @@
+#include <boost/test/unit_test.hpp>
+
+#include <boost/optional.hpp>
+#include <boost/optional_ext.hpp>
+#include <boost/optional_ext/compact_optional.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE( compact_optional )
+
+namespace {
+
+enum class Channel : std::uint8_t
+{
+    left,
+    right,
+    none = 0xff
+};
+
+using TReading = optional_ext::compact_optional<double>;
+using TChannel = optional_ext::compact_optional<Channel, optional_ext::sentinel_policy<Channel, Channel::none>>;
+
+} // end namespace
+
+BOOST_AUTO_TEST_CASE(case_layout_and_interface)
+{
+    static_assert(sizeof(TReading) == sizeof(double), "the empty state takes no space");
+    static_assert(sizeof(optional_ext::compact_optional<std::int32_t>) == sizeof(std::int32_t), "the empty state takes no space");
+    static_assert(sizeof(TChannel) == 1, "the empty state takes no space");
+    static_assert(std::is_trivially_copyable<TReading>::value, "it's copied as the value");
+    static_assert(optional_detail::is_optional_type<TReading>::value, "the operators recognize it");
+    static_assert(std::is_same<optional_detail::optional_value_type<const TReading&>::type, const double&>::value, "the value is referenced");
+
+    TReading reading;
+    BOOST_CHECK(!reading);
+    BOOST_CHECK(reading == boost::none);
+    BOOST_CHECK_THROW(reading.value(), boost::bad_optional_access);
+    BOOST_CHECK_EQUAL(reading.value_or(1.0), 1.0);
+
+    reading = 2.5;
+    BOOST_CHECK(reading.is_initialized());
+    BOOST_CHECK_EQUAL(*reading, 2.5);
+    BOOST_CHECK_EQUAL(reading.get(), 2.5);
+    BOOST_CHECK(reading.to_optional() == boost::make_optional(2.5));
+
+    // any NaN is empty
+    reading = -std::numeric_limits<double>::quiet_NaN();
+    BOOST_CHECK(!reading);
+    BOOST_CHECK(reading == TReading());
+
+    optional_ext::compact_optional<int> count(boost::make_optional(3));
+    BOOST_CHECK_EQUAL(count.value(), 3);
+    count.reset();
+    BOOST_CHECK(!count);
+    BOOST_CHECK(optional_ext::compact_optional<int>(std::numeric_limits<int>::max()) == boost::none);
+
+    TChannel channel(Channel::right);
+    BOOST_CHECK(channel.value() == Channel::right);
+    channel = boost::none;
+    BOOST_CHECK(!channel.has_value());
+}
+
+BOOST_AUTO_TEST_CASE(case_operators)
+{
+    const TReading some(4.0);
+    const TReading none;
+
+    auto scaled = some | [](double el) { return el * 2.0; };
+    static_assert(std::is_same<decltype(scaled), TReading>::value, "a map to the same type keeps compact_optional");
+    BOOST_CHECK_EQUAL(*scaled, 8.0);
+    BOOST_CHECK(!(none | [](double el) { return el * 2.0; }));
+
+    // NaN produced by a map function is empty
+    BOOST_CHECK(!(some | [](double el) { return std::sqrt(-el); }));
+
+    auto text = some | [](double el) { return std::to_string(static_cast<int>(el)); };
+    static_assert(std::is_same<decltype(text), boost::optional<std::string>>::value, "another type is kept in boost::optional");
+    BOOST_CHECK_EQUAL(*text, "4");
+
+    auto ref = toRefOp(some);
+    static_assert(std::is_same<decltype(ref), boost::optional<const double&>>::value, "a reference is kept in boost::optional");
+    BOOST_CHECK_EQUAL(&*ref, &*some);
+
+    BOOST_CHECK_EQUAL(some | hof::filter_if([](double el) { return el > 5.0; }) <<= -1.0, -1.0);
+    BOOST_CHECK_EQUAL((none |= []() { return 3.0; }) <<= 0.0, 3.0);
+    BOOST_CHECK_EQUAL(none <<= []() { return 7.0; }, 7.0);
+
+    auto count = 0;
+    (void)(none | hof::match_none([&count]() { ++count; }));
+    BOOST_CHECK_EQUAL(count, 1);
+
+    auto positive = [](double el) { return el > 0.0 ? TReading(el) : TReading(); };
+    BOOST_CHECK((boost::make_optional(-1.0) | positive) == TReading());
+}
+
+BOOST_AUTO_TEST_CASE(case_dense_array)
+{
+    std::vector<TReading> readings(16);
+    for (std::size_t i = 0; i < readings.size(); i += 2)
+    {
+        readings[i] = static_cast<double>(i);
+    }
+
+    auto pipeline = hof::pipeline(hof::filter_if([](double el) { return el < 10.0; }), [](double el) { return el + 0.5; }) <<= 0.0;
+
+    double acc = 0.0;
+    for (const auto& reading : readings)
+    {
+        acc += pipeline(reading);
+    }
+
+    BOOST_CHECK_EQUAL(acc, 0.5 + 2.5 + 4.5 + 6.5 + 8.5);
+    BOOST_CHECK(hof::pipeline([](double el) { return el * 2.0; })(readings[2]) == TReading(4.0));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
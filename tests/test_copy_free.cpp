@@ -0,0 +1,267 @@
+#include <boost/test/unit_test.hpp>
+
+#include <boost/any.hpp>
+#include <boost/optional.hpp>
+#include <boost/optional_ext.hpp>
+
+#include <any>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE( copy_free )
+
+namespace {
+
+/**
+ * It's a payload which counts its copies and moves
+ */
+struct Counted
+{
+    static std::size_t copies;
+    static std::size_t moves;
+
+    static void reset()
+    {
+        copies = 0;
+        moves = 0;
+    }
+
+    explicit Counted(int value)
+        : value(value)
+    {
+    }
+
+    Counted(const Counted& other)
+        : value(other.value)
+    {
+        ++copies;
+    }
+
+    Counted(Counted&& other) noexcept
+        : value(other.value)
+    {
+        ++moves;
+    }
+
+    Counted& operator=(const Counted& other)
+    {
+        value = other.value;
+        ++copies;
+        return *this;
+    }
+
+    Counted& operator=(Counted&& other) noexcept
+    {
+        value = other.value;
+        ++moves;
+        return *this;
+    }
+
+    int value;
+};
+
+std::size_t Counted::copies = 0;
+std::size_t Counted::moves = 0;
+
+void checkCounts(std::size_t copies, std::size_t moves)
+{
+    BOOST_CHECK_EQUAL(Counted::copies, copies);
+    BOOST_CHECK_EQUAL(Counted::moves, moves);
+}
+
+/**
+ * It checks the counts when results are built in place through the conversion operator of TDeferredCall
+ * GCC builds a converted result right in the optional's storage, the standard (CWG2327) lets other compilers (MSVC)
+ * materialize it and move it into the storage, so they may add up to one move per such result.
+ */
+void checkInPlaceCounts(std::size_t copies, std::size_t moves, std::size_t inPlaceResults)
+{
+    BOOST_CHECK_EQUAL(Counted::copies, copies);
+#if defined(__GNUC__) && !defined(__clang__)
+    (void)inPlaceResults;
+    BOOST_CHECK_EQUAL(Counted::moves, moves);
+#else
+    BOOST_CHECK_GE(Counted::moves, moves);
+    BOOST_CHECK_LE(Counted::moves, moves + inPlaceResults);
+#endif
+}
+
+/**
+ * It's a value type with an unconstrained forwarding constructor, it remembers whether it was built from an int
+ */
+struct Forwarding
+{
+    template <typename T>
+    Forwarding(T&&)
+        : fromInt(std::is_same<std::decay_t<T>, int>::value)
+    {
+    }
+
+    bool fromInt;
+};
+
+} // end namespace
+
+BOOST_AUTO_TEST_CASE(case_map_in_place)
+{
+    const auto op = boost::make_optional(Counted(1));
+    const auto stdOp = std::make_optional(Counted(1));
+    Counted::reset();
+
+    const auto res = op | [](const Counted& el) { return Counted(el.value + 1); };
+    const auto stdRes = stdOp | [](const Counted& el) { return Counted(el.value + 1); };
+
+    BOOST_CHECK_EQUAL(res.get().value, 2);
+    BOOST_CHECK_EQUAL(stdRes->value, 2);
+    checkInPlaceCounts(0, 0, 2);
+}
+
+BOOST_AUTO_TEST_CASE(case_map_rvalue)
+{
+    auto op = boost::make_optional(Counted(1));
+    Counted::reset();
+
+    const auto res = std::move(op) | [](Counted&& el) { return std::move(el); };
+
+    BOOST_CHECK_EQUAL(res.get().value, 1);
+    checkInPlaceCounts(0, 1, 1);
+}
+
+BOOST_AUTO_TEST_CASE(case_hof_rvalue)
+{
+    Counted::reset();
+
+    const auto filtered = boost::make_optional(Counted(1)) | hof::filter_if([](const Counted& el) { return el.value > 0; });
+    // one move into the optional by boost::make_optional, one move into the result
+    checkCounts(0, 2);
+
+    Counted::reset();
+    const auto matched = boost::make_optional(Counted(1)) | hof::match([](const Counted&) {}, []() {}) | hof::match_some([](const Counted&) {})
+                         | hof::match_none([]() {});
+    checkCounts(0, 2);
+
+    BOOST_CHECK(filtered.has_value());
+    BOOST_CHECK(matched.has_value());
+}
+
+BOOST_AUTO_TEST_CASE(case_hof_lvalue)
+{
+    const auto op = boost::make_optional(Counted(1));
+    Counted::reset();
+
+    auto&& matched = op | hof::match([](const Counted&) {}, []() {});
+    const auto filtered = toRefOp(op) | hof::filter_if([](const Counted& el) { return el.value > 0; });
+
+    BOOST_CHECK_EQUAL(&matched.get(), &op.get());
+    BOOST_CHECK_EQUAL(filtered.get_ptr(), op.get_ptr());
+    checkCounts(0, 0);
+}
+
+BOOST_AUTO_TEST_CASE(case_extractors)
+{
+    auto op = boost::make_optional(Counted(1));
+    boost::optional<Counted> none;
+
+    Counted::reset();
+    const auto orElse = std::move(op) |= []() { return Counted(2); };
+    checkCounts(0, 1);
+
+    Counted::reset();
+    const auto orElseNone = none |= []() { return Counted(2); };
+    checkInPlaceCounts(0, 0, 1);
+
+    Counted::reset();
+    const auto value = std::move(none) <<= Counted(3);
+    checkCounts(0, 1);
+
+    Counted::reset();
+    const auto valueFn = boost::make_optional(Counted(4)) <<= []() { return Counted(0); };
+    checkCounts(0, 2);
+
+    BOOST_CHECK_EQUAL(orElse.get().value, 1);
+    BOOST_CHECK_EQUAL(orElseNone.get().value, 2);
+    BOOST_CHECK_EQUAL(value.value, 3);
+    BOOST_CHECK_EQUAL(valueFn.value, 4);
+}
+
+BOOST_AUTO_TEST_CASE(case_extractor_value_from_lvalue)
+{
+    const Counted fallback(5);
+    Counted::reset();
+
+    const auto value = boost::optional<Counted>() <<= fallback;
+
+    BOOST_CHECK_EQUAL(value.value, 5);
+    checkCounts(1, 0);
+}
+
+BOOST_AUTO_TEST_CASE(case_pipeline)
+{
+    auto p = hof::pipeline(hof::filter_if([](const Counted& el) { return el.value > 0; }),
+                           hof::match_some([](const Counted&) {}),
+                           [](const Counted& el) { return Counted(el.value * 2); });
+    const auto op = boost::make_optional(Counted(1));
+    Counted::reset();
+
+    const auto res = p(op);
+
+    BOOST_CHECK_EQUAL(res.get().value, 2);
+    checkInPlaceCounts(0, 0, 1);
+}
+
+BOOST_AUTO_TEST_CASE(case_move_only)
+{
+    auto res = boost::make_optional(std::make_unique<int>(1))
+        | hof::filter_if([](const std::unique_ptr<int>& el) { return *el > 0; })
+        | hof::match_some([](const std::unique_ptr<int>&) {})
+        | [](std::unique_ptr<int>&& el) { *el += 1; return std::move(el); }
+        |= []() { return std::make_unique<int>(0); };
+
+    auto value = std::move(res) <<= []() { return std::make_unique<int>(0); };
+    auto stdValue = std::make_optional(std::make_unique<int>(7)) | [](std::unique_ptr<int>&& el) { return std::move(el); } <<= std::unique_ptr<int>();
+
+    BOOST_REQUIRE(value);
+    BOOST_CHECK_EQUAL(*value, 2);
+    BOOST_REQUIRE(stdValue);
+    BOOST_CHECK_EQUAL(*stdValue, 7);
+}
+
+BOOST_AUTO_TEST_CASE(case_forwarding_constructor)
+{
+    const auto any = boost::make_optional(5) | [](int el) { return std::any(el); };
+    BOOST_REQUIRE(any);
+    BOOST_REQUIRE(any->type() == typeid(int));
+    BOOST_CHECK_EQUAL(std::any_cast<int>(*any), 5);
+
+    const auto stdAny = std::make_optional(5) | [](int el) { return std::any(el + 1); } <<= std::any();
+    BOOST_CHECK_EQUAL(std::any_cast<int>(stdAny), 6);
+
+    const auto boostAny = boost::make_optional(5) | [](int el) { return boost::any(el); };
+    BOOST_REQUIRE(boostAny);
+    BOOST_CHECK_EQUAL(boost::any_cast<int>(*boostAny), 5);
+
+    const auto forwarding = boost::make_optional(5) | [](int el) { return Forwarding(el); };
+    BOOST_REQUIRE(forwarding);
+    BOOST_CHECK(forwarding->fromInt);
+
+    const auto fallback = boost::optional<int>() |= []() { return Forwarding(0); };
+    BOOST_REQUIRE(fallback);
+    BOOST_CHECK(fallback->fromInt);
+}
+
+BOOST_AUTO_TEST_CASE(case_large_buffer)
+{
+    auto op = boost::make_optional(std::vector<char>(64 * 1024, 'x'));
+    const auto data = op.get().data();
+
+    const auto res = std::move(op) | hof::filter_if([](const std::vector<char>& el) { return !el.empty(); })
+        | [](std::vector<char>&& el) { return std::move(el); };
+
+    // the buffer is moved along the chain, never copied
+    BOOST_REQUIRE(res.has_value());
+    BOOST_CHECK_EQUAL(res.get().data(), data);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,174 @@
+#include <boost/test/unit_test.hpp>
+
+#include <boost/optional.hpp>
+#include <boost/optional_ext.hpp>
+#include <boost/optional_ext/coroutine.hpp>
+
+#if OPTIONAL_EXT_HAS_COROUTINES
+
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+BOOST_AUTO_TEST_SUITE( coroutine )
+
+namespace {
+
+boost::optional<int> toInt(const std::string& str)
+{
+    try
+    {
+        return std::stoi(str);
+    }
+    catch (...)
+    {
+        return boost::none;
+    }
+}
+
+struct Guard
+{
+    int& counter;
+    ~Guard()
+    {
+        ++counter;
+    }
+};
+
+optional_ext::optional_coroutine<int> sum(const std::string& a, const std::string& b, int& reached, int& destroyed)
+{
+    Guard guard{destroyed};
+
+    const auto x = co_await toInt(a);
+    const auto y = co_await (toInt(b) | hof::filter_if([](int el) { return el > 0; }));
+    ++reached;
+
+    // both intermediate values are available without nested lambdas
+    co_return x + y + x * y;
+}
+
+optional_ext::optional_coroutine<std::string> describe(const std::string& a, const std::string& b)
+{
+    int reached = 0;
+    int destroyed = 0;
+    const auto value = co_await sum(a, b, reached, destroyed);
+    co_return std::to_string(value);
+}
+
+} // end namespace
+
+BOOST_AUTO_TEST_CASE(case_short_circuit)
+{
+    int reached = 0;
+    int destroyed = 0;
+
+    const boost::optional<int> res = sum("2", "3", reached, destroyed);
+    const boost::optional<int> noneFirst = sum("x", "3", reached, destroyed);
+    const boost::optional<int> noneSecond = sum("2", "-3", reached, destroyed);
+
+    BOOST_CHECK_EQUAL(res.get(), 11);
+    BOOST_CHECK(!noneFirst.has_value());
+    BOOST_CHECK(!noneSecond.has_value());
+    BOOST_CHECK_EQUAL(reached, 1);
+    // the frames of the stopped coroutines are destroyed with their locals
+    BOOST_CHECK_EQUAL(destroyed, 3);
+}
+
+BOOST_AUTO_TEST_CASE(case_lazy)
+{
+    int reached = 0;
+    int destroyed = 0;
+
+    {
+        auto coroutine = sum("2", "3", reached, destroyed);
+    }
+
+    // a coroutine which is never asked for its result isn't run
+    BOOST_CHECK_EQUAL(reached, 0);
+}
+
+BOOST_AUTO_TEST_CASE(case_lvalue_is_not_copied)
+{
+    const auto op = boost::make_optional(std::string("value"));
+    const std::string* address = nullptr;
+
+    auto coroutine = [&]() -> optional_ext::optional_coroutine<std::size_t> {
+        const auto& value = co_await op;
+        address = &value;
+        co_return value.size();
+    };
+
+    BOOST_CHECK_EQUAL(coroutine().get().get(), 5u);
+    BOOST_CHECK_EQUAL(address, op.get_ptr());
+}
+
+BOOST_AUTO_TEST_CASE(case_other_optionals)
+{
+    int value = 4;
+    int* null = nullptr;
+
+    auto coroutine = [&](int* ptr) -> optional_ext::optional_coroutine<int> {
+        const auto a = co_await std::make_optional(1);
+        const auto b = co_await ptr;
+        auto c = co_await std::make_optional(std::make_unique<int>(2));
+        co_return a + b + *c;
+    };
+
+    BOOST_CHECK_EQUAL(coroutine(&value).get().get(), 7);
+    BOOST_CHECK(!coroutine(null).get().has_value());
+}
+
+BOOST_AUTO_TEST_CASE(case_nested)
+{
+    BOOST_CHECK_EQUAL(describe("1", "2").get().get(), "5");
+    BOOST_CHECK(!describe("1", "x").get().has_value());
+}
+
+BOOST_AUTO_TEST_CASE(case_co_return_none_and_exception)
+{
+    auto none = []() -> optional_ext::optional_coroutine<int> { co_return boost::none; };
+    auto error = []() -> optional_ext::optional_coroutine<int> {
+        co_await boost::make_optional(1);
+        throw std::runtime_error("error");
+    };
+
+    BOOST_CHECK(!none().get().has_value());
+    BOOST_CHECK_THROW(error().get(), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(case_moved_from_and_run_twice)
+{
+    int reached = 0;
+    int destroyed = 0;
+    const std::string a = "2";
+    const std::string b = "3";
+
+    // the coroutine runs later, so the arguments it references have to outlive it
+    auto coroutine = sum(a, b, reached, destroyed);
+    auto moved = std::move(coroutine);
+
+    // a coroutine runs once, a moved-from or already run one has no frame and gives boost::none
+    BOOST_CHECK(!std::move(coroutine).get().has_value());
+    BOOST_CHECK_EQUAL(std::move(moved).get().get(), 11);
+    BOOST_CHECK(!std::move(moved).get().has_value());
+    BOOST_CHECK_EQUAL(reached, 1);
+    BOOST_CHECK_EQUAL(destroyed, 1);
+}
+
+BOOST_AUTO_TEST_CASE(case_frame_cache)
+{
+    auto& cache = optional_detail::TCoroutineFrameCache::local();
+
+    void* first = cache.allocate(200);
+    cache.deallocate(first, 200);
+    void* second = cache.allocate(240);
+    cache.deallocate(second, 240);
+
+    // the sizes are in the same class, so the block is reused
+    BOOST_CHECK_EQUAL(first, second);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif // OPTIONAL_EXT_HAS_COROUTINES
@@ -0,0 +1,139 @@
+#include <boost/test/unit_test.hpp>
+
+#include <boost/optional.hpp>
+#include <boost/optional_ext.hpp>
+#include <boost/optional_ext/expected.hpp>
+#include <boost/optional_ext/parse.hpp>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE( expected )
+
+namespace {
+
+enum class reason : std::uint8_t
+{
+    no_value = 0,
+    negative,
+    too_big
+};
+
+using TExpected = optional_ext::expected<double, reason>;
+
+TExpected checkSign(double value)
+{
+    return value >= 0.0 ? TExpected(value) : optional_ext::make_unexpected(reason::negative);
+}
+
+struct Customer
+{
+    std::string name;
+};
+
+} // end namespace
+
+BOOST_AUTO_TEST_CASE(case_propagation)
+{
+    static_assert(sizeof(optional_ext::expected<std::int32_t, reason>) <= 2 * sizeof(std::int32_t), "the error is kept in place");
+
+    auto calls = 0;
+    auto twice = [&calls](double el) { ++calls; return el * 2.0; };
+
+    const auto some = TExpected(2.0) | checkSign | twice;
+    static_assert(std::is_same<std::decay_t<decltype(some)>, TExpected>::value, "the kind of the optional is kept");
+    BOOST_CHECK(some == TExpected(4.0));
+
+    const auto error = TExpected(-2.0) | checkSign | twice | [](double el) -> TExpected { return el + 1.0; };
+    BOOST_CHECK(!error);
+    BOOST_CHECK(error.error() == reason::negative);
+    BOOST_CHECK_EQUAL(calls, 1);
+
+    const auto filtered = TExpected(7.0) | hof::filter_if([](double el) { return el < 5.0; });
+    BOOST_CHECK(filtered.error() == reason::no_value);
+
+    const auto passed = TExpected(optional_ext::make_unexpected(reason::too_big)) | hof::filter_if_not([](double) { return true; });
+    BOOST_CHECK(passed.error() == reason::too_big);
+
+    // an empty boost::optional gives the "no value" error
+    const auto none = boost::optional<double>() | checkSign;
+    BOOST_CHECK(none.error() == reason::no_value);
+}
+
+BOOST_AUTO_TEST_CASE(case_handlers_take_the_error)
+{
+    std::vector<reason> errors;
+    auto onError = [&errors](reason error) { errors.push_back(error); };
+
+    const auto value = TExpected(-1.0) | checkSign | hof::match([](double) {}, onError) |= [](reason error) {
+        return error == reason::negative ? 0.0 : -1.0;
+    };
+    BOOST_CHECK(value == TExpected(0.0));
+
+    (void)(TExpected(optional_ext::make_unexpected(reason::too_big)) | hof::match_none(onError));
+    (void)(TExpected(1.0) | hof::match_none(onError));
+    BOOST_CHECK(errors == std::vector<reason>({reason::negative, reason::too_big}));
+
+    // a handler without an argument still works
+    auto count = 0;
+    BOOST_CHECK_EQUAL(TExpected(-1.0) | checkSign | hof::match_none([&count]() { ++count; }) <<= []() { return 3.0; }, 3.0);
+    BOOST_CHECK_EQUAL(count, 1);
+
+    BOOST_CHECK_EQUAL(TExpected(-1.0) | checkSign <<= [](reason error) { return static_cast<double>(error); }, 1.0);
+    BOOST_CHECK_EQUAL(TExpected(5.0) | checkSign <<= 0.0, 5.0);
+}
+
+BOOST_AUTO_TEST_CASE(case_try_parse)
+{
+    using optional_ext::parse_error;
+
+    auto errorOf = [](std::string_view text) {
+        return hof::try_parse<std::int8_t>()(text) <<= [](parse_error error) { return static_cast<int>(error); };
+    };
+    BOOST_CHECK_EQUAL(errorOf("12"), 12);
+    BOOST_CHECK_EQUAL(errorOf("x"), static_cast<int>(parse_error::invalid));
+    BOOST_CHECK_EQUAL(errorOf("300"), static_cast<int>(parse_error::out_of_range));
+    BOOST_CHECK_EQUAL(errorOf("1 "), static_cast<int>(parse_error::trailing_characters));
+
+    std::vector<parse_error> errors;
+    auto pipeline = hof::pipeline(hof::try_parse<double>(),
+                                  hof::filter_if([](double el) { return el <= 50.0; }),
+                                  hof::match_none([&errors](parse_error error) { errors.push_back(error); }),
+                                  [](double el) { return el / 2.0; })
+        <<= [](parse_error error) { return error == parse_error::no_value ? -1.0 : -2.0; };
+
+    // a plain input is fused, an error-carrying one goes stage by stage
+    BOOST_CHECK_EQUAL(pipeline(std::string("10")), 5.0);
+    BOOST_CHECK_EQUAL(pipeline(boost::make_optional(std::string("70"))), -1.0);
+    BOOST_CHECK_EQUAL(pipeline(std::string("1e999")), -2.0);
+    BOOST_CHECK_EQUAL(pipeline(boost::optional<std::string>()), -1.0);
+    BOOST_CHECK(errors == std::vector<parse_error>({parse_error::no_value, parse_error::out_of_range, parse_error::no_value}));
+
+    auto chain = hof::pipeline(hof::filter_if([](double el) { return el >= 0.0; }), [](double el) { return el + 1.0; });
+    const auto carried = hof::try_parse<double>()("a") | chain;
+    static_assert(std::is_same<std::decay_t<decltype(carried)>, optional_ext::expected<double, parse_error>>::value, "the error is kept");
+    BOOST_CHECK(carried.error() == parse_error::invalid);
+    BOOST_CHECK((hof::try_parse<double>()("-1") | chain).error() == parse_error::no_value);
+    BOOST_CHECK_EQUAL((hof::try_parse<double>()("1") | chain).value(), 2.0);
+}
+
+BOOST_AUTO_TEST_CASE(case_references)
+{
+    const optional_ext::expected<const Customer&, reason> none = optional_ext::make_unexpected(reason::too_big);
+    Customer customer{"name"};
+    const optional_ext::expected<Customer&, reason> ref(customer);
+
+    auto name = ref | hof::project(&Customer::name);
+    static_assert(std::is_same<decltype(name), optional_ext::expected<std::string&, reason>>::value, "a projection refers to the value");
+    BOOST_CHECK_EQUAL(&*name, &customer.name);
+    BOOST_CHECK((none | hof::project(&Customer::name)).error() == reason::too_big);
+
+    optional_ext::expected<Customer, reason> owned(customer);
+    auto refOp = toRefOp(owned);
+    BOOST_CHECK_EQUAL(&*refOp, &*owned);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
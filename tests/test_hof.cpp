@@ -8,11 +8,34 @@
 #include <limits>
 #include <functional>
 #include <map>
+#include <optional>
+#include <string>
 #include <tuple>
+#include <type_traits>
+#include <vector>
 #include <iostream>
 
 BOOST_AUTO_TEST_SUITE( higher_order_functions )
 
+namespace {
+
+struct Customer
+{
+    std::string name;
+    std::vector<std::string> tags;
+
+    const std::string& getName() const noexcept { return name; }
+    std::size_t tagCount() const noexcept { return tags.size(); }
+};
+
+struct Order
+{
+    int id;
+    Customer customer;
+};
+
+} // end namespace
+
 BOOST_AUTO_TEST_CASE(case_toRefOp)
 {
     const auto op = boost::make_optional(1);
@@ -24,6 +47,15 @@ BOOST_AUTO_TEST_CASE(case_toRefOp)
     BOOST_CHECK_EQUAL(resRef.get_ptr(), op.get_ptr());
 }
 
+BOOST_AUTO_TEST_CASE(case_toRefOp_none)
+{
+    const boost::optional<int> op;
+    boost::optional<int> mutableOp;
+
+    BOOST_CHECK(!toRefOp(op).has_value());
+    BOOST_CHECK(!toRefOp(mutableOp).has_value());
+}
+
 BOOST_AUTO_TEST_CASE(case_filter_if_Accepted)
 {
     const auto op = boost::make_optional(std::string("!"));
@@ -140,4 +172,83 @@ BOOST_AUTO_TEST_CASE(case_match_some_2)
     BOOST_CHECK_EQUAL(isSome, true);
 }
 
+BOOST_AUTO_TEST_CASE(case_project_keeps_references)
+{
+    const auto order = boost::make_optional(Order{1, Customer{"a customer whose name doesn't fit SSO", {"vip"}}});
+
+    auto name = toRefOp(order) | hof::project(&Order::customer) | hof::project(&Customer::name);
+    static_assert(std::is_same<decltype(name), boost::optional<const std::string&>>::value, "the name is referenced, not copied");
+    BOOST_CHECK_EQUAL(&name.get(), &order->customer.name);
+
+    auto nested = order | hof::project(&Order::customer, &Customer::getName);
+    static_assert(std::is_same<decltype(nested), boost::optional<const std::string&>>::value, "a getter returning a reference is kept");
+    BOOST_CHECK_EQUAL(&nested.get(), &order->customer.name);
+
+    // a getter returning a value gives a value
+    auto count = toRefOp(order) | hof::project(&Order::customer, &Customer::tagCount);
+    static_assert(std::is_same<decltype(count), boost::optional<std::size_t>>::value, "a getter returning a value gives a value");
+    BOOST_CHECK_EQUAL(count.get(), 1u);
+
+    auto empty = boost::optional<const Order&>() | hof::project(&Order::customer, &Customer::name);
+    BOOST_CHECK(!empty.has_value());
+}
+
+BOOST_AUTO_TEST_CASE(case_project_mutable)
+{
+    auto order = boost::make_optional(Order{1, Customer{"name", {}}});
+
+    auto tags = toRefOp(order) | hof::project(&Order::customer, &Customer::tags);
+    static_assert(std::is_same<decltype(tags), boost::optional<std::vector<std::string>&>>::value, "a mutable reference is kept");
+    tags->push_back("new");
+    BOOST_CHECK_EQUAL(order->customer.tags.size(), 1u);
+
+    std::optional<Order> stdOrder = Order{2, Customer{"std", {}}};
+    auto stdName = stdOrder | hof::project(&Order::customer, [](auto& el) -> auto& { return el.name; });
+    static_assert(std::is_same<decltype(stdName), boost::optional<std::string&>>::value, "std::optional can't keep a reference");
+    BOOST_CHECK_EQUAL(&stdName.get(), &stdOrder->customer.name);
+
+    Order* pointer = &*order;
+    auto id = pointer | hof::project(&Order::id);
+    static_assert(std::is_same<decltype(id), int*>::value, "a pointer gives a pointer");
+    BOOST_CHECK_EQUAL(id, &order->id);
+}
+
+BOOST_AUTO_TEST_CASE(case_project_temporary)
+{
+    // the value of a temporary is moved out, a reference would dangle
+    auto name = boost::make_optional(Order{1, Customer{"a customer whose name doesn't fit SSO", {}}})
+        | hof::project(&Order::customer, &Customer::name);
+    static_assert(std::is_same<decltype(name), boost::optional<std::string>>::value, "a temporary gives a value");
+    BOOST_CHECK_EQUAL(name.get(), "a customer whose name doesn't fit SSO");
+
+    // a getter returning a reference into the temporary gives a value too
+    auto makeOrder = []() { return boost::make_optional(Order{1, Customer{"a customer whose name doesn't fit SSO", {}}}); };
+    auto nested = makeOrder() | hof::project(&Order::customer, &Customer::getName);
+    static_assert(std::is_same<decltype(nested), boost::optional<std::string>>::value, "a getter on a temporary gives a value");
+    BOOST_CHECK_EQUAL(nested.get(), "a customer whose name doesn't fit SSO");
+
+    auto getter = boost::make_optional(Customer{"a customer whose name doesn't fit SSO", {}}) | hof::project(&Customer::getName);
+    static_assert(std::is_same<decltype(getter), boost::optional<std::string>>::value, "a getter on a temporary gives a value");
+    BOOST_CHECK_EQUAL(getter.get(), "a customer whose name doesn't fit SSO");
+}
+
+BOOST_AUTO_TEST_CASE(case_project_tuple_and_pipeline)
+{
+    const auto op = boost::make_optional(std::make_tuple(10, std::string("ten")));
+
+    auto second = toRefOp(op) | hof::project<1>();
+    static_assert(std::is_same<decltype(second), boost::optional<const std::string&>>::value, "a tuple element is referenced");
+    BOOST_CHECK_EQUAL(&second.get(), &std::get<1>(*op));
+
+    const Order order{1, Customer{"name", {"a", "b"}}};
+    auto pipeline = hof::pipeline(hof::project(&Order::customer),
+                                  hof::filter_if([](const Customer& el) { return !el.tags.empty(); }),
+                                  hof::project(&Customer::name));
+
+    auto name = pipeline(order);
+    static_assert(std::is_same<decltype(name), boost::optional<const std::string&>>::value, "the pipeline keeps the reference");
+    BOOST_CHECK_EQUAL(&name.get(), &order.customer.name);
+    BOOST_CHECK(!pipeline(Order{2, Customer{"no tags", {}}}).has_value());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
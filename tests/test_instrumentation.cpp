@@ -0,0 +1,173 @@
+#include <boost/test/unit_test.hpp>
+
+#include <boost/optional.hpp>
+#include <boost/optional_ext.hpp>
+
+// it's built only by the boost_optional_ext_instrumented target which defines OPTIONAL_EXT_INSTRUMENTATION=1
+#if OPTIONAL_EXT_INSTRUMENTATION
+
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE( instrumentation )
+
+namespace {
+
+struct Half
+{
+    boost::optional<int> operator()(int el) const
+    {
+        return el % 2 == 0 ? boost::make_optional(el / 2) : boost::none;
+    }
+};
+
+struct Twice
+{
+    int operator()(int el) const
+    {
+        return el * 2;
+    }
+};
+
+struct IsPositive
+{
+    bool operator()(int el) const
+    {
+        return el > 0;
+    }
+};
+
+const optional_ext::stage_stats* find(const std::vector<optional_ext::stage_stats>& stats, optional_ext::stage_kind kind, const std::string& name)
+{
+    for (const auto& el : stats)
+    {
+        if (el.kind == kind && el.name.find(name) != std::string::npos && el.calls > 0)
+        {
+            return &el;
+        }
+    }
+
+    return nullptr;
+}
+
+} // end namespace
+
+BOOST_AUTO_TEST_CASE(case_operators)
+{
+    optional_ext::reset_stage_stats();
+
+    for (int i = 0; i < 10; ++i)
+    {
+        const auto res = boost::make_optional(i) | Half() | Twice() | hof::filter_if(IsPositive()) <<= -1;
+        BOOST_CHECK_EQUAL(res, i % 2 == 0 && i > 0 ? i : -1);
+    }
+
+    const auto stats = optional_ext::collect_stage_stats();
+    const auto* half = find(stats, optional_ext::stage_kind::flat_map, "Half");
+    const auto* twice = find(stats, optional_ext::stage_kind::map, "Twice");
+    const auto* positive = find(stats, optional_ext::stage_kind::filter_if, "IsPositive");
+    const auto* valueOr = find(stats, optional_ext::stage_kind::value_or, "int");
+
+    BOOST_REQUIRE(half && twice && positive && valueOr);
+    BOOST_CHECK_EQUAL(half->calls, 10u);
+    BOOST_CHECK_EQUAL(half->some, 5u);
+    BOOST_CHECK_EQUAL(half->none, 5u);
+    BOOST_CHECK_EQUAL(twice->calls, 10u);
+    BOOST_CHECK_EQUAL(twice->some, 5u);
+    BOOST_CHECK_EQUAL(positive->some, 4u);
+    BOOST_CHECK_EQUAL(valueOr->some, 4u);
+    BOOST_CHECK_EQUAL(valueOr->none, 6u);
+
+    std::uint64_t histogram = 0;
+    for (auto el : half->latency)
+    {
+        histogram += el;
+    }
+    BOOST_CHECK_EQUAL(histogram, half->calls);
+    BOOST_CHECK_GE(half->latency_quantile(0.99), half->latency_quantile(0.5));
+}
+
+BOOST_AUTO_TEST_CASE(case_throwing_map)
+{
+    optional_ext::reset_stage_stats();
+
+    auto failing = [](int el) -> int { throw std::invalid_argument(std::to_string(el)); };
+    using TStage = decltype(failing);
+    BOOST_CHECK_THROW(boost::make_optional(1) | failing, std::invalid_argument);
+
+    const auto stats = optional_ext::collect_stage_stats();
+    const auto* map = find(stats, optional_ext::stage_kind::map, boost::core::demangled_name(BOOST_CORE_TYPEID(TStage)));
+
+    // the call is counted, but it has no outcome
+    BOOST_REQUIRE(map);
+    BOOST_CHECK_EQUAL(map->calls, 1u);
+    BOOST_CHECK_EQUAL(map->some, 0u);
+    BOOST_CHECK_EQUAL(map->none, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(case_threads_and_reset)
+{
+    auto stage = [](int el) { return el + 1; };
+    using TStage = decltype(stage);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&stage]() {
+            for (int i = 0; i < 100; ++i)
+            {
+                const auto res = std::make_optional(i) | stage;
+                (void)res;
+            }
+        });
+    }
+    for (auto& el : threads)
+    {
+        el.join();
+    }
+
+    auto count = [](const std::vector<optional_ext::stage_stats>& stats) {
+        const auto name = boost::core::demangled_name(BOOST_CORE_TYPEID(TStage));
+        for (const auto& el : stats)
+        {
+            if (el.kind == optional_ext::stage_kind::map && el.name == name)
+            {
+                return el.calls;
+            }
+        }
+        return std::uint64_t(0);
+    };
+
+    // the counters of the finished threads are kept
+    BOOST_CHECK_EQUAL(count(optional_ext::collect_stage_stats()), 400u);
+    optional_ext::reset_stage_stats();
+    BOOST_CHECK_EQUAL(count(optional_ext::collect_stage_stats()), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(case_pipeline_and_dump)
+{
+    optional_ext::reset_stage_stats();
+
+    auto p = hof::pipeline(Half(), hof::match_some([](int) {})) <<= 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        p(i);
+    }
+    const auto res = boost::make_optional(3) | hof::match([](int) {}, []() {}) | hof::match_none([]() {}) |= []() { return 0; };
+    BOOST_CHECK(res.has_value());
+
+    std::ostringstream out;
+    optional_ext::dump_stage_stats(out);
+
+    BOOST_CHECK_NE(out.str().find("pipeline"), std::string::npos);
+    BOOST_CHECK_NE(out.str().find("match_none"), std::string::npos);
+    BOOST_CHECK_NE(out.str().find("or_else"), std::string::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif // OPTIONAL_EXT_INSTRUMENTATION
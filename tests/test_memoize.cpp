@@ -0,0 +1,173 @@
+#include <boost/test/unit_test.hpp>
+
+#include <boost/optional.hpp>
+#include <boost/optional_ext.hpp>
+#include <boost/optional_ext/expected.hpp>
+#include <boost/optional_ext/memoize.hpp>
+#include <boost/optional_ext/parse.hpp>
+
+#include <atomic>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE( memoize )
+
+namespace {
+
+int calls = 0;
+
+boost::optional<int> half(int el)
+{
+    ++calls;
+    return el % 2 == 0 ? boost::make_optional(el / 2) : boost::none;
+}
+
+} // end namespace
+
+BOOST_AUTO_TEST_CASE(case_flat_map_with_none)
+{
+    calls = 0;
+    auto cached = hof::memoize(half, 16);
+
+    for (int i = 0; i < 3; ++i)
+    {
+        BOOST_CHECK_EQUAL((boost::make_optional(4) | cached).get(), 2);
+        BOOST_CHECK(!(boost::make_optional(3) | cached).has_value());
+        BOOST_CHECK(!(boost::optional<int>() | cached).has_value());
+    }
+
+    // the empty results are cached, the empty inputs never reach the function
+    BOOST_CHECK_EQUAL(calls, 2);
+    BOOST_CHECK_EQUAL(cached.stats().hits, 4u);
+    BOOST_CHECK_EQUAL(cached.stats().misses, 2u);
+    BOOST_CHECK_EQUAL(cached.stats().size, 2u);
+    BOOST_CHECK_CLOSE(cached.stats().hit_ratio(), 4.0 / 6.0, 1e-9);
+}
+
+BOOST_AUTO_TEST_CASE(case_error_carrying)
+{
+    auto cached = hof::memoize(hof::try_parse<int>(), 16);
+
+    for (int i = 0; i < 2; ++i)
+    {
+        const auto value = boost::make_optional(std::string_view("42")) | cached;
+        const auto invalid = boost::make_optional(std::string_view("x")) | cached;
+        static_assert(std::is_same<std::decay_t<decltype(value)>, optional_ext::expected<int, optional_ext::parse_error>>::value, "the error is kept");
+
+        BOOST_CHECK_EQUAL(*value, 42);
+        BOOST_REQUIRE(!invalid.has_value());
+        BOOST_CHECK(invalid.error() == optional_ext::parse_error::invalid);
+    }
+
+    // the error of the input is passed on, it never reaches the cache
+    const optional_ext::expected<std::string_view, optional_ext::parse_error> error = optional_ext::make_unexpected(optional_ext::parse_error::out_of_range);
+    const auto passed = error | cached;
+    BOOST_REQUIRE(!passed.has_value());
+    BOOST_CHECK(passed.error() == optional_ext::parse_error::out_of_range);
+
+    BOOST_CHECK_EQUAL(cached.stats().hits, 2u);
+    BOOST_CHECK_EQUAL(cached.stats().misses, 2u);
+}
+
+BOOST_AUTO_TEST_CASE(case_map_and_string_keys)
+{
+    int lengths = 0;
+    auto length = hof::memoize([&lengths](const std::string& el) {
+        ++lengths;
+        return el.size();
+    }, 4);
+
+    static_assert(std::is_same<decltype(std::make_optional(std::string()) | length), boost::optional<std::size_t>>::value,
+                  "the result of a memoized map function is boost::optional");
+
+    const std::string text = "an error";
+    const std::string_view view = text;
+    BOOST_CHECK_EQUAL((std::make_optional(text) | length).get(), 8u);
+    BOOST_CHECK_EQUAL((toOp(view) | length).get(), 8u);
+    BOOST_CHECK_EQUAL((boost::make_optional("an error") | length).get(), 8u);
+    BOOST_CHECK_EQUAL(lengths, 1);
+
+    auto parse = hof::memoize(hof::parse<double>(), 4);
+    BOOST_CHECK_EQUAL(toOp(view) | parse <<= -1.0, -1.0);
+    BOOST_CHECK_EQUAL(boost::make_optional(std::string("1.5")) | parse <<= -1.0, 1.5);
+    BOOST_CHECK_EQUAL(parse.stats().misses, 2u);
+}
+
+BOOST_AUTO_TEST_CASE(case_clock_eviction)
+{
+    calls = 0;
+    auto cached = hof::memoize(half, 2);
+
+    (void)(boost::make_optional(2) | cached);
+    (void)(boost::make_optional(4) | cached);
+    // 2 is referenced, so 4 is replaced by 6
+    (void)(boost::make_optional(2) | cached);
+    (void)(boost::make_optional(6) | cached);
+    BOOST_CHECK_EQUAL(calls, 3);
+
+    (void)(boost::make_optional(2) | cached);
+    BOOST_CHECK_EQUAL(calls, 3);
+    (void)(boost::make_optional(4) | cached);
+    BOOST_CHECK_EQUAL(calls, 4);
+
+    BOOST_CHECK_EQUAL(cached.stats().size, 2u);
+    BOOST_CHECK_EQUAL(cached.stats().evictions, 2u);
+}
+
+BOOST_AUTO_TEST_CASE(case_pipeline_shares_the_cache)
+{
+    calls = 0;
+    auto cached = hof::memoize(half, 16);
+    auto pipeline = hof::pipeline(cached, hof::filter_if([](int el) { return el > 1; })) <<= 0;
+
+    BOOST_CHECK_EQUAL(pipeline(4), 2);
+    BOOST_CHECK_EQUAL(pipeline(4), 2);
+    BOOST_CHECK_EQUAL(pipeline(2), 0);
+    BOOST_CHECK_EQUAL(pipeline(boost::optional<int>()), 0);
+    BOOST_CHECK_EQUAL(calls, 2);
+    BOOST_CHECK_EQUAL(cached.stats().hits, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(case_concurrent)
+{
+    std::atomic<int> computed{0};
+    auto square = hof::concurrent_memoize<int>([&computed](auto el) {
+        computed.fetch_add(1, std::memory_order_relaxed);
+        return el * el;
+    }, 64, 4);
+
+    std::atomic<int> wrong{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([square, &wrong]() mutable {
+            for (int i = 0; i < 1000; ++i)
+            {
+                const auto el = i % 32;
+                if ((boost::make_optional(el) | square) != el * el)
+                {
+                    wrong.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+    for (auto& el : threads)
+    {
+        el.join();
+    }
+
+    BOOST_CHECK_EQUAL(wrong.load(), 0);
+
+    const auto stats = square.stats();
+    BOOST_CHECK_EQUAL(stats.hits + stats.misses, 4000u);
+    BOOST_CHECK_EQUAL(stats.size, 32u);
+    // two threads may compute the same key at once, only one result is kept
+    BOOST_CHECK_GE(computed.load(), 32);
+    BOOST_CHECK_EQUAL(stats.misses, static_cast<std::uint64_t>(computed.load()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,172 @@
+#include <boost/test/unit_test.hpp>
+
+#include <boost/optional.hpp>
+#include <boost/optional_ext.hpp>
+#include <boost/optional_ext/optional_batch.hpp>
+#include <boost/optional/optional_io.hpp>
+
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE( optional_batch )
+
+namespace {
+
+optional_ext::optional_batch<double> makeBatch(std::size_t size)
+{
+    optional_ext::optional_batch<double> batch;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        if (i % 5 == 0)
+        {
+            batch.push_back(boost::none);
+        }
+        else
+        {
+            batch.push_back(static_cast<double>(i));
+        }
+    }
+
+    return batch;
+}
+
+} // end namespace
+
+BOOST_AUTO_TEST_CASE(case_validity_bitmap)
+{
+    auto batch = makeBatch(130);
+
+    BOOST_CHECK_EQUAL(batch.size(), 130u);
+    BOOST_CHECK_EQUAL(batch.validity().size(), 3u);
+    BOOST_CHECK_EQUAL(batch.count(), 130u - 26u);
+    BOOST_CHECK(!batch.has_value(0));
+    BOOST_CHECK(batch.has_value(129));
+    BOOST_CHECK_EQUAL(boost::optional<double>(batch[129]), boost::make_optional(129.0));
+
+    batch.reset(129);
+    BOOST_CHECK(!batch[129].has_value());
+}
+
+BOOST_AUTO_TEST_CASE(case_filter_if_clears_bits_only)
+{
+    auto batch = makeBatch(200);
+    const auto* data = batch.values().data();
+
+    auto res = std::move(batch) | hof::filter_if([](double el) { return el < 100.0; });
+
+    BOOST_CHECK_EQUAL(res.values().data(), data);
+    for (std::size_t i = 0; i < res.size(); ++i)
+    {
+        const auto expected = boost::make_optional(i % 5 != 0 && i < 100, static_cast<double>(i));
+        BOOST_CHECK_EQUAL(boost::optional<double>(res[i]), expected);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(case_filter_if_not)
+{
+    const auto batch = makeBatch(70);
+
+    const auto res = batch | hof::filter_if_not([](double el) { return el < 10.0; });
+
+    BOOST_CHECK_EQUAL(batch.count(), 56u);
+    BOOST_CHECK_EQUAL(res.count(), 48u);
+    BOOST_CHECK(!res.has_value(9));
+    BOOST_CHECK(res.has_value(11));
+}
+
+BOOST_AUTO_TEST_CASE(case_filter_if_skips_empty_slots)
+{
+    optional_ext::optional_batch<std::string> batch;
+    for (const auto* text : {"apple", "", "avocado", "banana"})
+    {
+        batch.push_back(*text != '\0' ? boost::make_optional(std::string(text)) : boost::none);
+    }
+
+    std::size_t calls = 0;
+    const auto res = batch | hof::filter_if([&calls](const std::string& el) {
+        ++calls;
+        BOOST_REQUIRE(!el.empty());
+        return el.front() == 'a';
+    });
+
+    BOOST_CHECK_EQUAL(calls, 3u);
+    BOOST_CHECK_EQUAL(res.count(), 2u);
+    BOOST_CHECK(res.has_value(0) && res.has_value(2) && !res.has_value(3));
+
+    const auto rest = batch | hof::filter_if_not([](const std::string& el) { return el.front() == 'a'; });
+    BOOST_CHECK_EQUAL(rest.count(), 1u);
+    BOOST_CHECK(rest.has_value(3));
+}
+
+BOOST_AUTO_TEST_CASE(case_map_and_flat_map)
+{
+    const auto batch = makeBatch(100);
+
+    const auto res = batch
+        | [](double el) { return static_cast<int>(el) * 2; }
+        | [](int el) { return boost::make_optional(el % 4 == 0, std::to_string(el)); };
+
+    for (std::size_t i = 0; i < res.size(); ++i)
+    {
+        const auto value = static_cast<int>(i) * 2;
+        const auto expected = boost::make_optional(i % 5 != 0 && value % 4 == 0, std::to_string(value));
+        BOOST_CHECK_EQUAL(boost::optional<std::string>(res[i]), expected);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(case_match)
+{
+    int some = 0;
+    int none = 0;
+
+    const auto res = makeBatch(100) | hof::match([&some](double) { some += 1; }, [&none]() { none += 1; });
+
+    BOOST_CHECK_EQUAL(some, 80);
+    BOOST_CHECK_EQUAL(none, 20);
+    BOOST_CHECK_EQUAL(res.count(), 80u);
+}
+
+BOOST_AUTO_TEST_CASE(case_default_value)
+{
+    const std::vector<double> res = makeBatch(100) | hof::filter_if([](double el) { return el > 50.0; }) <<= -1.0;
+
+    BOOST_REQUIRE_EQUAL(res.size(), 100u);
+    for (std::size_t i = 0; i < res.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(res[i], i % 5 != 0 && i > 50 ? static_cast<double>(i) : -1.0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(case_default_value_empty_and_partial_words)
+{
+    const std::vector<double> rejected = optional_ext::optional_batch<double>({1.0, 2.0, 3.0, 4.0})
+        | hof::filter_if([](double el) { return el > 10.0; }) <<= -1.0;
+    BOOST_CHECK(rejected == std::vector<double>(4, -1.0));
+
+    // the first word is empty, the last one is partial: 64 + 6 slots
+    std::vector<double> values;
+    for (std::size_t i = 0; i < 70; ++i)
+    {
+        values.push_back(static_cast<double>(i));
+    }
+    const optional_ext::optional_batch<double> batch(values);
+
+    const std::vector<double> res = batch | hof::filter_if([](double el) { return el >= 66.0; }) <<= -1.0;
+    BOOST_REQUIRE_EQUAL(res.size(), 70u);
+    for (std::size_t i = 0; i < res.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(res[i], i >= 66 ? static_cast<double>(i) : -1.0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(case_default_function)
+{
+    int calls = 0;
+    const auto res = makeBatch(10) <<= [&calls]() { calls += 1; return 0.0; };
+
+    BOOST_CHECK_EQUAL(calls, 2);
+    BOOST_CHECK_EQUAL(res[0], 0.0);
+    BOOST_CHECK_EQUAL(res[1], 1.0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
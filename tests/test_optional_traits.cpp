@@ -0,0 +1,210 @@
+#include <boost/test/unit_test.hpp>
+
+#include <boost/optional.hpp>
+#include <boost/optional_ext.hpp>
+#include <boost/optional_ext/optional_traits.hpp>
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <type_traits>
+
+namespace my {
+
+/**
+ * It's a user-defined optional which is adapted by a specialization of optional_ext::optional_traits
+ */
+template <typename T>
+struct maybe
+{
+    maybe() = default;
+    maybe(T value)
+        : valid(true)
+        , value(std::move(value))
+    {
+    }
+
+    bool valid = false;
+    T value{};
+};
+
+} // namespace my
+
+namespace optional_ext {
+
+template <typename T>
+struct optional_traits<my::maybe<T>>
+{
+    static constexpr bool is_optional = true;
+    static constexpr bool is_pointer = false;
+
+    using value_type = T;
+
+    template <typename U>
+    using rebind = my::maybe<U>;
+
+    static bool has_value(const my::maybe<T>& op) noexcept
+    {
+        return op.valid;
+    }
+
+    template <typename TOptional>
+    static decltype(auto) value(TOptional&& op) noexcept
+    {
+        return (std::forward<TOptional>(op).value);
+    }
+};
+
+} // namespace optional_ext
+
+BOOST_AUTO_TEST_SUITE( optional_traits )
+
+BOOST_AUTO_TEST_CASE(case_std_optional_map)
+{
+    const std::optional<int> op = 2;
+    const std::optional<int> none;
+
+    const auto res = op | [](int el) { return std::to_string(el); };
+    const auto resNone = none | [](int el) { return std::to_string(el); };
+
+    static_assert(std::is_same<std::decay_t<decltype(res)>, std::optional<std::string>>::value, "std::optional stays std::optional");
+    BOOST_REQUIRE(res.has_value());
+    BOOST_CHECK_EQUAL(*res, "2");
+    BOOST_CHECK(!resNone.has_value());
+}
+
+BOOST_AUTO_TEST_CASE(case_std_optional_flat_map)
+{
+    const auto res = std::make_optional(-1) | [](int el) { return el > 0 ? std::make_optional(el) : std::nullopt; };
+    const auto resBoost = std::make_optional(1) | [](int el) { return boost::make_optional(el * 2); };
+
+    static_assert(std::is_same<std::decay_t<decltype(res)>, std::optional<int>>::value, "flat_map returns the optional of the function");
+    static_assert(std::is_same<std::decay_t<decltype(resBoost)>, boost::optional<int>>::value, "flat_map returns the optional of the function");
+    BOOST_CHECK(!res.has_value());
+    BOOST_CHECK_EQUAL(resBoost.get(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(case_std_optional_hof)
+{
+    std::size_t someCounter = 0;
+    std::size_t noneCounter = 0;
+
+    const auto res = std::make_optional(std::string("value"))
+        | hof::filter_if([](const std::string& el) { return !el.empty(); })
+        | hof::match([&someCounter](const std::string&) { ++someCounter; }, [&noneCounter]() { ++noneCounter; })
+        | hof::filter_if_not([](const std::string& el) { return el.size() > 1; })
+        | hof::match_none([&noneCounter]() { ++noneCounter; });
+
+    static_assert(std::is_same<std::decay_t<decltype(res)>, std::optional<std::string>>::value, "std::optional stays std::optional");
+    BOOST_CHECK(!res.has_value());
+    BOOST_CHECK_EQUAL(someCounter, 1u);
+    BOOST_CHECK_EQUAL(noneCounter, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(case_std_optional_extractors)
+{
+    const std::optional<int> none;
+
+    const auto orElse = none | [](int el) { return el + 1; } |= []() { return 10; };
+    const auto value = none <<= 5;
+    const auto valueFn = std::make_optional(1) <<= []() { return 5; };
+
+    static_assert(std::is_same<std::decay_t<decltype(orElse)>, std::optional<int>>::value, "std::optional stays std::optional");
+    BOOST_CHECK_EQUAL(*orElse, 10);
+    BOOST_CHECK_EQUAL(value, 5);
+    BOOST_CHECK_EQUAL(valueFn, 1);
+}
+
+BOOST_AUTO_TEST_CASE(case_std_optional_toRefOp)
+{
+    std::optional<std::string> op = std::string("value");
+
+    auto ref = toRefOp(op);
+    ref.get() += "!";
+
+    BOOST_CHECK_EQUAL(ref.get_ptr(), &*op);
+    BOOST_CHECK_EQUAL(*op, "value!");
+}
+
+BOOST_AUTO_TEST_CASE(case_pointers)
+{
+    int value = 1;
+    int* ptr = &value;
+    int* null = nullptr;
+
+    const auto res = ptr | [](int el) { return el + 1; };
+    const auto resNull = null | [](int el) { return el + 1; };
+    const auto filtered = ptr | hof::filter_if([](int el) { return el > 0; });
+    const auto member = ptr | [](int& el) -> int& { return el; };
+
+    static_assert(std::is_same<std::decay_t<decltype(filtered)>, int*>::value, "a pointer stays a pointer");
+    static_assert(std::is_same<std::decay_t<decltype(member)>, int*>::value, "a reference is kept as a pointer");
+    BOOST_CHECK_EQUAL(res.get(), 2);
+    BOOST_CHECK(!resNull.has_value());
+    BOOST_CHECK_EQUAL(filtered, ptr);
+    BOOST_CHECK_EQUAL(member, ptr);
+    // operator<<= with a plain value needs a class operand, so a raw pointer takes a function
+    BOOST_CHECK_EQUAL(null <<= []() { return 7; }, 7);
+    BOOST_CHECK_EQUAL(toRefOp(ptr), ptr);
+}
+
+BOOST_AUTO_TEST_CASE(case_pointer_returned_by_map)
+{
+    // a function which returns a pointer is a map function, not a flat_map one
+    const auto res = boost::make_optional(0) | [](int) { return "text"; };
+
+    static_assert(std::is_same<std::decay_t<decltype(res)>, boost::optional<const char*>>::value, "a pointer is a value");
+    BOOST_CHECK_EQUAL(std::string(res.get()), "text");
+}
+
+BOOST_AUTO_TEST_CASE(case_smart_pointers)
+{
+    auto unique = std::make_unique<std::string>("value");
+    const auto shared = std::make_shared<int>(3);
+
+    const auto size = unique | [](const std::string& el) { return el.size(); };
+    const auto filtered = std::move(unique) | hof::filter_if([](const std::string& el) { return !el.empty(); });
+    const auto sharedValue = shared | hof::match_some([](int) {}) <<= 0;
+
+    static_assert(std::is_same<std::decay_t<decltype(filtered)>, std::unique_ptr<std::string>>::value, "a pointer stays a pointer");
+    BOOST_CHECK_EQUAL(size.get(), 5u);
+    BOOST_REQUIRE(filtered);
+    BOOST_CHECK_EQUAL(*filtered, "value");
+    BOOST_CHECK_EQUAL(sharedValue, 3);
+}
+
+BOOST_AUTO_TEST_CASE(case_user_optional)
+{
+    const my::maybe<int> op(2);
+
+    const auto res = op | [](int el) { return el * 2.0; } | hof::filter_if([](double el) { return el > 1.0; });
+    const auto value = my::maybe<int>() <<= 8;
+
+    static_assert(std::is_same<std::decay_t<decltype(res)>, my::maybe<double>>::value, "a user-defined optional is kept");
+    BOOST_REQUIRE(res.valid);
+    BOOST_CHECK_EQUAL(res.value, 4.0);
+    BOOST_CHECK_EQUAL(value, 8);
+}
+
+BOOST_AUTO_TEST_CASE(case_pipeline)
+{
+    auto p = hof::pipeline([](int el) { return el + 1; }, hof::filter_if([](int el) { return el % 2 == 0; }));
+
+    const auto res = p(std::make_optional(1));
+    const auto resNone = p(std::optional<int>());
+
+    static_assert(std::is_same<std::decay_t<decltype(res)>, std::optional<int>>::value, "a pipeline keeps the kind of the optional");
+    BOOST_CHECK_EQUAL(*res, 2);
+    BOOST_CHECK(!resNone.has_value());
+}
+
+BOOST_AUTO_TEST_CASE(case_trivially_copyable)
+{
+    const auto res = std::make_optional(1) | [](int el) { return el * 0.5; };
+
+    // std::optional of a trivially copyable type stays trivially copyable through the whole chain
+    static_assert(std::is_trivially_copyable<std::decay_t<decltype(res)>>::value, "std::optional<double> is trivially copyable");
+    BOOST_CHECK_EQUAL(*res, 0.5);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
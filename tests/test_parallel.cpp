@@ -0,0 +1,139 @@
+#include <boost/test/unit_test.hpp>
+
+#include <boost/optional.hpp>
+#include <boost/optional_ext.hpp>
+#include <boost/optional_ext/aggregate.hpp>
+#include <boost/optional_ext/async.hpp>
+#include <boost/optional_ext/parallel.hpp>
+#include <boost/optional_ext/parse.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE( parallel )
+
+namespace {
+
+std::vector<std::string> makeTexts(std::size_t size)
+{
+    std::vector<std::string> texts;
+    texts.reserve(size);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        texts.push_back(i % 7 == 0 ? std::string("an error") : std::to_string(i % 100));
+    }
+    return texts;
+}
+
+} // end namespace
+
+BOOST_AUTO_TEST_CASE(case_seq_and_par_are_equal)
+{
+    const auto texts = makeTexts(10000);
+    auto pipeline = hof::pipeline(hof::parse<double>(), hof::filter_if([](double el) { return el < 50.0; })) <<= -1.0;
+
+    std::vector<double> expected(texts.size());
+    std::vector<double> actual(texts.size());
+    const auto end = optional_ext::transform(optional_ext::execution::seq, texts.begin(), texts.end(), expected.begin(), pipeline);
+    BOOST_CHECK(end == expected.end());
+
+    optional_ext::thread_pool pool(3);
+    const auto parEnd = optional_ext::transform(optional_ext::execution::par.on(pool).with_chunk(100), texts.begin(), texts.end(),
+                                                actual.begin(), pipeline);
+    BOOST_CHECK(parEnd == actual.end());
+    BOOST_CHECK(expected == actual);
+    BOOST_CHECK_EQUAL(actual[0], -1.0);
+    BOOST_CHECK_EQUAL(actual[1], 1.0);
+    BOOST_CHECK_EQUAL(actual[60], -1.0);
+
+    // the default executor and the automatic chunk size
+    std::vector<double> byDefault(texts.size());
+    optional_ext::transform(optional_ext::execution::par, texts.begin(), texts.end(), byDefault.begin(), pipeline);
+    BOOST_CHECK(expected == byDefault);
+}
+
+BOOST_AUTO_TEST_CASE(case_optional_elements)
+{
+    std::vector<boost::optional<int>> inputs;
+    for (int i = 0; i < 3000; ++i)
+    {
+        inputs.push_back(i % 3 == 0 ? boost::optional<int>() : boost::make_optional(i));
+    }
+
+    std::vector<boost::optional<int>> outputs(inputs.size());
+    optional_ext::transform(optional_ext::execution::par.with_chunk(64), inputs.begin(), inputs.end(), outputs.begin(),
+                            hof::filter_if([](int el) { return el % 2 == 0; }));
+
+    for (std::size_t i = 0; i < inputs.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(outputs[i].has_value(), i % 3 != 0 && i % 2 == 0);
+    }
+
+    std::vector<std::optional<int>> stdInputs = {1, std::nullopt, 3};
+    std::vector<std::optional<int>> stdOutputs(stdInputs.size());
+    optional_ext::transform(optional_ext::execution::seq, stdInputs.begin(), stdInputs.end(), stdOutputs.begin(),
+                            [](int el) { return el * 2; });
+    BOOST_CHECK(stdOutputs == std::vector<std::optional<int>>({2, std::nullopt, 6}));
+}
+
+BOOST_AUTO_TEST_CASE(case_exception)
+{
+    std::vector<int> inputs(5000, 1);
+    inputs[4321] = -1;
+    std::vector<int> outputs(inputs.size());
+
+    optional_ext::thread_pool pool(2);
+    auto throwing = [](int el) {
+        if (el < 0)
+        {
+            throw std::runtime_error("negative");
+        }
+        return el;
+    };
+    BOOST_CHECK_THROW(optional_ext::transform(optional_ext::execution::par.on(pool).with_chunk(100), inputs.begin(), inputs.end(),
+                                              outputs.begin(), hof::pipeline(throwing) <<= 0),
+                      std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(case_for_each_with_combinable)
+{
+    const auto texts = makeTexts(20000);
+
+    optional_ext::combinable<optional_ext::sum_aggregate<double>> total;
+    optional_ext::combinable<std::uint64_t> errors;
+    optional_ext::thread_pool pool(4);
+    optional_ext::for_each(optional_ext::execution::par.on(pool).with_chunk(256), texts.begin(), texts.end(),
+                           hof::pipeline(hof::parse<double>(), hof::count_none_into(errors), hof::sum_into(total)));
+
+    double expected = 0.0;
+    std::uint64_t expectedErrors = 0;
+    optional_ext::for_each(optional_ext::execution::seq, texts.begin(), texts.end(),
+                           hof::pipeline(hof::parse<double>(), hof::count_none_into(expectedErrors), hof::sum_into(expected)));
+
+    BOOST_CHECK_EQUAL(total.combine().result(), expected);
+    BOOST_CHECK_EQUAL(errors.combine(), expectedErrors);
+    BOOST_CHECK_EQUAL(expectedErrors, 20000u / 7u + 1u);
+}
+
+BOOST_AUTO_TEST_CASE(case_nested_in_a_worker)
+{
+    // the only worker of the pool runs a parallel transform on the same pool, the caller does all chunks itself
+    optional_ext::thread_pool pool(1);
+    std::vector<int> inputs(4096, 2);
+    std::vector<int> outputs(inputs.size());
+
+    auto future = boost::make_optional(0) | hof::async_map([&](int) {
+        optional_ext::transform(optional_ext::execution::par.on(pool).with_chunk(16), inputs.begin(), inputs.end(), outputs.begin(),
+                                hof::pipeline([](int el) { return el * 3; }) <<= 0);
+        return 1;
+    }, pool);
+
+    BOOST_CHECK_EQUAL(std::move(future) <<= 0, 1);
+    BOOST_CHECK(outputs == std::vector<int>(inputs.size(), 6));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,80 @@
+#include <boost/test/unit_test.hpp>
+
+#include <boost/optional.hpp>
+#include <boost/optional_ext.hpp>
+#include <boost/optional_ext/parse.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+BOOST_AUTO_TEST_SUITE( parse )
+
+BOOST_AUTO_TEST_CASE(case_integers)
+{
+    const auto toInt = hof::parse<int>();
+
+    static_assert(std::is_same<decltype(toInt(std::string_view())), boost::optional<int>>::value, "parse returns boost::optional");
+    BOOST_CHECK_EQUAL(toInt("42").get(), 42);
+    BOOST_CHECK_EQUAL(toInt("-42").get(), -42);
+    BOOST_CHECK_EQUAL(toInt("+42").get(), 42);
+    BOOST_CHECK(!toInt("").has_value());
+    BOOST_CHECK(!toInt("+").has_value());
+    BOOST_CHECK(!toInt("+-1").has_value());
+    BOOST_CHECK(!toInt("4x").has_value());
+    BOOST_CHECK(!toInt("an error").has_value());
+    BOOST_CHECK(!toInt("99999999999").has_value());
+    BOOST_CHECK(!hof::parse<std::uint8_t>()("256").has_value());
+    BOOST_CHECK(!hof::parse<unsigned>()("-1").has_value());
+    BOOST_CHECK_EQUAL(hof::parse<int>(optional_ext::parse_flags::strict, 16)("ff").get(), 255);
+}
+
+BOOST_AUTO_TEST_CASE(case_floating_point)
+{
+    const auto toDouble = hof::parse<double>();
+
+    BOOST_CHECK_EQUAL(toDouble("12.5").get(), 12.5);
+    BOOST_CHECK_EQUAL(toDouble("-1e3").get(), -1000.0);
+    BOOST_CHECK_EQUAL(hof::parse<float>()("0.25").get(), 0.25f);
+    BOOST_CHECK(!toDouble("12.5.1").has_value());
+    BOOST_CHECK(!toDouble("1e999").has_value());
+    BOOST_CHECK(!toDouble(" 1").has_value());
+}
+
+BOOST_AUTO_TEST_CASE(case_flags)
+{
+    const auto trim = hof::parse<double>(optional_ext::parse_flags::trim);
+    const auto partial = hof::parse<int>(optional_ext::parse_flags::partial);
+    const auto both = hof::parse<int>(optional_ext::parse_flags::trim | optional_ext::parse_flags::partial);
+
+    BOOST_CHECK_EQUAL(trim(" \t1.5\r\n").get(), 1.5);
+    BOOST_CHECK(!trim("  ").has_value());
+    BOOST_CHECK(!trim("1.5 x").has_value());
+    BOOST_CHECK_EQUAL(partial("12ms").get(), 12);
+    BOOST_CHECK(!partial(" 12ms").has_value());
+    BOOST_CHECK(!partial("ms").has_value());
+    BOOST_CHECK_EQUAL(both(" 12 ms").get(), 12);
+}
+
+BOOST_AUTO_TEST_CASE(case_pipe)
+{
+    const std::string text = "21";
+    const std::string_view view = "x";
+
+    const auto res = toOp(std::string_view(text)) | hof::parse<int>() | [](int el) { return el * 2; } <<= 0;
+    const auto error = toOp(view) | hof::parse<int>() <<= -1;
+    const auto fromString = boost::make_optional(std::string("7")) | hof::parse<long>();
+    const auto fromStd = std::make_optional(std::string("8")) | hof::parse<short>();
+    auto pipeline = hof::pipeline(hof::parse<double>(optional_ext::parse_flags::trim), hof::filter_if([](double el) { return el > 0.0; })) <<= 0.0;
+
+    BOOST_CHECK_EQUAL(res, 42);
+    BOOST_CHECK_EQUAL(error, -1);
+    BOOST_CHECK_EQUAL(fromString.get(), 7);
+    BOOST_CHECK_EQUAL(fromStd.get(), 8);
+    BOOST_CHECK_EQUAL(pipeline(std::string(" 2.5 ")), 2.5);
+    BOOST_CHECK_EQUAL(pipeline(std::string("-2.5")), 0.0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
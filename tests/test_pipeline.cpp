@@ -0,0 +1,122 @@
+#include <boost/test/unit_test.hpp>
+
+#include <boost/optional.hpp>
+#include <boost/optional_ext.hpp>
+#include <boost/optional/optional_io.hpp>
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE( pipeline )
+
+namespace {
+
+boost::optional<int> toInt(const std::string& value)
+{
+    try
+    {
+        return std::stoi(value);
+    }
+    catch (const std::exception&)
+    {
+        return boost::none;
+    }
+}
+
+} // end namespace
+
+BOOST_AUTO_TEST_CASE(case_map_and_flat_map)
+{
+    auto p = hof::pipeline(toInt, [](int el) { return el * 2; });
+
+    const auto some = p(std::string("21"));
+    const auto none = p(std::string("not a number"));
+
+    BOOST_REQUIRE_MESSAGE(some.has_value(), "boost::optional has no value!");
+    BOOST_CHECK_EQUAL(some.get(), 42);
+    BOOST_REQUIRE_MESSAGE(!none.has_value(), "boost::optional has a value!");
+}
+
+BOOST_AUTO_TEST_CASE(case_same_result_as_pipe_operator)
+{
+    auto isPositive = [](int el) { return el > 0; };
+
+    auto p = hof::pipeline(toInt, hof::filter_if(isPositive), [](int el) { return std::to_string(el); });
+
+    for (const std::string data : {"1", "-1", "error", "100"})
+    {
+        const auto expected = boost::make_optional(data) | toInt | hof::filter_if(isPositive) | [](int el) { return std::to_string(el); };
+        BOOST_CHECK_EQUAL(p(boost::make_optional(data)), expected);
+        BOOST_CHECK_EQUAL(boost::make_optional(data) | p, expected);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(case_terminal_value)
+{
+    auto p = hof::pipeline(toInt, hof::filter_if_not([](int el) { return el < 0; })) <<= -1;
+
+    BOOST_CHECK_EQUAL(p(std::string("10")), 10);
+    BOOST_CHECK_EQUAL(p(std::string("-10")), -1);
+    BOOST_CHECK_EQUAL(p(std::string("error")), -1);
+}
+
+BOOST_AUTO_TEST_CASE(case_terminal_function)
+{
+    int calls = 0;
+    auto p = hof::pipeline(toInt) <<= [&calls]() { calls += 1; return 0; };
+
+    BOOST_CHECK_EQUAL(p(std::string("10")), 10);
+    BOOST_CHECK_EQUAL(calls, 0);
+    BOOST_CHECK_EQUAL(p(std::string("error")), 0);
+    BOOST_CHECK_EQUAL(calls, 1);
+}
+
+BOOST_AUTO_TEST_CASE(case_none_handlers_are_called_after_short_circuit)
+{
+    std::vector<int> accepted;
+    int errors = 0;
+    int nones = 0;
+
+    auto p = hof::pipeline(toInt,
+                           hof::match([](int) {}, [&errors]() { errors += 1; }),
+                           hof::filter_if([](int el) { return el >= 0; }),
+                           hof::match_some([&accepted](int el) { accepted.push_back(el); }),
+                           hof::match_none([&nones]() { nones += 1; }))
+             <<= 0;
+
+    int acc = 0;
+    for (const std::string data : {"1", "error", "-5", "2"})
+    {
+        acc += p(data);
+    }
+
+    BOOST_CHECK_EQUAL(acc, 3);
+    BOOST_CHECK_EQUAL(errors, 1);
+    BOOST_CHECK_EQUAL(nones, 2);
+    BOOST_CHECK_EQUAL(accepted.size(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(case_references_are_preserved)
+{
+    auto op = boost::make_optional(std::make_tuple(10, std::string("ten")));
+
+    auto p = hof::pipeline(hof::filter_if([](auto&& el) { return std::get<0>(el) > 0; }));
+
+    const auto res = p(toRefOp(op));
+
+    BOOST_REQUIRE_MESSAGE(res.has_value(), "boost::optional has no value!");
+    BOOST_CHECK_EQUAL(res.get_ptr(), op.get_ptr());
+}
+
+BOOST_AUTO_TEST_CASE(case_custom_hof_stage)
+{
+    auto orZero = optional_detail::createHof([](auto&& op) { return boost::make_optional(op ? op.get() : 0); });
+
+    auto p = hof::pipeline(toInt, orZero, [](int el) { return el + 1; });
+
+    BOOST_CHECK_EQUAL(p(std::string("1")), boost::make_optional(2));
+    BOOST_CHECK_EQUAL(p(std::string("error")), boost::make_optional(1));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
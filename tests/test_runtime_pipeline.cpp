@@ -0,0 +1,125 @@
+#include <boost/test/unit_test.hpp>
+
+#include <boost/optional.hpp>
+#include <boost/optional_ext.hpp>
+#include <boost/optional_ext/aggregate.hpp>
+#include <boost/optional_ext/parse.hpp>
+#include <boost/optional_ext/runtime_pipeline.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE( runtime_pipeline )
+
+BOOST_AUTO_TEST_CASE(case_same_as_compile_time)
+{
+    const auto runtime = optional_ext::compile_pipeline<double>("filter_if(in 0 50) | map(* 2) |= 7 | filter_if_not(== 14) | map(- 1)");
+    BOOST_CHECK_EQUAL(runtime.size(), 5u);
+
+    auto compiled = hof::pipeline(hof::filter_if([](double el) { return el >= 0.0 && el <= 50.0; }),
+                                  [](double el) { return el * 2.0; });
+
+    for (const auto& text : {"1.5", "an error", "-3", "70", "50", "0", "7"})
+    {
+        auto expected = (boost::make_optional(std::string(text)) | hof::parse<double>() | compiled |= []() { return 7.0; })
+            | hof::filter_if_not([](double el) { return el == 14.0; }) | [](double el) { return el - 1.0; };
+
+        BOOST_CHECK(runtime(text) == expected);
+    }
+
+    BOOST_CHECK_EQUAL(runtime(boost::make_optional(10.0)).get(), 19.0);
+    BOOST_CHECK_EQUAL(runtime(100.0).get(), 6.0);
+    BOOST_CHECK(!runtime(7.0));
+}
+
+BOOST_AUTO_TEST_CASE(case_terminal_and_transforms)
+{
+    const auto pipeline = optional_ext::compile_pipeline<double>(R"(
+        # it's read from a config file
+        filter_if(finite)
+        | map(abs) | map(clamp 1 10)   # the range of the sensor
+        | map(min 8) | map(max 2) | map(/ 2) | map(+ -0.5)
+        <<= -1
+    )");
+
+    BOOST_CHECK_EQUAL(pipeline(-20.0).get(), 3.5);
+    BOOST_CHECK_EQUAL(pipeline(1.0).get(), 0.5);
+    BOOST_CHECK_EQUAL(pipeline(std::numeric_limits<double>::infinity()).get(), -1.0);
+    BOOST_CHECK_EQUAL(pipeline("an error").get(), -1.0);
+
+    const auto identity = optional_ext::compile_pipeline<int>("");
+    BOOST_CHECK_EQUAL(identity.size(), 0u);
+    BOOST_CHECK_EQUAL(identity("12").get(), 12);
+
+    const auto fallback = optional_ext::compile_pipeline<int>("|= 5 | filter_if(!= 5) <<= 0");
+    BOOST_CHECK_EQUAL(fallback(boost::optional<int>()).get(), 0);
+    BOOST_CHECK_EQUAL(fallback(3).get(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(case_match_actions)
+{
+    std::vector<int> accepted;
+    int errors = 0;
+
+    optional_ext::runtime_actions<int> actions;
+    actions.some["accept"] = [&accepted](const int& el) { accepted.push_back(el); };
+    actions.some["ignore"] = [](const int&) {};
+    actions.none["error"] = [&errors]() { ++errors; };
+
+    const auto pipeline = optional_ext::compile_pipeline<int>("match(ignore, error) | filter_if(> 0) | match(accept, error)", actions);
+    for (const auto& text : {"1", "x", "-2", "3"})
+    {
+        (void)pipeline(text);
+    }
+
+    BOOST_CHECK(accepted == std::vector<int>({1, 3}));
+    BOOST_CHECK_EQUAL(errors, 3);
+}
+
+BOOST_AUTO_TEST_CASE(case_stage_of_a_chain)
+{
+    double acc = 0.0;
+    std::uint64_t errors = 0;
+    auto filter = hof::runtime(optional_ext::compile_pipeline<double>("filter_if(>= 0) | filter_if(<= 50)"));
+
+    for (const std::string text : {"1.5", "an error", "-3", "70", "2"})
+    {
+        boost::make_optional(text) | hof::parse<double>() | hof::count_none_into(errors) | filter | hof::sum_into(acc);
+    }
+
+    BOOST_CHECK_EQUAL(acc, 3.5);
+    BOOST_CHECK_EQUAL(errors, 1u);
+
+    auto pipeline = hof::pipeline(hof::parse<double>(), filter) <<= 0.0;
+    BOOST_CHECK_EQUAL(pipeline(std::string("7")), 7.0);
+    BOOST_CHECK_EQUAL(pipeline(std::string("-7")), 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(case_errors)
+{
+    auto message = [](const char* description) -> std::string {
+        try
+        {
+            optional_ext::compile_pipeline<int>(description);
+        }
+        catch (const std::invalid_argument& exc)
+        {
+            return exc.what();
+        }
+        return "";
+    };
+
+    BOOST_CHECK_EQUAL(message("filter_if(< 1)"), "");
+    BOOST_CHECK_EQUAL(message("filter(< 1)"), "the pipeline description has an unknown stage 'filter' at 0");
+    BOOST_CHECK_EQUAL(message("filter_if(< x)"), "the pipeline description has a wrong value at 12");
+    BOOST_CHECK_EQUAL(message("filter_if(< 1"), "the pipeline description has a missing ')' at 13");
+    BOOST_CHECK_EQUAL(message("map(/ 0)"), "the pipeline description has a division by zero at 6");
+    BOOST_CHECK_EQUAL(message("map(clamp 5 1)"), "the pipeline description has an empty range at 12");
+    BOOST_CHECK_EQUAL(message("match(a, b)"), "the pipeline description has an unknown action 'a' at 6");
+    BOOST_CHECK_EQUAL(message("<<= 1 | map(+ 1)"), "the pipeline description has an unexpected text at 6");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,105 @@
+#include <boost/test/unit_test.hpp>
+
+#include <boost/optional.hpp>
+#include <boost/optional_ext.hpp>
+#include <boost/optional_ext/parse.hpp>
+
+#include <cstdint>
+#include <string>
+
+// the consumer of the example, the test target has examples/ex_1 in its include directories
+#include "data_service/CShardedConsumer.h"
+
+BOOST_AUTO_TEST_SUITE( sharded_consumer )
+
+namespace {
+
+struct Partial
+{
+    std::uint64_t processed = 0;
+    std::int64_t acc = 0;
+
+    Partial& operator+=(const Partial& other)
+    {
+        processed += other.processed;
+        acc += other.acc;
+        return *this;
+    }
+};
+
+auto makePipeline()
+{
+    return [](services::IDataProvider::DataView data, Partial& partial) {
+        partial.acc += toOp(data) | hof::parse<std::int64_t>() <<= 0;
+        partial.processed += 1;
+    };
+}
+
+using TConsumer = services::CShardedConsumer<Partial, decltype(makePipeline())>;
+
+} // end namespace
+
+BOOST_AUTO_TEST_CASE(case_all_processed)
+{
+    const std::uint64_t messages = 10000;
+    TConsumer consumer(3, makePipeline(), messages);
+    BOOST_CHECK_EQUAL(consumer.shards(), 3u);
+
+    consumer.start();
+    for (std::uint64_t i = 1; i <= messages; ++i)
+    {
+        consumer.dispatch(std::to_string(i));
+    }
+
+    const auto total = consumer.waitUntil([&consumer, messages](const Partial& el) { return el.processed + consumer.droppedCount() >= messages; });
+    consumer.wait();
+
+    // every ring holds all the messages, so nothing is dropped
+    BOOST_CHECK_EQUAL(consumer.droppedCount(), 0u);
+    BOOST_CHECK_EQUAL(total.processed, messages);
+    BOOST_CHECK_EQUAL(consumer.combine().processed, messages);
+    BOOST_CHECK_EQUAL(consumer.combine().acc, static_cast<std::int64_t>(messages * (messages + 1) / 2));
+}
+
+BOOST_AUTO_TEST_CASE(case_dropped_when_rings_are_full)
+{
+    const std::uint64_t messages = 1000;
+    TConsumer consumer(2, makePipeline(), 8);
+
+    // the workers aren't started, so the rings are filled and the rest is dropped
+    for (std::uint64_t i = 0; i < messages; ++i)
+    {
+        consumer.dispatch("1");
+    }
+    BOOST_CHECK_EQUAL(consumer.droppedCount(), messages - 2 * 8);
+
+    consumer.start();
+    const auto total = consumer.waitUntil([&consumer, messages](const Partial& el) { return el.processed + consumer.droppedCount() >= messages; });
+    consumer.wait();
+
+    BOOST_CHECK_EQUAL(total.processed + consumer.droppedCount(), messages);
+    BOOST_CHECK_EQUAL(consumer.combine().processed + consumer.droppedCount(), messages);
+    BOOST_CHECK_EQUAL(consumer.combine().acc, 2 * 8);
+}
+
+BOOST_AUTO_TEST_CASE(case_stop_drains_the_rings)
+{
+    const std::uint64_t messages = 600;
+    TConsumer consumer(4, makePipeline(), 256);
+
+    for (std::uint64_t i = 0; i < messages; ++i)
+    {
+        consumer.dispatch("2");
+    }
+
+    // the workers process everything dispatched before stop()
+    consumer.start();
+    consumer.stop();
+    consumer.wait();
+
+    BOOST_CHECK_EQUAL(consumer.droppedCount(), 0u);
+    BOOST_CHECK_EQUAL(consumer.combine().processed, messages);
+    BOOST_CHECK_EQUAL(consumer.combine().acc, static_cast<std::int64_t>(2 * messages));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,110 @@
+#include <boost/test/unit_test.hpp>
+
+#include <boost/optional.hpp>
+#include <boost/optional_ext.hpp>
+#include <boost/optional_ext/optional_batch.hpp>
+#include <boost/optional_ext/simd_filter.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE( simd_filter )
+
+namespace {
+
+template <typename T>
+std::vector<T> makeValues(std::size_t size)
+{
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> dist(-100, 100);
+
+    std::vector<T> values(size);
+    for (auto& el : values)
+    {
+        el = static_cast<T>(dist(rng));
+    }
+
+    return values;
+}
+
+std::vector<optional_ext::simd_level> supportedLevels()
+{
+    std::vector<optional_ext::simd_level> ret;
+    for (auto level : {optional_ext::simd_level::scalar, optional_ext::simd_level::sse2, optional_ext::simd_level::avx2, optional_ext::simd_level::avx512})
+    {
+        if (level <= optional_ext::active_simd_level())
+        {
+            ret.push_back(level);
+        }
+    }
+
+    return ret;
+}
+
+template <typename T>
+void checkAllLevels(const optional_ext::range_predicate<T>& pred)
+{
+    // the size isn't a multiple of a word and of any vector width
+    const auto values = makeValues<T>(1000 + 37);
+    const std::size_t words = (values.size() + 63) / 64;
+
+    for (auto level : supportedLevels())
+    {
+        std::vector<std::uint64_t> mask(words, ~std::uint64_t(0));
+        mask[3] = 0;
+
+        optional_ext::filter_mask(pred, values.data(), values.size(), mask.data(), level);
+
+        for (std::size_t i = 0; i < values.size(); ++i)
+        {
+            const bool expected = i / 64 != 3 && pred(values[i]);
+            BOOST_CHECK_EQUAL(((mask[i / 64] >> (i % 64)) & 1) != 0, expected);
+        }
+        BOOST_CHECK_EQUAL(mask.back() >> (values.size() % 64), 0u);
+    }
+}
+
+} // end namespace
+
+BOOST_AUTO_TEST_CASE(case_predicate_as_functor)
+{
+    const auto op = boost::make_optional(10.0) | hof::filter_if(optional_ext::between(0.0, 50.0));
+    const auto none = boost::make_optional(60.0) | hof::filter_if(optional_ext::between(0.0, 50.0));
+
+    BOOST_CHECK(op.has_value());
+    BOOST_CHECK(!none.has_value());
+    BOOST_CHECK(optional_ext::less(0.0)(-std::numeric_limits<double>::infinity()));
+    BOOST_CHECK(!optional_ext::greater(0.0)(std::nan("")));
+}
+
+BOOST_AUTO_TEST_CASE(case_kernels_are_equal_to_scalar)
+{
+    checkAllLevels(optional_ext::between(0.0, 50.0));
+    checkAllLevels(optional_ext::greater(-10.0f));
+    checkAllLevels(optional_ext::less_equal(std::int32_t(7)));
+    checkAllLevels(optional_ext::greater_equal(std::int32_t(-3)));
+    checkAllLevels(optional_ext::less(std::int64_t(20)));
+    checkAllLevels(optional_ext::range_predicate<std::int64_t>{-50, 50, false, false});
+    checkAllLevels(optional_ext::range_predicate<short>{-50, 50, true, false});
+}
+
+BOOST_AUTO_TEST_CASE(case_batch_filter)
+{
+    optional_ext::optional_batch<double> batch(makeValues<double>(300));
+    batch.reset(1);
+
+    const auto filtered = batch | hof::filter_if(optional_ext::between(0.0, 50.0));
+    const auto notFiltered = batch | hof::filter_if_not(optional_ext::between(0.0, 50.0));
+
+    for (std::size_t i = 0; i < batch.size(); ++i)
+    {
+        const bool isInRange = batch.values()[i] >= 0.0 && batch.values()[i] <= 50.0;
+        BOOST_CHECK_EQUAL(filtered.has_value(i), i != 1 && isInRange);
+        BOOST_CHECK_EQUAL(notFiltered.has_value(i), i != 1 && !isInRange);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
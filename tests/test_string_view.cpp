@@ -0,0 +1,67 @@
+#include <boost/test/unit_test.hpp>
+
+#include <boost/optional.hpp>
+#include <boost/optional_ext.hpp>
+
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+BOOST_AUTO_TEST_SUITE( string_view )
+
+namespace {
+
+boost::optional<int> toInt(std::string_view value)
+{
+    int ret = 0;
+    for (auto ch : value)
+    {
+        if (ch < '0' || ch > '9')
+        {
+            return boost::none;
+        }
+        ret = ret * 10 + (ch - '0');
+    }
+
+    return value.empty() ? boost::none : boost::make_optional(ret);
+}
+
+} // end namespace
+
+BOOST_AUTO_TEST_CASE(case_to_op)
+{
+    const char buffer[] = "42;x;";
+    const std::string_view first(buffer, 2);
+    const std::string_view second(buffer + 3, 1);
+
+    const auto op = toOp(first);
+    const auto refOp = toRefOp(first);
+
+    static_assert(std::is_same<std::decay_t<decltype(op)>, boost::optional<std::string_view>>::value, "a view is kept by value");
+    static_assert(std::is_same<std::decay_t<decltype(refOp)>, boost::optional<std::string_view>>::value, "a view is kept by value");
+
+    // the view still points into the buffer
+    BOOST_CHECK_EQUAL(static_cast<const void*>(op.get().data()), static_cast<const void*>(buffer));
+    BOOST_CHECK_EQUAL(static_cast<const void*>(refOp.get().data()), static_cast<const void*>(buffer));
+
+    BOOST_CHECK_EQUAL(toOp(first) | toInt <<= -1, 42);
+    BOOST_CHECK_EQUAL(toRefOp(second) | toInt <<= -1, -1);
+}
+
+BOOST_AUTO_TEST_CASE(case_pipeline)
+{
+    auto pipeline = hof::pipeline(toInt, hof::filter_if([](int el) { return el > 10; })) <<= 0;
+    const std::string data = "123";
+
+    BOOST_CHECK_EQUAL(pipeline(std::string_view(data)), 123);
+    BOOST_CHECK_EQUAL(toOp(std::string_view(data).substr(0, 1)) | toInt | hof::filter_if([](int el) { return el > 10; }) <<= 0, 0);
+}
+
+BOOST_AUTO_TEST_CASE(case_wide_view)
+{
+    const std::wstring_view view = L"abc";
+
+    BOOST_CHECK_EQUAL(toOp(view) | [](std::wstring_view el) { return el.size(); } <<= 0u, 3u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,86 @@
+#include <boost/test/unit_test.hpp>
+
+#include <boost/optional.hpp>
+#include <boost/optional_ext.hpp>
+
+// it's built only by the boost_optional_ext_instrumented target which defines OPTIONAL_EXT_TRACING=1
+#if OPTIONAL_EXT_TRACING
+
+#include <sstream>
+#include <string>
+#include <thread>
+
+BOOST_AUTO_TEST_SUITE( tracing )
+
+namespace {
+
+struct TracedStage
+{
+    int operator()(int el) const
+    {
+        return el + 1;
+    }
+};
+
+struct UntracedStage
+{
+    int operator()(int el) const
+    {
+        return el - 1;
+    }
+};
+
+std::string trace()
+{
+    std::ostringstream out;
+    optional_ext::write_trace(out);
+    return out.str();
+}
+
+} // end namespace
+
+BOOST_AUTO_TEST_CASE(case_stages)
+{
+    const auto before = boost::make_optional(1) | UntracedStage() <<= 0;
+
+    optional_ext::start_tracing();
+    const auto res = boost::make_optional(1) | TracedStage() <<= 0;
+    optional_ext::stop_tracing();
+
+    const auto after = boost::make_optional(1) | UntracedStage() <<= 0;
+
+    BOOST_CHECK_EQUAL(before + res + after, 2);
+
+    const auto json = trace();
+    BOOST_CHECK_EQUAL(json.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["), 0u);
+    BOOST_CHECK_NE(json.find("::TracedStage\",\"cat\":\"map\""), std::string::npos);
+    BOOST_CHECK_NE(json.find("\"cat\":\"value_or\""), std::string::npos);
+    BOOST_CHECK_EQUAL(json.find("UntracedStage"), std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(case_scopes_and_flows)
+{
+    optional_ext::start_tracing();
+    {
+        OPTIONAL_EXT_TRACE_SCOPE("produce", "test");
+        OPTIONAL_EXT_TRACE_FLOW_BEGIN("handover", 7);
+    }
+    std::thread consumer([]() {
+        OPTIONAL_EXT_TRACE_THREAD_NAME("a \"quoted\" consumer");
+        OPTIONAL_EXT_TRACE_SCOPE("consume", "test");
+        OPTIONAL_EXT_TRACE_FLOW_END("handover", 7);
+    });
+    consumer.join();
+    optional_ext::stop_tracing();
+
+    const auto json = trace();
+    BOOST_CHECK_NE(json.find("\"name\":\"produce\",\"cat\":\"test\""), std::string::npos);
+    BOOST_CHECK_NE(json.find("\"name\":\"consume\",\"cat\":\"test\""), std::string::npos);
+    BOOST_CHECK_NE(json.find("\"ph\":\"s\",\"name\":\"handover\""), std::string::npos);
+    BOOST_CHECK_NE(json.find("\"id\":7,\"bp\":\"e\""), std::string::npos);
+    BOOST_CHECK_NE(json.find("\"args\":{\"name\":\"a \\\"quoted\\\" consumer\"}"), std::string::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif // OPTIONAL_EXT_TRACING
@@ -0,0 +1,127 @@
+#include <boost/test/unit_test.hpp>
+
+#include <boost/optional.hpp>
+#include <boost/optional_ext.hpp>
+#include <boost/optional_ext/parse.hpp>
+#include <boost/optional_ext/zip.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+
+BOOST_AUTO_TEST_SUITE( zip )
+
+namespace {
+
+struct Order
+{
+    int id;
+    double price;
+    std::string currency;
+};
+
+/**
+ * It lets the producers wait for each other, so they finish only if they run concurrently
+ */
+class CRendezvous
+{
+public:
+    explicit CRendezvous(int count)
+        : m_count(count)
+    {
+    }
+
+    bool arrive()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (--m_count == 0)
+        {
+            m_cv.notify_all();
+            return true;
+        }
+        return m_cv.wait_for(lock, std::chrono::seconds(10), [this]() { return m_count == 0; });
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    int m_count;
+};
+
+} // end namespace
+
+BOOST_AUTO_TEST_CASE(case_zip_and_apply)
+{
+    const boost::optional<int> id(7);
+    std::optional<std::string> currency("EUR");
+
+    auto fields = hof::zip(id, boost::make_optional(2.5), currency);
+    static_assert(std::is_same<decltype(fields), boost::optional<std::tuple<const int&, double, std::string&>>>::value,
+                  "lvalues are referenced, temporaries are moved");
+    BOOST_CHECK_EQUAL(&std::get<0>(*fields), &*id);
+    BOOST_CHECK_EQUAL(&std::get<2>(*fields), &*currency);
+
+    const auto order = fields | hof::apply([](int el, double price, const std::string& code) { return Order{el, price, code}; });
+    BOOST_CHECK_EQUAL(order->id, 7);
+    BOOST_CHECK_EQUAL(order->price, 2.5);
+    BOOST_CHECK_EQUAL(order->currency, "EUR");
+
+    currency.reset();
+    BOOST_CHECK(!hof::zip(id, boost::make_optional(2.5), currency));
+
+    // a function which returns an optional is a flat_map
+    auto ratio = [](int lhs, int rhs) { return rhs != 0 ? boost::make_optional(lhs / rhs) : boost::none; };
+    BOOST_CHECK_EQUAL(hof::zip(boost::make_optional(6), boost::make_optional(3)) | hof::apply(ratio) <<= -1, 2);
+    BOOST_CHECK_EQUAL(hof::zip(boost::make_optional(6), boost::make_optional(0)) | hof::apply(ratio) <<= -1, -1);
+}
+
+BOOST_AUTO_TEST_CASE(case_when_all_short_circuits)
+{
+    auto calls = 0;
+    auto parseId = [&calls]() { ++calls; return hof::parse<int>()("42"); };
+    auto parsePrice = [&calls]() { ++calls; return hof::parse<double>()("x"); };
+    auto currency = [&calls]() { ++calls; return std::string("EUR"); };
+
+    BOOST_CHECK(!hof::when_all(parseId, parsePrice, currency));
+    BOOST_CHECK_EQUAL(calls, 2);
+
+    const auto order = hof::when_all(optional_ext::execution::seq, parseId, []() { return boost::make_optional(1.5); }, currency)
+        | hof::apply([](int id, double price, std::string code) { return Order{id, price, std::move(code)}; });
+    BOOST_CHECK_EQUAL(order->id, 42);
+    BOOST_CHECK_EQUAL(order->currency, "EUR");
+}
+
+BOOST_AUTO_TEST_CASE(case_when_all_concurrent)
+{
+    optional_ext::thread_pool pool(2);
+    CRendezvous rendezvous(3);
+
+    // every producer waits for the other two, the calling thread runs one of them
+    auto producer = [&rendezvous](int value) {
+        return [&rendezvous, value]() { return rendezvous.arrive() ? boost::make_optional(value) : boost::none; };
+    };
+    auto first = producer(1);
+    auto second = producer(2);
+    auto third = producer(3);
+
+    const auto sum = hof::when_all(optional_ext::execution::par.on(pool), first, second, third)
+        | hof::apply([](int lhs, int middle, int rhs) { return lhs + middle + rhs; });
+    BOOST_CHECK_EQUAL(sum.value(), 6);
+
+    std::atomic<int> calls{0};
+    auto none = [&calls]() { ++calls; return boost::optional<int>(); };
+    auto some = [&calls]() { ++calls; return boost::make_optional(1); };
+    BOOST_CHECK(!hof::when_all(optional_ext::execution::par.on(pool), none, some, some));
+    BOOST_CHECK(calls.load() >= 1 && calls.load() <= 3);
+
+    auto failing = []() -> boost::optional<int> { throw std::runtime_error("a producer failed"); };
+    BOOST_CHECK_THROW(hof::when_all(optional_ext::execution::par.on(pool), some, failing), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()